@@ -22,11 +22,26 @@ struct Material {
 	float shininess;
 };
 
+// Set once a frame, see FrameUniforms
+layout (std140, binding = 0) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	vec3 viewPos;
+	DirectionalLight directionalLight;
+};
+
 uniform sampler2DArray texture1;
-uniform DirectionalLight directionalLight;
-uniform vec3 viewPos;
 
 void main() {
+	vec4 textureColour = texture2DArray(texture1, vec3(TexCoord, TextureAtlasIndex));
+
+#ifdef ALPHA_TEST
+	// Cutout blocks like leaves have holes rather than blending, see ChunkRenderer
+	if (textureColour.a < 0.5) {
+		discard;
+	}
+#endif
+
 	// Use a generic material for now.
 	Material material;
 	material.ambient = vec3(1.0f, 1.0f, 1.0f);
@@ -54,5 +69,5 @@ void main() {
 	// Resulting Colour
 	vec3 lightingResult = ambient + diffuse + specular;
 	vec4 result = vec4(lightingResult, 1.0);
-	fColour = texture2DArray(texture1, vec3(TexCoord, TextureAtlasIndex)) * result;
+	fColour = textureColour * result;
 }
\ No newline at end of file
@@ -5,9 +5,32 @@ layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 texCoord;
 layout (location = 3) in int textureAtlasIndex;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// The index of the chunk's draw, see ChunkRenderer
+layout (location = 4) in uint drawIndex;
+
+struct ChunkDrawData {
+	ivec4 origin; // in blocks
+};
+
+layout (std430, binding = 0) readonly buffer ChunkDrawBuffer {
+	ChunkDrawData chunkDraws[];
+};
+
+struct DirectionalLight {
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// Set once a frame, see FrameUniforms
+layout (std140, binding = 0) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	vec3 viewPos;
+	DirectionalLight directionalLight;
+};
 
 out vec2 TexCoord;
 flat out int TextureAtlasIndex;
@@ -15,9 +38,12 @@ out vec3 Normal;
 out vec3 FragPos;
 
 void main() {
-	gl_Position = projection * view * model * vec4(position, 1.0f);
+	// Chunks are never rotated or scaled, so moving to the chunk's origin is the whole model matrix
+	vec3 worldPosition = position + vec3(chunkDraws[drawIndex].origin.xyz);
+
+	gl_Position = projection * view * vec4(worldPosition, 1.0f);
 	TexCoord = texCoord;
 	TextureAtlasIndex = textureAtlasIndex;
 	Normal = normal;
-	FragPos = vec3(model * vec4(position, 1.0));
-}
\ No newline at end of file
+	FragPos = worldPosition;
+}
@@ -0,0 +1,338 @@
+#include "assetPack.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdio.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "fileUtils.h"
+#include "logging.h"
+
+namespace
+{
+	const uint8_t PACK_MAGIC[4] = { 'B', 'P', 'A', 'K' };
+	const size_t HEADER_SIZE = 12;
+	const size_t ASSET_ALIGNMENT = 16;
+
+	void WriteU32(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(static_cast<uint8_t>(value));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 24));
+	}
+
+	void WriteU64(std::vector<uint8_t>& out, uint64_t value)
+	{
+		WriteU32(out, static_cast<uint32_t>(value));
+		WriteU32(out, static_cast<uint32_t>(value >> 32));
+	}
+
+	uint32_t ReadU32(const uint8_t* data)
+	{
+		return static_cast<uint32_t>(data[0]) |
+			(static_cast<uint32_t>(data[1]) << 8) |
+			(static_cast<uint32_t>(data[2]) << 16) |
+			(static_cast<uint32_t>(data[3]) << 24);
+	}
+
+	uint64_t ReadU64(const uint8_t* data)
+	{
+		return ReadU32(data) | (static_cast<uint64_t>(ReadU32(data + 4)) << 32);
+	}
+}
+
+AssetPack* AssetPack::pack_ = nullptr;
+
+AssetPack::AssetPack()
+{
+	mapping_ = nullptr;
+	mappingSize_ = 0;
+#ifdef _WIN32
+	fileHandle_ = INVALID_HANDLE_VALUE;
+	mappingHandle_ = nullptr;
+#endif
+
+	assets_ = std::unordered_map<std::string, AssetView>();
+}
+
+AssetPack::~AssetPack()
+{
+	Close();
+}
+
+bool AssetPack::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	fileHandle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle_ == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle_, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mappingSize_ = static_cast<size_t>(fileSize.QuadPart);
+
+	mappingHandle_ = CreateFileMappingA(fileHandle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	mapping_ = mappingHandle_ ? static_cast<const uint8_t*>(MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file == -1)
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+	mappingSize_ = static_cast<size_t>(fileStat.st_size);
+
+	// The mapping keeps the file alive, so the descriptor isn't needed after this
+	void* mapping = mmap(nullptr, mappingSize_, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	mapping_ = mapping != MAP_FAILED ? static_cast<const uint8_t*>(mapping) : nullptr;
+#endif
+
+	if (!mapping_ || !ReadIndex())
+	{
+		LOG("Couldn't map the asset pack %s\n", path.c_str());
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void AssetPack::Close()
+{
+	assets_.clear();
+
+#ifdef _WIN32
+	if (mapping_)
+	{
+		UnmapViewOfFile(mapping_);
+	}
+	if (mappingHandle_)
+	{
+		CloseHandle(mappingHandle_);
+	}
+	if (fileHandle_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fileHandle_);
+	}
+	mappingHandle_ = nullptr;
+	fileHandle_ = INVALID_HANDLE_VALUE;
+#else
+	if (mapping_)
+	{
+		munmap(const_cast<uint8_t*>(mapping_), mappingSize_);
+	}
+#endif
+
+	mapping_ = nullptr;
+	mappingSize_ = 0;
+}
+
+bool AssetPack::ReadIndex()
+{
+	if (mappingSize_ < HEADER_SIZE || !std::equal(PACK_MAGIC, PACK_MAGIC + 4, mapping_) || ReadU32(mapping_ + 4) != VERSION)
+	{
+		return false;
+	}
+
+	uint32_t numAssets = ReadU32(mapping_ + 8);
+	size_t position = HEADER_SIZE;
+	for (uint32_t i = 0; i < numAssets; i++)
+	{
+		if (mappingSize_ - position < 20)
+		{
+			return false;
+		}
+
+		uint64_t offset = ReadU64(mapping_ + position);
+		uint64_t size = ReadU64(mapping_ + position + 8);
+		uint32_t nameSize = ReadU32(mapping_ + position + 16);
+		position += 20;
+
+		// The asset's 0 has to be inside the pack too
+		if (mappingSize_ - position < nameSize || offset > mappingSize_ || size >= mappingSize_ - offset || mapping_[offset + size] != 0)
+		{
+			return false;
+		}
+
+		std::string name = std::string(reinterpret_cast<const char*>(mapping_ + position), nameSize);
+		position += nameSize;
+
+		assets_[name] = { mapping_ + offset, static_cast<size_t>(size) };
+	}
+
+	return true;
+}
+
+bool AssetPack::Find(const std::string& name, AssetView& viewOut) const
+{
+	auto it = assets_.find(name);
+	if (it == assets_.end())
+	{
+		return false;
+	}
+
+	viewOut = it->second;
+	return true;
+}
+
+int AssetPack::GetNumAssets() const
+{
+	return assets_.size();
+}
+
+AssetPack* AssetPack::Get()
+{
+	return pack_;
+}
+
+void AssetPack::Set(AssetPack* pack)
+{
+	pack_ = pack;
+}
+
+std::string AssetPack::GetAssetName(const std::string& path)
+{
+	if (path.compare(0, 2, "./") == 0)
+	{
+		return path.substr(2);
+	}
+
+	return path;
+}
+
+bool AssetPack::ReadAsset(const std::string& path, AssetView& viewOut, std::vector<uint8_t>& storage)
+{
+	if (pack_ && pack_->Find(GetAssetName(path), viewOut))
+	{
+		return true;
+	}
+
+	if (!FileUtils::ReadFile(path, storage))
+	{
+		return false;
+	}
+
+	// Followed by a 0, same as the packed assets
+	storage.push_back(0);
+	viewOut = { storage.data(), storage.size() - 1 };
+	return true;
+}
+
+bool AssetPack::Build(const std::string& directory, const std::string& packPath)
+{
+	std::error_code error;
+	std::filesystem::path root = std::filesystem::path(directory);
+	std::filesystem::path prefix = root.filename();
+
+	std::vector<std::filesystem::path> files = std::vector<std::filesystem::path>();
+	for (auto it = std::filesystem::recursive_directory_iterator(root, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+	{
+		// Skips temporary files left by WriteFileDurably
+		if (it->is_regular_file() && it->path().extension() != ".tmp")
+		{
+			files.push_back(it->path());
+		}
+	}
+
+	if (error)
+	{
+		printf("Couldn't list %s: %s\n", directory.c_str(), error.message().c_str());
+		return false;
+	}
+
+	// Same pack from the same files, whatever order the OS lists them in
+	std::sort(files.begin(), files.end());
+
+	std::vector<std::string> names = std::vector<std::string>();
+	std::vector<std::vector<uint8_t>> contents = std::vector<std::vector<uint8_t>>(files.size());
+	size_t indexSize = 0;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (!FileUtils::ReadFile(files[i].string(), contents[i]))
+		{
+			printf("Couldn't read %s\n", files[i].string().c_str());
+			return false;
+		}
+
+		names.push_back((prefix / files[i].lexically_relative(root)).generic_string());
+		indexSize += 20 + names[i].size();
+	}
+
+	// Lay out the assets after the index, then write the index
+	std::vector<uint8_t> pack = std::vector<uint8_t>();
+	pack.insert(pack.end(), PACK_MAGIC, PACK_MAGIC + 4);
+	WriteU32(pack, VERSION);
+	WriteU32(pack, static_cast<uint32_t>(files.size()));
+
+	size_t offset = HEADER_SIZE + indexSize;
+	std::vector<size_t> offsets = std::vector<size_t>();
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		offset = (offset + ASSET_ALIGNMENT - 1) / ASSET_ALIGNMENT * ASSET_ALIGNMENT;
+		offsets.push_back(offset);
+		offset += contents[i].size() + 1;
+
+		WriteU64(pack, offsets[i]);
+		WriteU64(pack, contents[i].size());
+		WriteU32(pack, static_cast<uint32_t>(names[i].size()));
+		pack.insert(pack.end(), names[i].begin(), names[i].end());
+	}
+
+	size_t numAssetBytes = 0;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		pack.resize(offsets[i], 0);
+		pack.insert(pack.end(), contents[i].begin(), contents[i].end());
+		pack.push_back(0);
+		numAssetBytes += contents[i].size();
+	}
+
+	if (!FileUtils::WriteFileDurably(packPath, pack))
+	{
+		printf("Couldn't write %s\n", packPath.c_str());
+		return false;
+	}
+
+	// Make sure the game will be able to open it
+	AssetPack builtPack;
+	if (!builtPack.Open(packPath) || builtPack.GetNumAssets() != static_cast<int>(files.size()))
+	{
+		printf("Couldn't open %s after writing it\n", packPath.c_str());
+		return false;
+	}
+
+	printf("Packed %zu assets (%zu bytes) from %s into %s (%zu bytes)\n",
+		files.size(), numAssetBytes, directory.c_str(), packPath.c_str(), pack.size());
+	for (const std::string& name : names)
+	{
+		printf("  %s\n", name.c_str());
+	}
+
+	return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bytes of an asset, followed by a 0 so text assets can be used as C strings
+struct AssetView
+{
+	const uint8_t* data;
+	size_t size; // not counting the 0
+};
+
+/*
+ * Every file in the Assets folder packed into one file with an index
+ * in front, which is memory mapped rather than read. Finding an asset
+ * hands out a view straight into the mapping, so nothing is copied
+ * until something actually needs its own copy.
+ *
+ * The pack is built by --build-asset-pack. Assets are named by their
+ * path without the leading "./", i.e. "Assets/mesh.vert", so ReadAsset
+ * can take the same paths the loose files are opened with and falls
+ * back to them when there's no pack or the asset isn't in it.
+ *
+ * Pack layout :-
+ *   magic ("BPAK"), version (u32), num. assets (u32),
+ *   per asset: offset (u64), size (u64), name size (u32), name,
+ *   the assets, each 16 byte aligned and followed by a 0
+ */
+class AssetPack
+{
+	static AssetPack* pack_;
+
+	const uint8_t* mapping_;
+	size_t mappingSize_;
+#ifdef _WIN32
+	void* fileHandle_;
+	void* mappingHandle_;
+#endif
+
+	std::unordered_map<std::string, AssetView> assets_;
+protected:
+	// Checks every asset in the index lies inside the mapping
+	bool ReadIndex();
+public:
+	static const uint32_t VERSION = 1;
+
+	AssetPack();
+	~AssetPack();
+
+	// It owns the mapping
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	// Returns false if the pack is missing or its index is corrupt
+	bool Open(const std::string& path);
+	void Close();
+
+	bool Find(const std::string& name, AssetView& viewOut) const;
+	int GetNumAssets() const;
+
+	// The pack ReadAsset looks in, none by default
+	static AssetPack* Get();
+	static void Set(AssetPack* pack);
+
+	// i.e. "./Assets/mesh.vert" is "Assets/mesh.vert"
+	static std::string GetAssetName(const std::string& path);
+
+	/*
+	 * Finds the asset in the pack, or reads the loose file into storage
+	 * if it isn't packed. The view is only valid while the pack is open
+	 * and storage is alive.
+	 */
+	static bool ReadAsset(const std::string& path, AssetView& viewOut, std::vector<uint8_t>& storage);
+
+	/*
+	 * Packs every file in the directory (and the ones below it) into a
+	 * pack at the path, then prints how many files and bytes it holds.
+	 */
+	static bool Build(const std::string& directory, const std::string& packPath);
+};
@@ -0,0 +1,162 @@
+#include "autosave.h"
+
+#include "chunk.h"
+#include "logging.h"
+
+#include <GLFW/glfw3.h>
+
+Autosave::Autosave(ChunkStore* chunkStore, double interval, std::function<size_t(ChunkKey)> getNumEdits, std::function<void(const std::vector<SavedChunk>&)> onSaved)
+{
+	chunkStore_ = chunkStore;
+	interval_ = interval;
+	lastSaveTime_ = glfwGetTime();
+	isSaveRequested_ = false;
+	getNumEdits_ = std::move(getNumEdits);
+	onSaved_ = std::move(onSaved);
+
+	queue_ = std::vector<ChunkSnapshot>();
+	failedChunks_ = std::unordered_set<ChunkKey, ChunkKeyHash>();
+	isSaving_ = false;
+	shouldStop_ = false;
+	stats_ = AutosaveStats{};
+
+	saveThread_ = std::thread(&Autosave::RunSaveThread, this);
+}
+
+Autosave::~Autosave()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex_);
+		shouldStop_ = true;
+	}
+	queueCondition_.notify_all();
+
+	// Finishes writing any snapshots that were already taken
+	saveThread_.join();
+}
+
+void Autosave::Update(const std::vector<Chunk*>& chunks)
+{
+	double currentTime = glfwGetTime();
+	if (currentTime - lastSaveTime_ < interval_ && !isSaveRequested_)
+	{
+		return;
+	}
+
+	std::unordered_set<ChunkKey, ChunkKeyHash> failedChunks = std::unordered_set<ChunkKey, ChunkKeyHash>();
+	{
+		std::lock_guard<std::mutex> lock(queueMutex_);
+		if (isSaving_ || !queue_.empty())
+		{
+			return;
+		}
+		failedChunks.swap(failedChunks_);
+	}
+
+	lastSaveTime_ = currentTime;
+	isSaveRequested_ = false;
+
+	double pauseStartTime = glfwGetTime();
+
+	std::vector<ChunkSnapshot> snapshots = std::vector<ChunkSnapshot>();
+	for (Chunk* chunk : chunks)
+	{
+		if (!chunk->IsUnloaded() && (chunk->HasUnsavedChanges() || failedChunks.count(chunk->GetKey()) > 0))
+		{
+			ChunkKey chunkKey = chunk->GetKey();
+			snapshots.push_back({ chunkKey, chunk->GetBlocksSnapshot(), getNumEdits_(chunkKey) });
+			chunk->SetHasUnsavedChanges(false);
+		}
+	}
+
+	if (!snapshots.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex_);
+			queue_.swap(snapshots);
+		}
+		queueCondition_.notify_one();
+	}
+
+	double pause = glfwGetTime() - pauseStartTime;
+
+	std::lock_guard<std::mutex> lock(statsMutex_);
+	stats_.lastPause = pause;
+	if (pause > stats_.longestPause)
+	{
+		stats_.longestPause = pause;
+	}
+}
+
+void Autosave::RunSaveThread()
+{
+	std::unique_lock<std::mutex> lock(queueMutex_);
+
+	while (true)
+	{
+		queueCondition_.wait(lock, [this]() { return shouldStop_ || !queue_.empty(); });
+
+		if (queue_.empty())
+		{
+			break;
+		}
+
+		std::vector<ChunkSnapshot> snapshots = std::vector<ChunkSnapshot>();
+		snapshots.swap(queue_);
+		isSaving_ = true;
+		lock.unlock();
+
+		std::vector<SavedChunk> savedChunks = std::vector<SavedChunk>();
+		std::vector<ChunkKey> failedChunks = std::vector<ChunkKey>();
+		uint64_t bytesWritten = 0;
+		uint64_t numChunksWritten = 0;
+		for (const ChunkSnapshot& snapshot : snapshots)
+		{
+			size_t chunkBytesWritten = 0;
+			if (chunkStore_->Save(snapshot.chunkKey, snapshot.blocks.GetBlockData(), &chunkBytesWritten))
+			{
+				savedChunks.push_back({ snapshot.chunkKey, snapshot.numEdits });
+				bytesWritten += chunkBytesWritten;
+				numChunksWritten++;
+			}
+			else
+			{
+				LOG("Couldn't autosave chunk (%d, %d, %d)\n", snapshot.chunkKey.x, snapshot.chunkKey.y, snapshot.chunkKey.z);
+				failedChunks.push_back(snapshot.chunkKey);
+			}
+		}
+
+		// Drop the snapshots so their pages stop being shared
+		snapshots.clear();
+
+		if (!savedChunks.empty())
+		{
+			onSaved_(savedChunks);
+		}
+
+		{
+			std::lock_guard<std::mutex> statsLock(statsMutex_);
+			stats_.numSaves++;
+			stats_.numChunksWritten += numChunksWritten;
+			stats_.bytesWritten += bytesWritten;
+		}
+
+		// The pauses are in the stats, see GetStats
+		LOG("Autosaved %llu chunks (%llu bytes)\n", (unsigned long long)numChunksWritten, (unsigned long long)bytesWritten);
+
+		lock.lock();
+		failedChunks_.insert(failedChunks.begin(), failedChunks.end());
+		isSaving_ = false;
+	}
+}
+
+void Autosave::RequestSave()
+{
+	isSaveRequested_ = true;
+}
+
+AutosaveStats Autosave::GetStats()
+{
+	std::lock_guard<std::mutex> lock(statsMutex_);
+	return stats_;
+}
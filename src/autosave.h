@@ -0,0 +1,94 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "chunkBlocks.h"
+#include "chunkStore.h"
+
+class Chunk;
+
+struct ChunkSnapshot
+{
+	ChunkKey chunkKey;
+	ChunkBlocks blocks;
+	size_t numEdits; // of the chunk's journal edits, how many the blocks include
+};
+
+// A chunk an autosave wrote, and so the journal edits that no longer need keeping
+struct SavedChunk
+{
+	ChunkKey chunkKey;
+	size_t numEdits;
+};
+
+struct AutosaveStats
+{
+	uint64_t numSaves;
+	uint64_t numChunksWritten;
+	uint64_t bytesWritten;
+
+	// How long taking the snapshots held up the main thread (seconds)
+	double lastPause;
+	double longestPause;
+};
+
+/*
+ * Periodically saves the chunks that have been edited, without
+ * stalling the frame.
+ *
+ * At a frame boundary the main thread takes a copy-on-write snapshot of
+ * each edited chunk's blocks, which only copies page pointers. The snapshots
+ * are encoded and written on the autosave thread while the game carries on
+ * editing the live chunks, any page edited in the meantime is copied then.
+ *
+ * Each snapshot remembers how many of its chunk's journal edits it has
+ * (from getNumEdits), and after a save the chunks that were written are
+ * handed to onSaved on the autosave thread, so the journal can be
+ * compacted without the main thread waiting on the disk.
+ */
+class Autosave
+{
+	ChunkStore* chunkStore_;
+	double interval_;
+	double lastSaveTime_;
+	bool isSaveRequested_;
+
+	std::function<size_t(ChunkKey)> getNumEdits_;
+	std::function<void(const std::vector<SavedChunk>&)> onSaved_;
+
+	std::vector<ChunkSnapshot> queue_;
+
+	// Chunks the save thread couldn't write, the next save tries them again
+	std::unordered_set<ChunkKey, ChunkKeyHash> failedChunks_;
+	bool isSaving_;
+	bool shouldStop_;
+	std::mutex queueMutex_;
+	std::condition_variable queueCondition_;
+
+	std::thread saveThread_;
+
+	AutosaveStats stats_;
+	std::mutex statsMutex_;
+
+	void RunSaveThread();
+public:
+	Autosave(ChunkStore* chunkStore, double interval, std::function<size_t(ChunkKey)> getNumEdits, std::function<void(const std::vector<SavedChunk>&)> onSaved);
+	~Autosave();
+
+	/*
+	 * Call once per frame on the main thread. Once the interval has passed,
+	 * and the last save has finished, snapshots every chunk with unsaved changes,
+	 * including any the last save failed to write.
+	 */
+	void Update(const std::vector<Chunk*>& chunks);
+
+	// Saves at the next Update without waiting for the interval. Main thread only.
+	void RequestSave();
+
+	AutosaveStats GetStats();
+};
@@ -1,5 +1,6 @@
 #include "chunk.h"
 
+#include <cassert>
 #include <GLFW/glfw3.h>
 
 #include "logging.h"
@@ -8,101 +9,150 @@
 
 #include "world.h"
 
-Chunk::Chunk(World* world, Biome biome, Texture2DArray texture, std::vector<float> chunkSectionNoise, int minY, int maxY, glm::vec3 startingPosition, int size, int seed)
+Chunk::Chunk(World* world, Texture2DArray texture, glm::vec3 startingPosition, int size, int seed)
 	: Entity()
 {
 	needsUpdated = false;
-	shouldDraw_ = true;
 	world_ = world;
 	texture_ = texture;
 
 	size_.store(size);
-	blocks_ = std::vector<std::vector<std::vector<uint8_t>>>();
 	seed_.store(seed);
-	isUnloaded.store(false);
-	biome_ = biome;
+
+	// Nothing is drawn until a ChunkResult has been applied
+	isUnloaded.store(true);
+	version_ = 0;
+
+	ChunkState* state = new ChunkState();
+	state->position = startingPosition;
+	state->biome = Biome::Grassland;
+	state->blocks = ChunkBlocks();
+	state->occluders = std::vector<OccluderBox>();
+	state->faceConnections = ChunkFaceConnections::All();
+	state_.store(nullptr);
+	PublishState(state);
 
 	AddComponent("transform", new TransformComponent(this, startingPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
 	transformComponent = static_cast<TransformComponent*>(GetComponentByName("transform"));
+	origin_ = glm::ivec3(glm::round(startingPosition));
 
 	treeTrunkPositions_ = std::vector<glm::vec3>(size * size * size);
 	treeLeavePositions_ = std::vector<glm::vec3>(size * size * size);
 
-	UseNoise(chunkSectionNoise, minY, maxY);
-	UpdateBlocks();
-
-	AddComponent("mesh", new MeshComponent(this, new Mesh(&texture_, MeshType::Chunk)));
+	// Drawn by the world's ChunkRenderer along with every other chunk
+	AddComponent("mesh", new MeshComponent(this, new Mesh(&texture_, MeshType::Chunk, world_->GetChunkRenderer()->GetArena())));
 	meshComponent = static_cast<MeshComponent*>(GetComponentByName("mesh"));
-	TextureAtlas textureAtlas = { 8, 6 };
+}
+
+void Chunk::GenerateMesh()
+{
+	Mesh* mesh = meshComponent->GetMesh();
+
+	std::vector<Vertex> vertices = std::vector<Vertex>();
+	std::vector<unsigned int> indices = std::vector<unsigned int>();
+	PassIndexCounts passIndexCounts = PassIndexCounts();
+	{
+		EpochGuard guard = EpochGuard(world_->GetEpochReclaimer());
+		GenerateMeshData(GetState()->blocks, texture_.GetNumCols(), vertices, indices, passIndexCounts);
+	}
+
+	mesh->SetVertices(std::move(vertices));
+	mesh->SetIndices(std::move(indices));
+	mesh->SetPassIndexCounts(passIndexCounts);
 
-	GenerateMesh();
 }
 
-void Chunk::GenerateMesh(bool isOnMainThread)
+RenderPass Chunk::GetBlockRenderPass(uint8_t blockType)
+{
+	switch (blockType)
+	{
+	case BLOCK_TYPE_TREELEAVES:
+		return RenderPass::Cutout;
+	default:
+		return RenderPass::Opaque;
+	}
+}
+
+bool Chunk::IsFaceVisible(uint8_t blockType, uint8_t adjacentBlockType)
+{
+	if (adjacentBlockType == BLOCK_TYPE_AIR)
+	{
+		return true;
+	}
+
+	// Blocks can be seen through ones that aren't opaque, apart from the faces between two of the same type
+	return GetBlockRenderPass(adjacentBlockType) != RenderPass::Opaque && adjacentBlockType != blockType;
+}
+
+void Chunk::GenerateMeshData(const ChunkBlocks& blocks, int numTextureCols, std::vector<Vertex>& verticesOut, std::vector<unsigned int>& indicesOut, PassIndexCounts& passIndexCountsOut)
 {
 	SubTexture textureAtlasSubTexture = GetSubTextureFromTextureAtlas(0, 0, { 1, 1 });
 
-	Mesh* mesh = meshComponent->GetMesh();
+	int size = blocks.GetSize();
 
-	float meshStartX = -1.0f * (size_.load() / 2.0f);
-	float meshStartY = -1.0f * (size_.load() / 2.0f);
-	float meshStartZ = -1.0f * (size_.load() / 2.0f);
+	float meshStartX = -1.0f * (size / 2.0f);
+	float meshStartY = -1.0f * (size / 2.0f);
+	float meshStartZ = -1.0f * (size / 2.0f);
 
 	int numBlocksRendered = 0;
 
-	// We want to declare this inside the function because
-	// chunks can be called on other threads, therefore
-	// it's better just to replace the vertices and indices
-	// on the mesh rather than pass them between classes etc.
-	std::vector<Vertex> vertices = std::vector<Vertex>(blocks_.size() * 4 * 6);
-	std::vector<unsigned int> indices = std::vector<unsigned int>(blocks_.size() * 6 * 6);
+	// This only reads the blocks that are passed in, so it can run on any
+	// thread, the caller decides when the mesh is swapped in.
+	std::vector<Vertex>& vertices = verticesOut;
+	vertices = std::vector<Vertex>(blocks.GetSize() * 4 * 6);
+
+	// Each pass's indices are kept apart, then joined in pass order so each pass is one range
+	std::vector<unsigned int> passIndices[NUM_RENDER_PASSES];
+	passIndices[static_cast<int>(RenderPass::Opaque)] = std::vector<unsigned int>(blocks.GetSize() * 6 * 6);
 
-	for (int z = 0; z < size_.load(); z++)
+	for (int z = 0; z < size; z++)
 	{
-		for (int x = 0; x < size_.load(); x++)
+		for (int x = 0; x < size; x++)
 		{
-			for (int y = 0; y < size_.load(); y++)
+			for (int y = 0; y < size; y++)
 			{
-				uint8_t currentBlock = blocks_[z][x][y];
+				uint8_t currentBlock = blocks.Get(x, y, z);
 
 				// Only add to mesh if the block can be rendered
 				if (currentBlock != BLOCK_TYPE_AIR) {
 					numBlocksRendered++;
 
+					std::vector<unsigned int>& indices = passIndices[static_cast<int>(GetBlockRenderPass(currentBlock))];
+
 					// Get the adjacent blocks
 					uint8_t adjacentBlockUp = BLOCK_TYPE_AIR;
-					if (IsInChunk(x, y + 1, z)) {
-						adjacentBlockUp = blocks_[z][x][y + 1];
+					if (IsInChunk(blocks, x, y + 1, z)) {
+						adjacentBlockUp = blocks.Get(x, y + 1, z);
 					}
 
 					uint8_t adjacentBlockDown = BLOCK_TYPE_AIR;
-					if (IsInChunk(x, y - 1, z))
+					if (IsInChunk(blocks, x, y - 1, z))
 					{
-						adjacentBlockDown = blocks_[z][x][y-1];
+						adjacentBlockDown = blocks.Get(x, y - 1, z);
 					}
 
 					uint8_t adjacentBlockRight = BLOCK_TYPE_AIR;
-					if (IsInChunk(x + 1, y, z))
+					if (IsInChunk(blocks, x + 1, y, z))
 					{
-						adjacentBlockRight = blocks_[z][x+1][y];
+						adjacentBlockRight = blocks.Get(x + 1, y, z);
 					}
 
 					uint8_t adjacentBlockLeft = BLOCK_TYPE_AIR;
-					if (IsInChunk(x - 1, y, z))
+					if (IsInChunk(blocks, x - 1, y, z))
 					{
-						adjacentBlockLeft = blocks_[z][x-1][y];
+						adjacentBlockLeft = blocks.Get(x - 1, y, z);
 					}
 
 					uint8_t adjacentBlockFront = BLOCK_TYPE_AIR;
-					if (IsInChunk(x, y, z + 1))
+					if (IsInChunk(blocks, x, y, z + 1))
 					{
-						adjacentBlockFront = blocks_[z + 1][x][y];
+						adjacentBlockFront = blocks.Get(x, y, z + 1);
 					}
 
 					uint8_t adjacentBlockBack = BLOCK_TYPE_AIR;
-					if (IsInChunk(x, y, z - 1))
+					if (IsInChunk(blocks, x, y, z - 1))
 					{
-						adjacentBlockBack = blocks_[z - 1][x][y];
+						adjacentBlockBack = blocks.Get(x, y, z - 1);
 					}
 
 					// The bottom-left corner of the current block in the mesh
@@ -112,10 +162,10 @@ void Chunk::GenerateMesh(bool isOnMainThread)
 
 					int currentRow = currentBlock-1;
 
-					// Add each block face that faces an air block
-					if (adjacentBlockUp == BLOCK_TYPE_AIR)
+					// Add each block face that can be seen
+					if (IsFaceVisible(currentBlock, adjacentBlockUp))
 					{
-						int textureAtlasIndex = currentRow * texture_.GetNumCols() + 0;
+						int textureAtlasIndex = currentRow * numTextureCols + 0;
 
 						vertices.push_back({ meshX,		meshY + 1,	meshZ, 0.0f, 1.0f, 0.0f, textureAtlasSubTexture.startS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Left
 						vertices.push_back({ meshX + 1,	meshY + 1,	meshZ, 0.0f, 1.0f, 0.0f, textureAtlasSubTexture.endS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Right
@@ -136,9 +186,9 @@ void Chunk::GenerateMesh(bool isOnMainThread)
 						);
 					}
 
-					if (adjacentBlockDown == BLOCK_TYPE_AIR)
+					if (IsFaceVisible(currentBlock, adjacentBlockDown))
 					{
-						int textureAtlasIndex = currentRow * texture_.GetNumCols() + 1;
+						int textureAtlasIndex = currentRow * numTextureCols + 1;
 
 						vertices.push_back({ meshX,		meshY,		meshZ, 0.0f, -1.0f, 0.0f, textureAtlasSubTexture.startS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Left
 						vertices.push_back({ meshX + 1,	meshY,		meshZ, 0.0f, -1.0f, 0.0f, textureAtlasSubTexture.endS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Right
@@ -159,9 +209,9 @@ void Chunk::GenerateMesh(bool isOnMainThread)
 						);
 					}
 
-					if (adjacentBlockRight == BLOCK_TYPE_AIR)
+					if (IsFaceVisible(currentBlock, adjacentBlockRight))
 					{
-						int textureAtlasIndex = currentRow * texture_.GetNumCols() + 2;
+						int textureAtlasIndex = currentRow * numTextureCols + 2;
 
 						vertices.push_back({ meshX + 1,	meshY,		meshZ, 1.0f, 0.0f, 0.0f, textureAtlasSubTexture.startS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Left
 						vertices.push_back({ meshX + 1,	meshY,		meshZ - 1, 1.0f, 0.0f, 0.0f, textureAtlasSubTexture.endS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Right
@@ -182,9 +232,9 @@ void Chunk::GenerateMesh(bool isOnMainThread)
 						);
 					}
 
-					if (adjacentBlockLeft == BLOCK_TYPE_AIR)
+					if (IsFaceVisible(currentBlock, adjacentBlockLeft))
 					{
-						int textureAtlasIndex = currentRow * texture_.GetNumCols() + 3;
+						int textureAtlasIndex = currentRow * numTextureCols + 3;
 
 						vertices.push_back({ meshX,		meshY,		meshZ, -1.0f, 0.0f, 0.0f, textureAtlasSubTexture.startS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Left
 						vertices.push_back({ meshX,		meshY,		meshZ - 1, -1.0f, 0.0f, 0.0f, textureAtlasSubTexture.endS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Right
@@ -205,9 +255,9 @@ void Chunk::GenerateMesh(bool isOnMainThread)
 						);
 					}
 
-					if (adjacentBlockFront == BLOCK_TYPE_AIR)
+					if (IsFaceVisible(currentBlock, adjacentBlockFront))
 					{
-						int textureAtlasIndex = currentRow * texture_.GetNumCols() + 4;
+						int textureAtlasIndex = currentRow * numTextureCols + 4;
 
 						vertices.push_back({ meshX,		meshY,		meshZ, 0.0f, 0.0f, 1.0f, textureAtlasSubTexture.startS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Left
 						vertices.push_back({ meshX + 1,	meshY,		meshZ, 0.0f, 0.0f, 1.0f, textureAtlasSubTexture.endS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Right
@@ -228,9 +278,9 @@ void Chunk::GenerateMesh(bool isOnMainThread)
 						);
 					}
 
-					if (adjacentBlockBack == BLOCK_TYPE_AIR)
+					if (IsFaceVisible(currentBlock, adjacentBlockBack))
 					{
-						int textureAtlasIndex = currentRow * texture_.GetNumCols() + 5;
+						int textureAtlasIndex = currentRow * numTextureCols + 5;
 
 						vertices.push_back({ meshX,		meshY,		meshZ - 1, 0.0f, 0.0f, -1.0f, textureAtlasSubTexture.startS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Left
 						vertices.push_back({ meshX + 1,	meshY,		meshZ - 1, 0.0f, 0.0f, -1.0f, textureAtlasSubTexture.endS, textureAtlasSubTexture.startT, textureAtlasIndex }); // Bottom-Right
@@ -255,42 +305,30 @@ void Chunk::GenerateMesh(bool isOnMainThread)
 		}
 	}
 
-	mesh->SetVertices(vertices);
-	mesh->SetIndices(indices);
-
-	if (isOnMainThread) {
-		meshComponent->SetModel(transformComponent->GetModel());
+	indicesOut.clear();
+	for (int pass = 0; pass < NUM_RENDER_PASSES; pass++)
+	{
+		indicesOut.insert(indicesOut.end(), passIndices[pass].begin(), passIndices[pass].end());
+		passIndexCountsOut[pass] = static_cast<uint32_t>(passIndices[pass].size());
 	}
 }
 
-bool Chunk::IsInChunk(int x, int y, int z)
+bool Chunk::IsInChunk(const ChunkBlocks& blocks, int x, int y, int z)
 {
 	// Ensure the chunk actually has blocks in it.
-	if (blocks_.empty())
+	if (blocks.IsEmpty())
 	{
 		LOG("There are no blocks in the chunk: (%d, %d, %d)\n", x, y ,z);
 		return false;
 	}
 
-	if (blocks_[0].empty())
-	{
-		LOG("There are no blocks in the chunk: (%d, %d, %d)\n", x, y, z);
-		return false;
-	}
-
-	if (blocks_[0][0].empty())
-	{
-		LOG("There are no blocks in the chunk: (%d, %d, %d)\n", x, y, z);
-		return false;
-	}
-
 	// Define what constitutes being inside the chunk.
 	int minZ = 0;
-	int maxZ = blocks_.size()-1;
+	int maxZ = blocks.GetSize() - 1;
 	int minX = 0;
-	int maxX = blocks_[0].size()-1;
+	int maxX = blocks.GetSize() - 1;
 	int minY = 0;
-	int maxY = blocks_[0][0].size() - 1;
+	int maxY = blocks.GetSize() - 1;
 
 	// If it's within the bounds
 	if ((z >= minZ && z <= maxZ) &&
@@ -303,40 +341,40 @@ bool Chunk::IsInChunk(int x, int y, int z)
 	return false;
 }
 
-void Chunk::Update()
+const ChunkState* Chunk::GetState()
 {
-	if (transformComponent->GetHasChanged())
-	{
-		meshComponent->SetModel(transformComponent->GetModel());
-		transformComponent->SetHasChanged(false);
-	}
+	return state_.load();
 }
 
-void Chunk::Draw()
+size_t Chunk::GetStateSize(const ChunkState& state)
 {
-	if (!isUnloaded.load() && shouldDraw_) {
-		meshComponent->Draw();
-	}
+	int size = state.blocks.GetSize();
+	return sizeof(ChunkState) + size * size * size + state.occluders.capacity() * sizeof(OccluderBox);
 }
 
-void Chunk::UseNoise(std::vector<float> chunkSectionNoise, int minY, int maxY)
+void Chunk::PublishState(const ChunkState* state)
 {
-	std::vector<std::vector<std::vector<uint8_t>>> blocks = std::vector<std::vector<std::vector<uint8_t>>>();
+	// Main thread readers rely on this to skip the EpochGuard
+	assert(world_->IsMainThread());
 
-	if (!transformComponent)
+	const ChunkState* oldState = state_.exchange(state);
+	if (oldState != nullptr)
 	{
-		LOG("Error: Transform Component was nullptr\n");
-		return;
+		world_->GetEpochReclaimer()->Retire(oldState, GetStateSize(*oldState));
 	}
+}
 
-	glm::vec3 position = transformComponent->GetTranslation();
+std::vector<uint8_t> Chunk::GenerateBlocksFromNoise(Biome biome, const std::vector<float>& chunkSectionNoise, glm::vec3 position, int size, int minY, int maxY)
+{
+	std::vector<uint8_t> blocks = std::vector<uint8_t>();
+	blocks.reserve(size * size * size);
 
 	// Default values
 	uint8_t surfaceBlock = BLOCK_TYPE_GRASS;
 	uint8_t subSurfaceBlockHigh = BLOCK_TYPE_DIRT;
 	uint8_t subSurfaceBlockLow = BLOCK_TYPE_STONE;
 
-	switch (biome_)
+	switch (biome)
 	{
 	case Biome::Desert:
 		surfaceBlock = BLOCK_TYPE_SAND;
@@ -365,21 +403,16 @@ void Chunk::UseNoise(std::vector<float> chunkSectionNoise, int minY, int maxY)
 		break;
 	}
 
-	int currentBlockIndex = 0;
 	int currentNoiseIndex = 0;
-	for (int z = 0; z < size_.load(); z++)
+	for (int z = 0; z < size; z++)
 	{
-		std::vector<std::vector<uint8_t>> zRow = std::vector<std::vector<uint8_t>>();
-
-		for (int x = 0; x < size_.load(); x++)
+		for (int x = 0; x < size; x++)
 		{
-			std::vector<uint8_t> xRow = std::vector<uint8_t>();
-
 			float currentNoiseVal = chunkSectionNoise[currentNoiseIndex];
-			float ySize = glm::abs(maxY - minY) * size_;
+			float ySize = glm::abs(maxY - minY) * size;
 			float ySurface = (ySize / 2) + (currentNoiseVal * ySize / 2);
 
-			for (int y = 0; y < size_.load(); y++)
+			for (int y = 0; y < size; y++)
 			{
 				uint8_t currentBlock = BLOCK_TYPE_AIR;
 
@@ -402,36 +435,100 @@ void Chunk::UseNoise(std::vector<float> chunkSectionNoise, int minY, int maxY)
 					currentBlock = surfaceBlock;
 				}
 
-				xRow.push_back(currentBlock);
-				currentBlockIndex++;
+				blocks.push_back(currentBlock);
 			}
 			currentNoiseIndex++;
-			zRow.push_back(xRow);
 		}
-
-		blocks.push_back(zRow);
 	}
 
-	blocks_ = blocks;
+	return blocks;
+}
+
+std::vector<uint8_t> Chunk::GetBlockData()
+{
+	EpochGuard guard = EpochGuard(world_->GetEpochReclaimer());
+	return GetState()->blocks.GetBlockData();
+}
+
+ChunkBlocks Chunk::GetBlocksSnapshot()
+{
+	EpochGuard guard = EpochGuard(world_->GetEpochReclaimer());
+	return GetState()->blocks;
+}
+
+bool Chunk::HasUnsavedChanges()
+{
+	return hasUnsavedChanges_.load();
+}
+
+void Chunk::SetHasUnsavedChanges(bool hasUnsavedChanges)
+{
+	hasUnsavedChanges_.store(hasUnsavedChanges);
 }
 
 void Chunk::Unload()
 {
 	meshComponent->GetMesh()->Unload();
 	isUnloaded.store(true);
-	shouldDraw_ = true;
+	version_++;
 }
 
-void Chunk::Recreate(Biome biome, std::vector<float> chunkSectionNoise, int minY, int maxY, glm::vec3 newStartingPosition, int seed, bool isOnMainThread)
+bool Chunk::ApplyResult(ChunkResult& result)
 {
-	seed_.store(seed);
-	blocks_.clear();
-	biome_ = biome;
-	transformComponent->SetTranslation(newStartingPosition);
-	UseNoise(chunkSectionNoise, minY, maxY);
-	UpdateBlocks();
-	GenerateMesh(isOnMainThread);
+	// The chunk was edited or unloaded after the job started, so the
+	// result would overwrite newer blocks
+	if (result.chunkVersion != version_)
+	{
+		return false;
+	}
+
+	transformComponent->SetTranslation(result.state->position);
+	origin_ = glm::ivec3(glm::round(result.state->position));
+	PublishState(result.state.release());
+
+	Mesh* mesh = meshComponent->GetMesh();
+	mesh->SetVertices(std::move(result.vertices));
+	mesh->SetIndices(std::move(result.indices));
+	mesh->SetPassIndexCounts(result.passIndexCounts);
+	if (result.isStaged)
+	{
+		mesh->SetStagedMesh(result.stagedMesh);
+		result.isStaged = false;
+	}
+
+	if (result.isRecreated)
+	{
+		hasUnsavedChanges_.store(result.hasJournalEdits);
+	}
+
 	isUnloaded.store(false);
+	return true;
+}
+
+uint32_t Chunk::GetVersion()
+{
+	return version_;
+}
+
+int Chunk::GetFillIndex(int x, int y, int z, int size)
+{
+	return (z * size + x) * size + y;
+}
+
+ChunkKey Chunk::GetKey()
+{
+	return GetKey(transformComponent->GetTranslation(), size_.load());
+}
+
+ChunkKey Chunk::GetKey(glm::vec3 position, int chunkSize)
+{
+	float size = static_cast<float>(chunkSize);
+
+	return {
+		static_cast<int>(glm::floor(position.x / size)),
+		static_cast<int>(glm::floor(position.y / size)),
+		static_cast<int>(glm::floor(position.z / size))
+	};
 }
 
 bool Chunk::IsUnloaded()
@@ -441,7 +538,8 @@ bool Chunk::IsUnloaded()
 
 Biome Chunk::GetBiome()
 {
-	return biome_;
+	EpochGuard guard = EpochGuard(world_->GetEpochReclaimer());
+	return GetState()->biome;
 }
 
 void Chunk::AddTreeLeavePositions()
@@ -460,117 +558,145 @@ TransformComponent* Chunk::GetTransformComponent()
 	return transformComponent;
 }
 
-bool Chunk::UpdateBlocks()
+glm::ivec3 Chunk::GetOrigin()
 {
-	bool hasUpdatedBlocks = false;
+	return origin_;
+}
 
-	glm::vec3 position = transformComponent->GetTranslation();
+Mesh* Chunk::GetMesh()
+{
+	return meshComponent->GetMesh();
+}
 
-	auto localTreeTrunkPositions = std::vector<glm::vec3*>();
-	auto localTreeLeavePositions = std::vector<glm::vec3*>();
+bool Chunk::ApplyTreeBlocks(ChunkBlocks& blocks, glm::vec3 position, const std::vector<glm::vec3>& treeTrunkPositions, const std::vector<glm::vec3>& treeLeavePositions)
+{
+	bool hasUpdatedBlocks = false;
+	int size = blocks.GetSize();
+
+	auto localTreeTrunkPositions = std::vector<const glm::vec3*>();
+	auto localTreeLeavePositions = std::vector<const glm::vec3*>();
 
-	for (glm::vec3& treeLeavePos : world_->TreeLeavePositions)
+	for (const glm::vec3& treeLeavePos : treeLeavePositions)
 	{
-		if (treeLeavePos.x >= position.x && treeLeavePos.x <= position.x + size_ &&
-			treeLeavePos.y >= position.y && treeLeavePos.y <= position.y + size_ &&
-			treeLeavePos.z >= position.z && treeLeavePos.z <= position.z + size_)
+		if (treeLeavePos.x >= position.x && treeLeavePos.x <= position.x + size &&
+			treeLeavePos.y >= position.y && treeLeavePos.y <= position.y + size &&
+			treeLeavePos.z >= position.z && treeLeavePos.z <= position.z + size)
 		{
 			localTreeLeavePositions.push_back(&treeLeavePos);
 		}
 	}
 
-	for (glm::vec3& treeTrunkPos : world_->TreeTrunkPositions)
+	for (const glm::vec3& treeTrunkPos : treeTrunkPositions)
 	{
-		if (treeTrunkPos.x >= position.x && treeTrunkPos.x <= position.x + size_ &&
-			treeTrunkPos.y >= position.y && treeTrunkPos.y <= position.y + size_ &&
-			treeTrunkPos.z >= position.z && treeTrunkPos.z <= position.z + size_)
+		if (treeTrunkPos.x >= position.x && treeTrunkPos.x <= position.x + size &&
+			treeTrunkPos.y >= position.y && treeTrunkPos.y <= position.y + size &&
+			treeTrunkPos.z >= position.z && treeTrunkPos.z <= position.z + size)
 		{
 			localTreeTrunkPositions.push_back(&treeTrunkPos);
 		}
 	}
 
-	for (int z = 0; z < size_.load(); z++)
+	for (int z = 0; z < size; z++)
 	{
-		for (int x = 0; x < size_.load(); x++)
+		for (int x = 0; x < size; x++)
 		{
-			for (int y = 0; y < size_.load(); y++)
+			for (int y = 0; y < size; y++)
 			{
 				uint8_t currentBlock = BLOCK_TYPE_AIR;
 
-				for (glm::vec3* treeLeavePos : localTreeLeavePositions)
+				for (const glm::vec3* treeLeavePos : localTreeLeavePositions)
 				{
-					if (treeLeavePos != nullptr) {
-						if ((int)position.x + x == (int)treeLeavePos->x && (int)position.y + y == (int)treeLeavePos->y && (int)position.z + z == (int)treeLeavePos->z)
-						{
-							currentBlock = BLOCK_TYPE_TREELEAVES;
-						}
+					if ((int)position.x + x == (int)treeLeavePos->x && (int)position.y + y == (int)treeLeavePos->y && (int)position.z + z == (int)treeLeavePos->z)
+					{
+						currentBlock = BLOCK_TYPE_TREELEAVES;
 					}
 				}
 
-				for (glm::vec3* treeTrunkPos : localTreeTrunkPositions)
+				for (const glm::vec3* treeTrunkPos : localTreeTrunkPositions)
 				{
-					if (treeTrunkPos != nullptr) {
-						if ((int)position.x + x == (int)treeTrunkPos->x && (int)position.y + y == (int)treeTrunkPos->y && (int)position.z + z == (int)treeTrunkPos->z)
-						{
-							currentBlock = BLOCK_TYPE_TREEBARK;
-						}
+					if ((int)position.x + x == (int)treeTrunkPos->x && (int)position.y + y == (int)treeTrunkPos->y && (int)position.z + z == (int)treeTrunkPos->z)
+					{
+						currentBlock = BLOCK_TYPE_TREEBARK;
 					}
 				}
 
 				if (currentBlock != BLOCK_TYPE_AIR)
 				{
-					blocks_.at(z).at(x).at(y) = currentBlock;
+					blocks.Set(x, y, z, currentBlock);
 					hasUpdatedBlocks = true;
 				}
 			}
 		}
 	}
 
-	UpdateCollisionData();
-
 	return hasUpdatedBlocks;
 }
 
-void Chunk::UpdateCollisionData()
+bool Chunk::FindSolidBlock(const ChunkState& state, glm::ivec3 minBlock, glm::ivec3 maxBlock, glm::ivec3& blockOut)
 {
-	// Update Collision Data
-	collisionBoxes.clear();
-	glm::vec3 pos = transformComponent->GetTranslation();
-	pos.x -= size_ / 2;
-	pos.y -= size_ / 2;
-	pos.z -= size_ / 2;
+	// Chunks that are still being generated have no blocks yet
+	if (state.blocks.IsEmpty())
+	{
+		return false;
+	}
 
-	for (int z = 0; z < size_.load(); z++)
+	// The range in local block positions, clamped to the chunk
+	int size = state.blocks.GetSize();
+	glm::ivec3 chunkMin = glm::ivec3(
+		static_cast<int>(state.position.x) - size / 2,
+		static_cast<int>(state.position.y) - size / 2,
+		static_cast<int>(state.position.z) - size / 2);
+	int minX = glm::max(minBlock.x - chunkMin.x, 0);
+	int minY = glm::max(minBlock.y - chunkMin.y, 0);
+	int minZ = glm::max(minBlock.z - chunkMin.z, 0);
+	int maxX = glm::min(maxBlock.x - chunkMin.x, size - 1);
+	int maxY = glm::min(maxBlock.y - chunkMin.y, size - 1);
+	int maxZ = glm::min(maxBlock.z - chunkMin.z, size - 1);
+
+	for (int z = minZ; z <= maxZ; z++)
 	{
-		for (int x = 0; x < size_.load(); x++)
+		for (int x = minX; x <= maxX; x++)
 		{
-			for (int y = 0; y < size_.load(); y++)
+			for (int y = minY; y <= maxY; y++)
 			{
-				uint8_t blockType = blocks_.at(z).at(x).at(y);
-				if (blockType != BLOCK_TYPE_AIR) {
-
-					collisionBoxes.push_back({
-						glm::vec3(x + pos.x, y + pos.y, z + pos.z),
-						glm::vec3(1.0f, 1.0f, 1.0f)
-						});
+				if (state.blocks.Get(x, y, z) != BLOCK_TYPE_AIR)
+				{
+					blockOut = glm::ivec3(chunkMin.x + x, chunkMin.y + y, chunkMin.z + z);
+					return true;
 				}
 			}
 		}
 	}
-}
 
-void Chunk::SetShouldDraw(bool shouldDraw)
-{
-	shouldDraw_ = shouldDraw;
+	return false;
 }
 
-bool Chunk::GetShouldDraw()
+void Chunk::GenerateVisibility(ChunkState& state)
 {
-	return shouldDraw_;
+	const ChunkBlocks& blocks = state.blocks;
+	int size = blocks.GetSize();
+
+	// Leaves have gaps in them
+	std::vector<uint8_t> isSolid = std::vector<uint8_t>(size * size * size);
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			for (int y = 0; y < size; y++)
+			{
+				uint8_t blockType = blocks.Get(x, y, z);
+				isSolid[GetFillIndex(x, y, z, size)] = blockType != BLOCK_TYPE_AIR && GetBlockRenderPass(blockType) == RenderPass::Opaque;
+			}
+		}
+	}
+
+	state.occluders = OcclusionCuller::BuildOccluders(isSolid, size, 4);
+	state.faceConnections = ChunkVisibilityGraph::BuildFaceConnections(isSolid, size);
 }
 
-std::vector<CollisionDetection::CollisionBox>& Chunk::GetCollisionBoxes() {
-	return collisionBoxes;
+int Chunk::GetSize()
+{
+	return size_.load();
 }
 
 bool Chunk::RemoveBlockAt(glm::vec3 localBlockPos)
@@ -579,9 +705,7 @@ bool Chunk::RemoveBlockAt(glm::vec3 localBlockPos)
         (localBlockPos.y >= 0.0f && localBlockPos.y < size_) &&
         (localBlockPos.z >= 0.0f && localBlockPos.z < size_)) {
         LOG("Removed Block at (%f, %f, %f)\n", localBlockPos.x, localBlockPos.y, localBlockPos.z);
-        blocks_.at(localBlockPos.z).at(localBlockPos.x).at(localBlockPos.y) = BLOCK_TYPE_AIR;
-        Reload();
-        return true;
+        return SetBlock(localBlockPos, BLOCK_TYPE_AIR);
     }
 
     return false;
@@ -592,9 +716,7 @@ bool Chunk::PlaceBlockAt(glm::vec3 localPosition, uint8_t blockType) {
         (localPosition.y >= 0.0f && localPosition.y < size_) &&
         (localPosition.z >= 0.0f && localPosition.z < size_)) {
         LOG("Placed Block at (%f, %f, %f)\n", localPosition.x, localPosition.y, localPosition.z);
-        blocks_.at(localPosition.z).at(localPosition.x).at(localPosition.y) = blockType;
-        Reload();
-        return true;
+        return SetBlock(localPosition, blockType);
     }
 
     return false;
@@ -620,11 +742,18 @@ glm::vec3 Chunk::findNearestBlockPosition(const glm::vec3& worldLocation, bool s
     glm::vec3 localChunkBlockPosition = glm::vec3(0, 0, 0);
     float minimumDistance = glm::distance(getWorldPosition(localChunkBlockPosition), worldLocation);
 
+    // Chunks that are still being generated have no blocks yet
+    EpochGuard guard = EpochGuard(world_->GetEpochReclaimer());
+    const ChunkState* state = GetState();
+    if (state->blocks.IsEmpty()) {
+        return localChunkBlockPosition;
+    }
+
     for (int z = 0; z < size_.load(); z++)
     {
         for (int x = 0; x < size_.load(); x++) {
             for (int y = 0; y < size_.load(); y++) {
-                uint8_t curBlock = blocks_.at(z).at(x).at(y);
+                uint8_t curBlock = state->blocks.Get(x, y, z);
 
                 if (shouldIgnoreAir && curBlock == BLOCK_TYPE_AIR) {
                     continue;
@@ -648,6 +777,30 @@ glm::vec3 Chunk::findNearestBlockPosition(const glm::vec3& worldLocation, bool s
 
 void Chunk::Reload()
 {
-	UpdateCollisionData();
-	GenerateMesh(true);
+	GenerateMesh();
+}
+
+bool Chunk::SetBlock(glm::vec3 localPosition, uint8_t blockType)
+{
+	// Only the main thread publishes, so the current state can't be retired under us
+	const ChunkState* state = GetState();
+
+	// Until its first job finishes, the chunk has no pages to write to
+	if (state->blocks.IsEmpty())
+	{
+		return false;
+	}
+
+	ChunkState* newState = new ChunkState();
+	newState->position = state->position;
+	newState->biome = state->biome;
+	newState->blocks = state->blocks;
+	newState->blocks.Set(localPosition.x, localPosition.y, localPosition.z, blockType);
+	GenerateVisibility(*newState);
+	PublishState(newState);
+
+	hasUnsavedChanges_.store(true);
+	version_++;
+	Reload();
+	return true;
 }
\ No newline at end of file
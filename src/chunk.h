@@ -1,6 +1,7 @@
 #pragma once
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <FastNoise/FastNoise.h>
 #include <FastNoise/SmartNode.h>
 #include <FastNoise/Generators/Simplex.h>
@@ -11,6 +12,10 @@
 #include "transformComponent.h"
 #include "meshComponent.h"
 #include "collisionDetection.h"
+#include "chunkBlocks.h"
+#include "chunkStore.h"
+#include "chunkVisibility.h"
+#include "occlusionCuller.h"
 
 
 #include <random>
@@ -27,6 +32,7 @@
 #define BLOCK_TYPE_NONE 10
 
 class World;
+struct ChunkResult;
 
 enum class Biome
 {
@@ -37,6 +43,23 @@ enum class Biome
 	Forest
 };
 
+/*
+ * The blocks and visibility data of a chunk, never changed once it's been
+ * published. Changing a chunk builds a new state (copying the blocks
+ * only copies page pointers) and publishes that in one atomic swap, so
+ * readers on any thread get either the old state or the new one, never
+ * a mix of the two. The old state is retired to the world's
+ * EpochReclaimer, so it stays alive until every reader has let go.
+ */
+struct ChunkState
+{
+	glm::vec3 position;
+	Biome biome;
+	ChunkBlocks blocks;
+	std::vector<OccluderBox> occluders;
+	ChunkFaceConnections faceConnections;
+};
+
 class Chunk : public Entity
 {
 	Texture2DArray texture_;
@@ -45,48 +68,117 @@ class Chunk : public Entity
 
 	std::atomic<int> seed_;
 
-	// The blocks in the chunk (ordered z, then x, then y).
-	std::vector<std::vector<std::vector<uint8_t>>> blocks_;
+	// Only access this through GetState and PublishState
+	std::atomic<const ChunkState*> state_;
+
+	// Set when a block is placed or broken, cleared once autosave snapshots it
+	std::atomic<bool> hasUnsavedChanges_{false};
 
 	MeshComponent* meshComponent;
 	TransformComponent* transformComponent;
 
-	std::atomic<bool> isUnloaded{false};
+	// The translation in whole blocks, which is all the renderer needs. Only used on the main thread.
+	glm::ivec3 origin_;
 
+	std::atomic<bool> isUnloaded{false};
 
-	Biome biome_;
+	// Bumped whenever the blocks are edited or the chunk is unloaded,
+	// so results from jobs that started before then can be thrown away.
+	// Only used on the main thread.
+	uint32_t version_;
 
 	std::vector<glm::vec3> treeTrunkPositions_;
 	std::vector<glm::vec3> treeLeavePositions_;
 
-	std::vector<CollisionDetection::CollisionBox> collisionBoxes;
-
 	World* world_;
-
-	bool shouldDraw_;
 protected:
-	bool IsInChunk(int x, int y, int z);
+	static bool IsInChunk(const ChunkBlocks& blocks, int x, int y, int z);
+
+	// Whether a block's face should be meshed when this is the block on the other side of it
+	static bool IsFaceVisible(uint8_t blockType, uint8_t adjacentBlockType);
+
+	// Swaps in a new state and retires the old one, only call this on the main thread
+	void PublishState(const ChunkState* state);
+
+	// Publishes a copy of the state with one block changed, then remeshes. Returns false if there are no blocks yet.
+	bool SetBlock(glm::vec3 localPosition, uint8_t blockType);
 	
 public:
 	bool needsUpdated;
 
-	Chunk(World* world, Biome biome, Texture2DArray texture, std::vector<float> chunkSectionNoise, int minY, int maxY, glm::vec3 startingPosition, int size, int seed);
+	/*
+	 * Creates the chunk without any blocks, apply a ChunkResult to give it
+	 * some. This creates the chunk's GPU resources, so it has to be called
+	 * on the main thread.
+	 */
+	Chunk(World* world, Texture2DArray texture, glm::vec3 startingPosition, int size, int seed);
 
-	void Draw();
+	/*
+	 * The published state, safe to call from any thread. Off the main
+	 * thread hold an EpochGuard on the world's reclaimer for as long as
+	 * the state is used, otherwise it could be freed mid read.
+	 */
+	const ChunkState* GetState();
 
-	void UseNoise(std::vector<float> chunkSectionNoise, int minY, int maxY);
+	// Roughly how much memory a state holds on to, for the reclaimer's stats
+	static size_t GetStateSize(const ChunkState& state);
 
-	void GenerateMesh(bool isOnMainThread = true);
+	/*
+	 * Generates the blocks for a chunk section from its noise, flattened
+	 * in fill order (z, then x, then y). This doesn't touch any chunk state,
+	 * so it can be used without a chunk (i.e. by the codec benchmark).
+	 */
+	static std::vector<uint8_t> GenerateBlocksFromNoise(Biome biome, const std::vector<float>& chunkSectionNoise, glm::vec3 position, int size, int minY, int maxY);
 
-	// Returns true if any blocks were updated
-	bool UpdateBlocks();
+	// Gets the blocks flattened in fill order (z, then x, then y)
+	std::vector<uint8_t> GetBlockData();
+
+	// The index of a local block position in the fill order
+	static int GetFillIndex(int x, int y, int z, int size);
 
-	void UpdateCollisionData();
+	// A copy-on-write copy of the published blocks
+	ChunkBlocks GetBlocksSnapshot();
+
+	bool HasUnsavedChanges();
+	void SetHasUnsavedChanges(bool hasUnsavedChanges);
+
+	ChunkKey GetKey();
+	static ChunkKey GetKey(glm::vec3 position, int size);
+
+	void GenerateMesh();
+
+	// Which pass a block type is drawn in, its indices go in that pass's range of the mesh
+	static RenderPass GetBlockRenderPass(uint8_t blockType);
+
+	/*
+	 * These only use what's passed in, so they can build a ChunkResult
+	 * on any thread without touching a chunk that's being drawn.
+	 */
+	static void GenerateMeshData(const ChunkBlocks& blocks, int numTextureCols, std::vector<Vertex>& verticesOut, std::vector<unsigned int>& indicesOut, PassIndexCounts& passIndexCountsOut);
+
+	/*
+	 * Looks for a solid block with its centre in [minBlock, maxBlock] (world
+	 * positions in whole blocks), only reading the cells of that range that
+	 * are inside this state's chunk. Blocks are unit boxes centred on their
+	 * position, so this is the collision for the blocks.
+	 */
+	static bool FindSolidBlock(const ChunkState& state, glm::ivec3 minBlock, glm::ivec3 maxBlock, glm::ivec3& blockOut);
+
+	// Fills in the occluders and face connections from the state's blocks
+	static void GenerateVisibility(ChunkState& state);
+
+	// Returns true if any blocks were updated
+	static bool ApplyTreeBlocks(ChunkBlocks& blocks, glm::vec3 position, const std::vector<glm::vec3>& treeTrunkPositions, const std::vector<glm::vec3>& treeLeavePositions);
 
 	void Unload();
-	void Recreate(Biome biome, std::vector<float> chunkSectionNoise, int minY, int maxY, glm::vec3 newStartingPosition, int seed, bool isOnMainThread = true);
 
-	void Update() override;
+	/*
+	 * Publishes the state a job built and swaps in its mesh. Only call this
+	 * on the main thread. Returns false if the result is out of date (the
+	 * chunk has been edited or unloaded since the job started).
+	 */
+	bool ApplyResult(ChunkResult& result);
+	uint32_t GetVersion();
 
 	bool IsUnloaded();
 	Biome GetBiome();
@@ -96,12 +188,15 @@ public:
 	void AddTreeLeavePositions();
 	void AddTreeTrunkPositions();
 
-	void SetShouldDraw(bool shouldDraw);
-	bool GetShouldDraw();
+	// In blocks along each side
+	int GetSize();
 
 	TransformComponent* GetTransformComponent();
 
-	std::vector<CollisionDetection::CollisionBox>& GetCollisionBoxes();
+	// Where the chunk is drawn, chunks are never rotated or scaled so this is the whole transform. Main thread only.
+	glm::ivec3 GetOrigin();
+	Mesh* GetMesh();
+
 
     glm::vec3 findNearestBlockPosition(const glm::vec3& worldLocation, bool shouldIgnoreAir, bool shouldIgnoreSolid);
 
@@ -111,3 +206,27 @@ public:
 	bool RemoveBlockAt(glm::vec3 worldPosition);
 	bool PlaceBlockAt(glm::vec3 localPosition, uint8_t blockType);
 };
+
+/*
+ * Everything a job generates for a chunk, handed to the main thread
+ * through World's completion queue and swapped in with ApplyResult.
+ */
+struct ChunkResult
+{
+	Chunk* chunk;
+	uint32_t chunkVersion; // The chunk's version when the job was scheduled
+	bool isRecreated; // False if the chunk's existing blocks were updated
+	bool hasJournalEdits; // The blocks have edits from the journal its save doesn't, so it needs saving
+
+	// Built by the job, then published as is
+	std::unique_ptr<ChunkState> state;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	PassIndexCounts passIndexCounts;
+
+	// Set if the mesh was also written to the staging buffer
+	bool isStaged;
+	StagedMesh stagedMesh;
+
+	double completedTime; // glfwGetTime when the result was pushed
+};
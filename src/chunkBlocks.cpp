@@ -0,0 +1,109 @@
+#include "chunkBlocks.h"
+
+ChunkBlocks::ChunkBlocks()
+{
+	size_ = 0;
+	pages_ = std::vector<std::shared_ptr<Page>>();
+}
+
+ChunkBlocks::ChunkBlocks(int size, uint8_t blockType)
+{
+	size_ = size;
+	pages_ = std::vector<std::shared_ptr<Page>>(size);
+
+	for (int z = 0; z < size; z++)
+	{
+		pages_[z] = std::make_shared<Page>(size * size, blockType);
+	}
+}
+
+ChunkBlocks::ChunkBlocks(int size, const std::vector<uint8_t>& blockData)
+{
+	size_ = size;
+	pages_ = std::vector<std::shared_ptr<Page>>(size);
+
+	int pageSize = size * size;
+	for (int z = 0; z < size; z++)
+	{
+		pages_[z] = std::make_shared<Page>(blockData.begin() + z * pageSize, blockData.begin() + (z + 1) * pageSize);
+	}
+}
+
+ChunkBlocks::Page& ChunkBlocks::GetPageForWrite(int z)
+{
+	std::shared_ptr<Page>& page = pages_[z];
+
+	// Another copy still uses this page, so give this one its own
+	if (page.use_count() > 1)
+	{
+		page = std::make_shared<Page>(*page);
+	}
+
+	return *page;
+}
+
+uint8_t ChunkBlocks::Get(int x, int y, int z) const
+{
+	return (*pages_[z])[x * size_ + y];
+}
+
+void ChunkBlocks::Set(int x, int y, int z, uint8_t blockType)
+{
+	Page& page = GetPageForWrite(z);
+	page[x * size_ + y] = blockType;
+}
+
+bool ChunkBlocks::SetAtFillIndex(int index, uint8_t blockType)
+{
+	if (index < 0 || index >= size_ * size_ * size_)
+	{
+		return false;
+	}
+
+	Set((index / size_) % size_, index % size_, index / (size_ * size_), blockType);
+	return true;
+}
+
+int ChunkBlocks::GetSize() const
+{
+	return size_;
+}
+
+bool ChunkBlocks::IsEmpty() const
+{
+	return pages_.empty();
+}
+
+void ChunkBlocks::Clear()
+{
+	size_ = 0;
+	pages_.clear();
+}
+
+std::vector<uint8_t> ChunkBlocks::GetBlockData() const
+{
+	std::vector<uint8_t> blockData = std::vector<uint8_t>();
+	blockData.reserve(size_ * size_ * size_);
+
+	for (const std::shared_ptr<Page>& page : pages_)
+	{
+		blockData.insert(blockData.end(), page->begin(), page->end());
+	}
+
+	return blockData;
+}
+
+int ChunkBlocks::GetNumSharedPages() const
+{
+	int numSharedPages = 0;
+
+	for (const std::shared_ptr<Page>& page : pages_)
+	{
+		if (page.use_count() > 1)
+		{
+			numSharedPages++;
+		}
+	}
+
+	return numSharedPages;
+}
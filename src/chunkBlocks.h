@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * The block storage for a chunk, in fill order (z, then x, then y).
+ *
+ * The blocks are split into one page per z slice, and the pages
+ * are shared between copies until one of the copies writes to them
+ * (copy-on-write). This makes copying a chunk's blocks (i.e. to take
+ * a snapshot for saving) cost a handful of pointer copies, and only
+ * the pages that are edited afterwards are ever duplicated.
+ *
+ * Copies can be made from any thread as long as nothing writes to
+ * the blocks being copied, otherwise a page could be shared after it
+ * was checked. Chunks only publish blocks that are never written to
+ * again (see ChunkState), and edits are made to a fresh copy.
+ */
+class ChunkBlocks
+{
+	typedef std::vector<uint8_t> Page;
+
+	int size_;
+	std::vector<std::shared_ptr<Page>> pages_;
+
+	Page& GetPageForWrite(int z);
+public:
+	ChunkBlocks();
+	ChunkBlocks(int size, uint8_t blockType);
+	ChunkBlocks(int size, const std::vector<uint8_t>& blockData);
+
+	uint8_t Get(int x, int y, int z) const;
+	void Set(int x, int y, int z, uint8_t blockType);
+
+	// Returns false if the fill order index is outside of the blocks
+	bool SetAtFillIndex(int index, uint8_t blockType);
+
+	int GetSize() const;
+	bool IsEmpty() const;
+	void Clear();
+
+	// The blocks flattened in fill order
+	std::vector<uint8_t> GetBlockData() const;
+
+	// The number of pages that are also used by another copy
+	int GetNumSharedPages() const;
+};
@@ -0,0 +1,486 @@
+#include "chunkCodec.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <stdio.h>
+
+#include "chunk.h"
+#include "chunkLayout.h"
+#include "terrain.h"
+
+namespace ChunkCodec
+{
+	namespace
+	{
+		const uint8_t MAGIC_0 = 'B';
+		const uint8_t MAGIC_1 = 'C';
+		const size_t HEADER_SIZE = 8;
+
+		// Chunks are 16^3, this just stops corrupt headers from
+		// making us allocate gigabytes before the payload is checked.
+		const uint32_t MAX_BLOCKS = 1 << 20;
+
+		const size_t LZ_MIN_MATCH = 4;
+		const size_t LZ_MAX_OFFSET = 65535;
+		const int LZ_HASH_BITS = 12;
+
+		void WriteU32(std::vector<uint8_t>& out, uint32_t value)
+		{
+			out.push_back(static_cast<uint8_t>(value));
+			out.push_back(static_cast<uint8_t>(value >> 8));
+			out.push_back(static_cast<uint8_t>(value >> 16));
+			out.push_back(static_cast<uint8_t>(value >> 24));
+		}
+
+		uint32_t ReadU32(const uint8_t* data)
+		{
+			return static_cast<uint32_t>(data[0]) |
+				(static_cast<uint32_t>(data[1]) << 8) |
+				(static_cast<uint32_t>(data[2]) << 16) |
+				(static_cast<uint32_t>(data[3]) << 24);
+		}
+
+		void WriteVarInt(std::vector<uint8_t>& out, uint32_t value)
+		{
+			while (value >= 0x80)
+			{
+				out.push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+
+			out.push_back(static_cast<uint8_t>(value));
+		}
+
+		bool ReadVarInt(const uint8_t*& ip, const uint8_t* end, uint32_t& value)
+		{
+			value = 0;
+
+			for (int shift = 0; shift < 35; shift += 7)
+			{
+				if (ip >= end)
+				{
+					return false;
+				}
+
+				uint8_t byte = *ip++;
+				value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+
+				if ((byte & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/*
+		 * Each run is stored as the block id followed by the
+		 * length of the run as a varint.
+		 */
+		std::vector<uint8_t> EncodeRunLength(const std::vector<uint8_t>& blocks)
+		{
+			std::vector<uint8_t> out = std::vector<uint8_t>();
+
+			size_t runStart = 0;
+			while (runStart < blocks.size())
+			{
+				uint8_t block = blocks[runStart];
+
+				size_t runEnd = runStart + 1;
+				while (runEnd < blocks.size() && blocks[runEnd] == block)
+				{
+					runEnd++;
+				}
+
+				out.push_back(block);
+				WriteVarInt(out, static_cast<uint32_t>(runEnd - runStart));
+				runStart = runEnd;
+			}
+
+			return out;
+		}
+
+		bool DecodeRunLength(const uint8_t* ip, const uint8_t* end, uint32_t numBlocks, std::vector<uint8_t>& blocksOut)
+		{
+			blocksOut.clear();
+			blocksOut.reserve(numBlocks);
+
+			while (ip < end)
+			{
+				uint8_t block = *ip++;
+
+				uint32_t runLength = 0;
+				if (!ReadVarInt(ip, end, runLength) || runLength == 0 || runLength > numBlocks - blocksOut.size())
+				{
+					return false;
+				}
+
+				blocksOut.insert(blocksOut.end(), runLength, block);
+			}
+
+			return blocksOut.size() == numBlocks;
+		}
+
+		// Lengths that don't fit in a token nibble carry on in 255 steps.
+		void WriteLength(std::vector<uint8_t>& out, size_t length)
+		{
+			while (length >= 255)
+			{
+				out.push_back(255);
+				length -= 255;
+			}
+
+			out.push_back(static_cast<uint8_t>(length));
+		}
+
+		bool ReadLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+		{
+			uint8_t byte = 0;
+
+			do
+			{
+				if (ip >= end)
+				{
+					return false;
+				}
+
+				byte = *ip++;
+				length += byte;
+			} while (byte == 255);
+
+			return true;
+		}
+
+		/*
+		 * A sequence is a token (literal count, match length), the literals,
+		 * then the match offset. The last sequence has no match, the decoder
+		 * knows it's the last one because the input ends after the literals.
+		 */
+		void WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t numLiterals, size_t offset, size_t matchLength)
+		{
+			size_t extraMatchLength = matchLength >= LZ_MIN_MATCH ? matchLength - LZ_MIN_MATCH : 0;
+			size_t tokenLiterals = numLiterals < 15 ? numLiterals : 15;
+			size_t tokenMatch = extraMatchLength < 15 ? extraMatchLength : 15;
+
+			out.push_back(static_cast<uint8_t>((tokenLiterals << 4) | tokenMatch));
+
+			if (numLiterals >= 15)
+			{
+				WriteLength(out, numLiterals - 15);
+			}
+
+			out.insert(out.end(), literals, literals + numLiterals);
+
+			if (matchLength == 0)
+			{
+				return;
+			}
+
+			out.push_back(static_cast<uint8_t>(offset));
+			out.push_back(static_cast<uint8_t>(offset >> 8));
+
+			if (extraMatchLength >= 15)
+			{
+				WriteLength(out, extraMatchLength - 15);
+			}
+		}
+
+		std::vector<uint8_t> CompressLZ(const std::vector<uint8_t>& input)
+		{
+			std::vector<uint8_t> out = std::vector<uint8_t>();
+			out.reserve(input.size());
+
+			std::vector<int32_t> hashTable = std::vector<int32_t>(1 << LZ_HASH_BITS, -1);
+
+			const uint8_t* base = input.data();
+			size_t size = input.size();
+			size_t anchor = 0;
+			size_t pos = 0;
+
+			while (pos + LZ_MIN_MATCH <= size)
+			{
+				uint32_t sequence = 0;
+				memcpy(&sequence, base + pos, sizeof(sequence));
+				uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+
+				int32_t candidate = hashTable[hash];
+				hashTable[hash] = static_cast<int32_t>(pos);
+
+				if (candidate >= 0 && pos - candidate <= LZ_MAX_OFFSET && memcmp(base + candidate, base + pos, LZ_MIN_MATCH) == 0)
+				{
+					size_t matchLength = LZ_MIN_MATCH;
+					while (pos + matchLength < size && base[candidate + matchLength] == base[pos + matchLength])
+					{
+						matchLength++;
+					}
+
+					WriteSequence(out, base + anchor, pos - anchor, pos - candidate, matchLength);
+					pos += matchLength;
+					anchor = pos;
+				}
+				else
+				{
+					pos++;
+				}
+			}
+
+			WriteSequence(out, base + anchor, size - anchor, 0, 0);
+
+			return out;
+		}
+
+		bool DecompressLZ(const uint8_t* ip, const uint8_t* end, size_t decompressedSize, std::vector<uint8_t>& out)
+		{
+			out.clear();
+			out.reserve(decompressedSize);
+
+			while (ip < end)
+			{
+				uint8_t token = *ip++;
+
+				size_t numLiterals = token >> 4;
+				if (numLiterals == 15 && !ReadLength(ip, end, numLiterals))
+				{
+					return false;
+				}
+
+				if (static_cast<size_t>(end - ip) < numLiterals || numLiterals > decompressedSize - out.size())
+				{
+					return false;
+				}
+
+				out.insert(out.end(), ip, ip + numLiterals);
+				ip += numLiterals;
+
+				// The last sequence only has literals
+				if (ip == end)
+				{
+					break;
+				}
+
+				if (end - ip < 2)
+				{
+					return false;
+				}
+
+				size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+				ip += 2;
+
+				size_t matchLength = token & 0x0f;
+				if (matchLength == 15 && !ReadLength(ip, end, matchLength))
+				{
+					return false;
+				}
+				matchLength += LZ_MIN_MATCH;
+
+				if (offset == 0 || offset > out.size() || matchLength > decompressedSize - out.size())
+				{
+					return false;
+				}
+
+				// Copied a byte at a time since matches can overlap themselves
+				size_t matchStart = out.size() - offset;
+				for (size_t i = 0; i < matchLength; i++)
+				{
+					out.push_back(out[matchStart + i]);
+				}
+			}
+
+			return out.size() == decompressedSize;
+		}
+	}
+
+	std::vector<uint8_t> Encode(const std::vector<uint8_t>& blocks, bool useLZ)
+	{
+		std::vector<uint8_t> runLength = EncodeRunLength(blocks);
+
+		std::vector<uint8_t> lz = std::vector<uint8_t>();
+		if (useLZ)
+		{
+			lz = CompressLZ(runLength);
+		}
+
+		// The LZ header needs an extra 4 bytes for the run-length size
+		bool shouldUseLZ = useLZ && lz.size() + 4 < runLength.size();
+
+		std::vector<uint8_t> out = std::vector<uint8_t>();
+		out.reserve(HEADER_SIZE + 4 + (shouldUseLZ ? lz.size() : runLength.size()));
+
+		out.push_back(MAGIC_0);
+		out.push_back(MAGIC_1);
+		out.push_back(VERSION);
+		out.push_back(shouldUseLZ ? FLAG_LZ : 0);
+		WriteU32(out, static_cast<uint32_t>(blocks.size()));
+
+		if (shouldUseLZ)
+		{
+			WriteU32(out, static_cast<uint32_t>(runLength.size()));
+			out.insert(out.end(), lz.begin(), lz.end());
+		}
+		else
+		{
+			out.insert(out.end(), runLength.begin(), runLength.end());
+		}
+
+		return out;
+	}
+
+	bool Decode(const uint8_t* data, size_t size, std::vector<uint8_t>& blocksOut)
+	{
+		blocksOut.clear();
+
+		if (data == nullptr || size < HEADER_SIZE)
+		{
+			return false;
+		}
+
+		if (data[0] != MAGIC_0 || data[1] != MAGIC_1 || data[2] != VERSION)
+		{
+			return false;
+		}
+
+		uint8_t flags = data[3];
+		if ((flags & ~FLAG_LZ) != 0)
+		{
+			return false;
+		}
+
+		uint32_t numBlocks = ReadU32(data + 4);
+		if (numBlocks > MAX_BLOCKS)
+		{
+			return false;
+		}
+
+		const uint8_t* payload = data + HEADER_SIZE;
+		const uint8_t* end = data + size;
+
+		bool wasDecoded = false;
+		if (flags & FLAG_LZ)
+		{
+			if (size < HEADER_SIZE + 4)
+			{
+				return false;
+			}
+
+			// Every run is at least two bytes (id + length)
+			uint32_t runLengthSize = ReadU32(payload);
+			if (runLengthSize > static_cast<uint64_t>(numBlocks) * 2)
+			{
+				return false;
+			}
+
+			std::vector<uint8_t> runLength = std::vector<uint8_t>();
+			wasDecoded = DecompressLZ(payload + 4, end, runLengthSize, runLength) &&
+				DecodeRunLength(runLength.data(), runLength.data() + runLength.size(), numBlocks, blocksOut);
+		}
+		else
+		{
+			wasDecoded = DecodeRunLength(payload, end, numBlocks, blocksOut);
+		}
+
+		if (!wasDecoded)
+		{
+			blocksOut.clear();
+		}
+
+		return wasDecoded;
+	}
+
+	bool Decode(const std::vector<uint8_t>& data, std::vector<uint8_t>& blocksOut)
+	{
+		return Decode(data.data(), data.size(), blocksOut);
+	}
+
+	bool RunBenchmark(const std::vector<int>& seeds, int renderDistance)
+	{
+		const int numIterations = 20;
+
+		// The biomes World can pick from the temperature noise
+		const Biome biomes[] = { Biome::Snow, Biome::Grassland, Biome::Forest, Biome::Desert };
+
+		bool didRoundTrip = true;
+
+		for (int seed : seeds)
+		{
+			Terrain terrain = Terrain(seed);
+			std::mt19937 biomeRng = std::mt19937(seed);
+
+			std::vector<std::vector<uint8_t>> chunks = std::vector<std::vector<uint8_t>>();
+			for (int z = -renderDistance; z <= renderDistance; z++)
+			{
+				for (int x = -renderDistance; x <= renderDistance; x++)
+				{
+					std::vector<float> noise = terrain.GetElevationNoiseForChunk(x * CHUNK_SIZE, z * CHUNK_SIZE);
+					Biome biome = biomes[biomeRng() % 4];
+
+					for (int y = MIN_CHUNK_Y; y <= MAX_CHUNK_Y; y++)
+					{
+						chunks.push_back(Chunk::GenerateBlocksFromNoise(biome, noise, glm::vec3(x * CHUNK_SIZE, y * CHUNK_SIZE, z * CHUNK_SIZE), CHUNK_SIZE, MIN_CHUNK_Y, MAX_CHUNK_Y));
+					}
+				}
+			}
+
+			size_t rawBytes = 0;
+			for (const std::vector<uint8_t>& chunk : chunks)
+			{
+				rawBytes += chunk.size();
+			}
+
+			for (bool useLZ : { false, true })
+			{
+				std::vector<std::vector<uint8_t>> encodedChunks = std::vector<std::vector<uint8_t>>(chunks.size());
+				std::vector<uint8_t> decodedChunk = std::vector<uint8_t>();
+
+				auto encodeStartTime = std::chrono::steady_clock::now();
+				for (int iteration = 0; iteration < numIterations; iteration++)
+				{
+					for (size_t i = 0; i < chunks.size(); i++)
+					{
+						encodedChunks[i] = Encode(chunks[i], useLZ);
+					}
+				}
+				auto encodeEndTime = std::chrono::steady_clock::now();
+
+				auto decodeStartTime = std::chrono::steady_clock::now();
+				for (int iteration = 0; iteration < numIterations; iteration++)
+				{
+					for (size_t i = 0; i < chunks.size(); i++)
+					{
+						Decode(encodedChunks[i], decodedChunk);
+					}
+				}
+				auto decodeEndTime = std::chrono::steady_clock::now();
+
+				size_t encodedBytes = 0;
+				for (size_t i = 0; i < chunks.size(); i++)
+				{
+					encodedBytes += encodedChunks[i].size();
+
+					if (!Decode(encodedChunks[i], decodedChunk) || decodedChunk != chunks[i])
+					{
+						printf("Chunk %zu from seed %d didn't round-trip (LZ: %d)\n", i, seed, useLZ);
+						didRoundTrip = false;
+					}
+				}
+
+				double encodeSeconds = std::chrono::duration<double>(encodeEndTime - encodeStartTime).count();
+				double decodeSeconds = std::chrono::duration<double>(decodeEndTime - decodeStartTime).count();
+				double totalMegabytes = static_cast<double>(rawBytes) * numIterations / (1024.0 * 1024.0);
+
+				printf("Seed %d, %s: %zu chunks, %zu -> %zu bytes (%.1fx), encode %.1f MB/s, decode %.1f MB/s\n",
+					seed,
+					useLZ ? "RLE+LZ" : "RLE",
+					chunks.size(),
+					rawBytes,
+					encodedBytes,
+					static_cast<double>(rawBytes) / static_cast<double>(encodedBytes),
+					totalMegabytes / encodeSeconds,
+					totalMegabytes / decodeSeconds);
+			}
+		}
+
+		return didRoundTrip;
+	}
+}
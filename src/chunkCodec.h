@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Serialises chunk block data into a compact byte stream that
+ * can be used for disk saves, caches and network transfer.
+ *
+ * Blocks are expected in the chunk fill order (z, then x, then y),
+ * which puts the long vertical runs of stone, dirt and air that
+ * GenerateBlocksFromNoise produces next to each other. The blocks are first run-length
+ * encoded, then an optional byte-level LZ pass removes the repetition
+ * that is left between neighbouring columns.
+ *
+ * Encoded layout :-
+ *   magic ("BC"), version, flags, raw block count (u32),
+ *   run-length stream size (u32, only if the LZ flag is set),
+ *   payload
+ */
+namespace ChunkCodec
+{
+	const uint8_t VERSION = 1;
+	const uint8_t FLAG_LZ = 1 << 0;
+
+	/*
+	 * Encodes the blocks. If the LZ pass doesn't make the
+	 * data any smaller it is skipped, so the output is never
+	 * larger than the run-length encoding on its own.
+	 */
+	std::vector<uint8_t> Encode(const std::vector<uint8_t>& blocks, bool useLZ = true);
+
+	/*
+	 * Decodes data produced by Encode. Returns false (and leaves
+	 * blocksOut empty) if the data is truncated or corrupt.
+	 */
+	bool Decode(const uint8_t* data, size_t size, std::vector<uint8_t>& blocksOut);
+	bool Decode(const std::vector<uint8_t>& data, std::vector<uint8_t>& blocksOut);
+
+	/*
+	 * Generates worlds from each of the seeds, round-trips every chunk
+	 * through the codec and prints the encode/decode throughput and
+	 * compression ratio. Returns false if any chunk didn't round-trip.
+	 */
+	bool RunBenchmark(const std::vector<int>& seeds, int renderDistance);
+}
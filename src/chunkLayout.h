@@ -0,0 +1,6 @@
+#pragma once
+
+// The World's chunks, which the benchmarks lay their scenes out the same as
+const int CHUNK_SIZE = 16; // num. blocks along each side
+const int MIN_CHUNK_Y = -1; // num. chunks
+const int MAX_CHUNK_Y = 2; // num. chunks (i.e. max - min would be the number of chunks high)
@@ -0,0 +1,346 @@
+#include "chunkQuadtree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "cullingBenchmark.h"
+
+ChunkQuadtree::ChunkQuadtree()
+{
+	nodes_ = std::vector<Node>();
+	chunkIndices_ = std::vector<int>();
+	chunkBounds_ = std::vector<AABB>();
+	culler_ = FrustumCuller();
+
+	columns_ = std::vector<Column>();
+	columnChunks_ = std::vector<int>();
+	stack_ = std::vector<int>();
+	occlusionStack_ = std::vector<std::pair<int, bool>>();
+	partialRanges_ = std::vector<BoxRange>();
+	visibleSlots_ = std::vector<int>();
+
+	stats_ = {};
+}
+
+void ChunkQuadtree::Build(const std::vector<AABB>& chunkBounds)
+{
+	nodes_.clear();
+	chunkIndices_.clear();
+	chunkBounds_.clear();
+	columns_.clear();
+
+	// Sorting by column puts each column's chunks next to each other
+	columnChunks_.resize(chunkBounds.size());
+	for (size_t i = 0; i < chunkBounds.size(); i++)
+	{
+		columnChunks_[i] = i;
+	}
+
+	auto getColumn = [&chunkBounds](int chunk) {
+		return std::make_pair(static_cast<int>(std::floor(chunkBounds[chunk].origin.x)), static_cast<int>(std::floor(chunkBounds[chunk].origin.z)));
+	};
+
+	std::sort(columnChunks_.begin(), columnChunks_.end(), [&getColumn](int a, int b) {
+		return getColumn(a) < getColumn(b);
+	});
+
+	for (size_t i = 0; i < columnChunks_.size(); i++)
+	{
+		std::pair<int, int> column = getColumn(columnChunks_[i]);
+		if (columns_.empty() || columns_.back().x != column.first || columns_.back().z != column.second)
+		{
+			columns_.push_back({ column.first, column.second, static_cast<int>(i), 0 });
+		}
+		columns_.back().numChunks++;
+	}
+
+	if (!columns_.empty())
+	{
+		nodes_.push_back({});
+		BuildNode(0, 0, columns_.size(), chunkBounds);
+	}
+
+	culler_.SetNumBoxes(chunkBounds_.size());
+	for (size_t i = 0; i < chunkBounds_.size(); i++)
+	{
+		culler_.SetBox(i, chunkBounds_[i].origin, chunkBounds_[i].size);
+	}
+
+	stats_.numNodes = nodes_.size();
+}
+
+void ChunkQuadtree::BuildNode(int node, int firstColumn, int numColumns, const std::vector<AABB>& chunkBounds)
+{
+	glm::vec3 min = glm::vec3(INFINITY);
+	glm::vec3 max = glm::vec3(-INFINITY);
+	int minX = columns_[firstColumn].x;
+	int maxX = minX;
+	int minZ = columns_[firstColumn].z;
+	int maxZ = minZ;
+	for (int i = firstColumn; i < firstColumn + numColumns; i++)
+	{
+		const Column& column = columns_[i];
+		minX = std::min(minX, column.x);
+		maxX = std::max(maxX, column.x);
+		minZ = std::min(minZ, column.z);
+		maxZ = std::max(maxZ, column.z);
+
+		for (int j = column.firstChunk; j < column.firstChunk + column.numChunks; j++)
+		{
+			const AABB& bounds = chunkBounds[columnChunks_[j]];
+			min = glm::vec3(std::min(min.x, bounds.origin.x - bounds.size.x), std::min(min.y, bounds.origin.y - bounds.size.y), std::min(min.z, bounds.origin.z - bounds.size.z));
+			max = glm::vec3(std::max(max.x, bounds.origin.x + bounds.size.x), std::max(max.y, bounds.origin.y + bounds.size.y), std::max(max.z, bounds.origin.z + bounds.size.z));
+		}
+	}
+
+	nodes_[node].centre = (min + max) * 0.5f;
+	nodes_[node].halfSize = (max - min) * 0.5f;
+	nodes_[node].firstChild = -1;
+	nodes_[node].numChildren = 0;
+	nodes_[node].chunks = { static_cast<int>(chunkIndices_.size()), 0 };
+	nodes_[node].frustumState = FrustumState::Outside;
+
+	if (numColumns == 1)
+	{
+		const Column& column = columns_[firstColumn];
+		for (int j = column.firstChunk; j < column.firstChunk + column.numChunks; j++)
+		{
+			chunkIndices_.push_back(columnChunks_[j]);
+			chunkBounds_.push_back(chunkBounds[columnChunks_[j]]);
+		}
+		nodes_[node].chunks.count = column.numChunks;
+		return;
+	}
+
+	// Split into quarters, the middle is rounded down so both sides of a split get at least one column
+	int middleX = minX + (maxX - minX) / 2;
+	int middleZ = minZ + (maxZ - minZ) / 2;
+	auto first = columns_.begin() + firstColumn;
+	auto last = first + numColumns;
+	auto splitX = std::partition(first, last, [middleX](const Column& column) { return column.x <= middleX; });
+	auto splitLowX = std::partition(first, splitX, [middleZ](const Column& column) { return column.z <= middleZ; });
+	auto splitHighX = std::partition(splitX, last, [middleZ](const Column& column) { return column.z <= middleZ; });
+
+	std::vector<Column>::iterator quarterBounds[5] = { first, splitLowX, splitX, splitHighX, last };
+	std::vector<std::pair<int, int>> quarters = std::vector<std::pair<int, int>>();
+	for (int i = 0; i < 4; i++)
+	{
+		int numQuarterColumns = static_cast<int>(quarterBounds[i + 1] - quarterBounds[i]);
+		if (numQuarterColumns > 0)
+		{
+			quarters.push_back({ static_cast<int>(quarterBounds[i] - columns_.begin()), numQuarterColumns });
+		}
+	}
+
+	// Children are next to each other, so they're added before any of them are built
+	int firstChild = nodes_.size();
+	nodes_.resize(nodes_.size() + quarters.size());
+	nodes_[node].firstChild = firstChild;
+	nodes_[node].numChildren = quarters.size();
+
+	for (size_t i = 0; i < quarters.size(); i++)
+	{
+		BuildNode(firstChild + i, quarters[i].first, quarters[i].second, chunkBounds);
+	}
+	nodes_[node].chunks.count = chunkIndices_.size() - nodes_[node].chunks.first;
+}
+
+void ChunkQuadtree::Cull(const Frustum& frustum, std::vector<int>& visibleOut)
+{
+	const Plane* planes[6] = { &frustum.right, &frustum.left, &frustum.top, &frustum.bottom, &frustum.near, &frustum.far };
+
+	visibleOut.clear();
+	partialRanges_.clear();
+	stats_.numNodesVisited = 0;
+	stats_.numChunksTested = 0;
+
+	stack_.clear();
+	if (!nodes_.empty())
+	{
+		stack_.push_back(0);
+	}
+
+	while (!stack_.empty())
+	{
+		Node& node = nodes_[stack_.back()];
+		stack_.pop_back();
+		stats_.numNodesVisited++;
+
+		// Same test as IsBoundingBoxInsidePlane, and also whether it's completely inside
+		node.frustumState = FrustumState::Inside;
+		for (const Plane* plane : planes)
+		{
+			float r = node.halfSize.x * std::fabs(plane->normal.x) + node.halfSize.y * std::fabs(plane->normal.y) + node.halfSize.z * std::fabs(plane->normal.z);
+			float distanceToPlane = glm::dot(plane->normal, node.centre) - plane->distanceFromOrigin;
+			if (!(-r <= distanceToPlane))
+			{
+				node.frustumState = FrustumState::Outside;
+				break;
+			}
+
+			if (distanceToPlane < r)
+			{
+				node.frustumState = FrustumState::Partly;
+			}
+		}
+
+		if (node.frustumState == FrustumState::Inside)
+		{
+			visibleOut.insert(visibleOut.end(), chunkIndices_.begin() + node.chunks.first, chunkIndices_.begin() + node.chunks.first + node.chunks.count);
+		}
+		else if (node.frustumState == FrustumState::Partly)
+		{
+			if (node.numChildren == 0)
+			{
+				partialRanges_.push_back(node.chunks);
+				stats_.numChunksTested += node.chunks.count;
+			}
+
+			for (int i = 0; i < node.numChildren; i++)
+			{
+				stack_.push_back(node.firstChild + i);
+			}
+		}
+	}
+
+	// The leaves the frustum's sides cross are tested in one batch, four chunks at a time
+	visibleSlots_.clear();
+	culler_.CullRanges(frustum, partialRanges_, visibleSlots_);
+	for (int slot : visibleSlots_)
+	{
+		visibleOut.push_back(chunkIndices_[slot]);
+	}
+}
+
+void ChunkQuadtree::OcclusionCull(OcclusionCuller& occlusionCuller, std::vector<uint8_t>& isOccludedOut)
+{
+	isOccludedOut.assign(chunkIndices_.size(), 0);
+	stats_.numOcclusionTests = 0;
+
+	occlusionStack_.clear();
+	if (!nodes_.empty() && nodes_[0].frustumState != FrustumState::Outside)
+	{
+		occlusionStack_.push_back({ 0, false });
+	}
+
+	while (!occlusionStack_.empty())
+	{
+		std::pair<int, bool> next = occlusionStack_.back();
+		occlusionStack_.pop_back();
+
+		const Node& node = nodes_[next.first];
+		stats_.numOcclusionTests++;
+		if (!occlusionCuller.IsVisible(node.centre - node.halfSize, node.centre + node.halfSize))
+		{
+			for (int slot = node.chunks.first; slot < node.chunks.first + node.chunks.count; slot++)
+			{
+				isOccludedOut[chunkIndices_[slot]] = 1;
+			}
+			continue;
+		}
+
+		if (node.numChildren == 0)
+		{
+			// A leaf is a single column, so its chunks are few enough to test one by one
+			if (node.chunks.count == 1)
+			{
+				continue;
+			}
+
+			for (int slot = node.chunks.first; slot < node.chunks.first + node.chunks.count; slot++)
+			{
+				const AABB& bounds = chunkBounds_[slot];
+				stats_.numOcclusionTests++;
+				if (!occlusionCuller.IsVisible(bounds.origin - bounds.size, bounds.origin + bounds.size))
+				{
+					isOccludedOut[chunkIndices_[slot]] = 1;
+				}
+			}
+			continue;
+		}
+
+		// The frustum cull didn't look inside nodes that were completely inside
+		bool isInsideFrustum = next.second || node.frustumState == FrustumState::Inside;
+		for (int i = 0; i < node.numChildren; i++)
+		{
+			int child = node.firstChild + i;
+			if (isInsideFrustum || nodes_[child].frustumState != FrustumState::Outside)
+			{
+				occlusionStack_.push_back({ child, isInsideFrustum });
+			}
+		}
+	}
+}
+
+ChunkQuadtreeStats ChunkQuadtree::GetStats()
+{
+	return stats_;
+}
+
+bool ChunkQuadtree::RunBenchmark(int maxRenderDistance)
+{
+	const int numFrames = 256;
+
+	bool isCorrect = true;
+	for (int renderDistance = 8; renderDistance <= maxRenderDistance; renderDistance += 8)
+	{
+		std::vector<AABB> boxes = CullingBenchmark::CreateChunkBoxes(renderDistance);
+
+		ChunkQuadtree tree = ChunkQuadtree();
+		tree.Build(boxes);
+
+		FrustumCuller culler = FrustumCuller();
+		culler.SetNumBoxes(boxes.size());
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			culler.SetBox(i, boxes[i].origin, boxes[i].size);
+		}
+
+		std::vector<Frustum> frustums = CullingBenchmark::CreateFrustums(renderDistance, numFrames);
+
+		// The tree has to keep exactly the same chunks as testing every chunk
+		std::vector<int> visible = std::vector<int>();
+		std::vector<int> flatVisible = std::vector<int>();
+		size_t numNodesVisited = 0;
+		size_t numChunksTested = 0;
+		bool doesMatch = true;
+		for (const Frustum& frustum : frustums)
+		{
+			tree.Cull(frustum, visible);
+			culler.Cull(frustum, flatVisible);
+			numNodesVisited += tree.GetStats().numNodesVisited;
+			numChunksTested += tree.GetStats().numChunksTested;
+
+			std::sort(visible.begin(), visible.end());
+			doesMatch = doesMatch && visible == flatVisible;
+		}
+
+		if (!doesMatch)
+		{
+			isCorrect = false;
+			printf("Render distance %d: the quadtree and flat culling disagree\n", renderDistance);
+		}
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (const Frustum& frustum : frustums)
+		{
+			tree.Cull(frustum, visible);
+		}
+		double treeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		startTime = std::chrono::steady_clock::now();
+		for (const Frustum& frustum : frustums)
+		{
+			culler.Cull(frustum, flatVisible);
+		}
+		double flatSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		printf("Render distance %d, %zu chunks, %d nodes: quadtree %zu node and %zu chunk tests, %.1fus per frame, flat %zu chunk tests, %.1fus per frame\n",
+			renderDistance, boxes.size(), tree.GetStats().numNodes, numNodesVisited / numFrames, numChunksTested / numFrames, treeSeconds * 1e6 / numFrames,
+			boxes.size(), flatSeconds * 1e6 / numFrames);
+	}
+
+	return isCorrect;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "frustum.h"
+#include "frustumCuller.h"
+#include "occlusionCuller.h"
+
+struct ChunkQuadtreeStats
+{
+	// For the last cull
+	int numNodes;
+	int numNodesVisited; // by the frustum cull
+	int numChunksTested; // one by one, by the frustum cull
+	int numOcclusionTests;
+};
+
+/*
+ * A quadtree over chunk columns, so culling can throw away or keep
+ * whole groups of columns with one test instead of testing every chunk.
+ *
+ * The leaves are columns, every node's box covers its columns' chunks
+ * from the lowest to the highest. Chunks are stored in tree order, so
+ * each node's chunks are one range. A node that's completely inside the
+ * frustum adds its whole range without testing it, one that's outside
+ * is skipped, and only the leaves the frustum's sides pass through have
+ * their chunks tested, four at a time by a FrustumCuller. As the render
+ * distance grows the number of tests grows with the length of the
+ * frustum's sides rather than the number of chunks.
+ *
+ * Pure CPU, chunks are referred to by their index in the bounds the tree
+ * was built from.
+ */
+class ChunkQuadtree
+{
+	enum class FrustumState
+	{
+		Outside,
+		Partly,
+		Inside
+	};
+
+	struct Node
+	{
+		glm::vec3 centre;
+		glm::vec3 halfSize;
+		int firstChild; // children are next to each other, -1 for leaves
+		int numChildren;
+		BoxRange chunks; // in tree order
+
+		// From the last frustum cull, only up to date for the nodes it visited
+		FrustumState frustumState;
+	};
+
+	struct Column
+	{
+		int x;
+		int z;
+		int firstChunk; // in columnChunks_
+		int numChunks;
+	};
+
+	std::vector<Node> nodes_; // the root is first
+	std::vector<int> chunkIndices_; // tree order to the index the chunk was built with
+	std::vector<AABB> chunkBounds_; // tree order
+	FrustumCuller culler_; // holds the chunks in tree order
+
+	// Scratch space for building and culling
+	std::vector<Column> columns_;
+	std::vector<int> columnChunks_;
+	std::vector<int> stack_;
+	std::vector<std::pair<int, bool>> occlusionStack_; // nodes, and whether a node above them was completely inside the frustum
+	std::vector<BoxRange> partialRanges_;
+	std::vector<int> visibleSlots_;
+
+	ChunkQuadtreeStats stats_;
+
+	// Fills in the node for columns firstColumn to firstColumn + numColumns - 1, and adds its children
+	void BuildNode(int node, int firstColumn, int numColumns, const std::vector<AABB>& chunkBounds);
+public:
+	ChunkQuadtree();
+
+	/*
+	 * Rebuilds the tree around the chunks, they're grouped into columns by
+	 * the x and z of their centres. Call again when the chunks move.
+	 */
+	void Build(const std::vector<AABB>& chunkBounds);
+
+	// Replaces visibleOut with the indices of the chunks that are at least partly inside, in no particular order
+	void Cull(const Frustum& frustum, std::vector<int>& visibleOut);
+
+	/*
+	 * Tests the nodes that were in the last frustum cull against the
+	 * culler's depth pyramid, call after its BuildPyramid. A hidden node
+	 * hides all of its chunks. Sets isOccludedOut[chunk] for every chunk
+	 * that's hidden, the rest are 0.
+	 */
+	void OcclusionCull(OcclusionCuller& occlusionCuller, std::vector<uint8_t>& isOccludedOut);
+
+	ChunkQuadtreeStats GetStats();
+
+	/*
+	 * Culls the same world and camera as FrustumCuller's benchmark with
+	 * the tree and with the flat culler, at render distances from 8 up to
+	 * maxRenderDistance, and prints how many tests and how long each
+	 * took. Returns false if they keep different chunks.
+	 */
+	static bool RunBenchmark(int maxRenderDistance);
+};
@@ -0,0 +1,229 @@
+#include "chunkRenderer.h"
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+#include "chunk.h"
+#include "renderDevice.h"
+
+namespace
+{
+	// Where mesh.vert expects the chunk draw data and draw index
+	const unsigned int drawDataBinding = 0;
+	const unsigned int drawIndexAttribute = 4;
+	const unsigned int drawIndexBufferBinding = 1;
+
+	void SetPassState(RenderDevice* device, RenderPass pass)
+	{
+		switch (pass)
+		{
+		case RenderPass::Opaque:
+			device->SetBlend(false);
+			device->SetDepthMask(true);
+			break;
+		case RenderPass::Cutout:
+			// The holes are discarded by the shader, so there's nothing to blend
+			device->SetBlend(false);
+			device->SetDepthMask(true);
+			break;
+		case RenderPass::Translucent:
+			// Tested against the depth but doesn't write it, so what's behind still gets drawn
+			device->SetBlend(true);
+			device->SetDepthMask(false);
+			break;
+		}
+	}
+}
+
+ChunkRenderer::ChunkRenderer()
+{
+	// Enough for a render distance of 5 with room to spare, the arena grows past this if needed
+	arena_ = new MeshArena(1024 * 1024, 1536 * 1024);
+	commandBuilder_ = DrawCommandBuilder();
+	renderQueue_ = RenderQueue();
+	stats_ = {};
+
+	// Same uniforms and bindings as the chunk program, so the frame data bound by StartDrawBatch is shared
+	RenderDevice* device = RenderDevice::Get();
+	cutoutShaderProgram_ = CreateShader("./Assets/mesh.vert", "./Assets/mesh.frag", "#define ALPHA_TEST\n");
+	ShaderReflection reflection = ShaderReflection(cutoutShaderProgram_);
+	device->UseProgram(cutoutShaderProgram_);
+	device->Uniform1i(reflection.GetUniformLocation("texture1"), 0);
+	device->UseProgram(0);
+
+	unsigned int vao = arena_->GetVertexArray();
+	device->VertexArrayAttribIFormat(vao, drawIndexAttribute, 1, GL_UNSIGNED_INT, 0);
+	device->VertexArrayAttribBinding(vao, drawIndexAttribute, drawIndexBufferBinding);
+	device->VertexArrayBindingDivisor(vao, drawIndexBufferBinding, 1);
+	device->EnableVertexArrayAttrib(vao, drawIndexAttribute);
+
+	maxDraws_ = 0;
+	indirectBuffer_ = 0;
+	drawDataBuffer_ = 0;
+	drawIndexBuffer_ = 0;
+	ReserveDraws(512);
+}
+
+ChunkRenderer::~ChunkRenderer()
+{
+	RenderDevice* device = RenderDevice::Get();
+	device->DeleteBuffer(indirectBuffer_);
+	device->DeleteBuffer(drawDataBuffer_);
+	device->DeleteBuffer(drawIndexBuffer_);
+	device->DeleteProgram(cutoutShaderProgram_);
+	delete arena_;
+}
+
+void ChunkRenderer::ReserveDraws(int numDraws)
+{
+	if (numDraws <= maxDraws_)
+	{
+		return;
+	}
+
+	while (maxDraws_ < numDraws)
+	{
+		maxDraws_ = maxDraws_ == 0 ? numDraws : maxDraws_ * 2;
+	}
+
+	RenderDevice* device = RenderDevice::Get();
+	device->DeleteBuffer(indirectBuffer_);
+	device->DeleteBuffer(drawDataBuffer_);
+	device->DeleteBuffer(drawIndexBuffer_);
+
+	indirectBuffer_ = device->CreateBuffer();
+	drawDataBuffer_ = device->CreateBuffer();
+	drawIndexBuffer_ = device->CreateBuffer();
+	device->BufferData(indirectBuffer_, maxDraws_ * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+	device->BufferData(drawDataBuffer_, maxDraws_ * sizeof(ChunkDrawData), nullptr, GL_STREAM_DRAW);
+
+	// Never changes, instance i of a command with base instance i reads i
+	std::vector<unsigned int> drawIndices = std::vector<unsigned int>(maxDraws_);
+	for (int i = 0; i < maxDraws_; i++)
+	{
+		drawIndices[i] = i;
+	}
+	device->BufferData(drawIndexBuffer_, drawIndices.size() * sizeof(unsigned int), drawIndices.data(), GL_STATIC_DRAW);
+	device->VertexArrayVertexBuffer(arena_->GetVertexArray(), drawIndexBufferBinding, drawIndexBuffer_, 0, sizeof(unsigned int));
+}
+
+MeshArena* ChunkRenderer::GetArena()
+{
+	return arena_;
+}
+
+void ChunkRenderer::Draw(const std::vector<Chunk*>& chunks, const std::vector<int>& visibleChunks, Texture2DArray& texture, glm::vec3 cameraPos)
+{
+	double buildStartTime = glfwGetTime();
+
+	renderQueue_.Clear();
+	for (int index : visibleChunks)
+	{
+		Chunk* chunk = chunks[index];
+		if (chunk->IsUnloaded() || chunk->GetMesh()->GetArenaHandle() < 0)
+		{
+			continue;
+		}
+
+		// One draw for each pass the chunk has blocks in, the draw index keeps both
+		const PassIndexCounts& passIndexCounts = chunk->GetMesh()->GetPassIndexCountsOnGPU();
+		float depth = glm::distance(glm::vec3(chunk->GetOrigin()), cameraPos);
+		for (int pass = 0; pass < NUM_RENDER_PASSES; pass++)
+		{
+			if (passIndexCounts[pass] > 0)
+			{
+				renderQueue_.Add(static_cast<RenderPass>(pass), static_cast<uint16_t>(MeshType::Chunk), depth, index * NUM_RENDER_PASSES + pass);
+			}
+		}
+	}
+	renderQueue_.Sort();
+
+	// Commands are built in queue order, so each pass's draws are one run of them
+	commandBuilder_.Clear();
+	const std::vector<RenderItem>& items = renderQueue_.GetItems();
+	int passFirstDraws[NUM_RENDER_PASSES];
+	int passNumDraws[NUM_RENDER_PASSES];
+	for (int pass = 0; pass < NUM_RENDER_PASSES; pass++)
+	{
+		passFirstDraws[pass] = commandBuilder_.GetNumDraws();
+
+		RenderQueueRange range = renderQueue_.GetPassRange(static_cast<RenderPass>(pass));
+		for (int i = range.first; i < range.first + range.count; i++)
+		{
+			Chunk* chunk = chunks[items[i].drawIndex / NUM_RENDER_PASSES];
+			Mesh* mesh = chunk->GetMesh();
+			const MeshArenaAllocation& allocation = arena_->GetAllocation(mesh->GetArenaHandle());
+
+			// The mesh's indices are in pass order, so this pass's start after the earlier passes'
+			const PassIndexCounts& passIndexCounts = mesh->GetPassIndexCountsOnGPU();
+			uint32_t firstIndex = allocation.firstIndex;
+			for (int earlierPass = 0; earlierPass < pass; earlierPass++)
+			{
+				firstIndex += passIndexCounts[earlierPass];
+			}
+			commandBuilder_.Add({ chunk->GetOrigin(), firstIndex, passIndexCounts[pass], static_cast<int32_t>(allocation.firstVertex) });
+		}
+
+		passNumDraws[pass] = commandBuilder_.GetNumDraws() - passFirstDraws[pass];
+	}
+
+	stats_.numChunks = chunks.size();
+	stats_.numDraws = commandBuilder_.GetNumDraws();
+	stats_.numCalls = 0;
+	stats_.buildTime = glfwGetTime() - buildStartTime;
+
+	if (stats_.numDraws == 0)
+	{
+		return;
+	}
+
+	ReserveDraws(stats_.numDraws);
+
+	// Orphan the last frame's data so the driver doesn't wait for the GPU to finish with it
+	const std::vector<DrawElementsIndirectCommand>& commands = commandBuilder_.GetCommands();
+	const std::vector<ChunkDrawData>& drawData = commandBuilder_.GetDrawData();
+	RenderDevice* device = RenderDevice::Get();
+	device->BufferData(indirectBuffer_, maxDraws_ * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+	device->BufferSubData(indirectBuffer_, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+	device->BufferData(drawDataBuffer_, maxDraws_ * sizeof(ChunkDrawData), nullptr, GL_STREAM_DRAW);
+	device->BufferSubData(drawDataBuffer_, 0, drawData.size() * sizeof(ChunkDrawData), drawData.data());
+
+	texture.Bind(GL_TEXTURE0);
+	device->BindVertexArray(arena_->GetVertexArray());
+	device->BindBufferBase(GL_SHADER_STORAGE_BUFFER, drawDataBinding, drawDataBuffer_);
+	device->BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer_);
+
+	shader chunkShaderProgram = Mesh::GetCommonData(MeshType::Chunk).shaderProgram;
+	for (int pass = 0; pass < NUM_RENDER_PASSES; pass++)
+	{
+		if (passNumDraws[pass] == 0)
+		{
+			continue;
+		}
+
+		SetPassState(device, static_cast<RenderPass>(pass));
+		device->UseProgram(pass == static_cast<int>(RenderPass::Cutout) ? cutoutShaderProgram_ : chunkShaderProgram);
+		size_t firstCommand = passFirstDraws[pass] * sizeof(DrawElementsIndirectCommand);
+		device->MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, firstCommand, passNumDraws[pass], 0);
+		stats_.numCalls++;
+	}
+
+	// Back to what the rest of the frame expects
+	device->SetBlend(true);
+	device->SetDepthMask(true);
+	device->UseProgram(chunkShaderProgram);
+
+	device->BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	device->BindVertexArray(0);
+	texture.Unbind(GL_TEXTURE0);
+}
+
+ChunkRenderStats ChunkRenderer::GetStats()
+{
+	return stats_;
+}
+
+RenderQueueStats ChunkRenderer::GetQueueStats()
+{
+	return renderQueue_.GetStats();
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+
+#include "drawCommands.h"
+#include "meshArena.h"
+#include "renderQueue.h"
+#include "shader.h"
+#include "texture.h"
+
+class Chunk;
+
+struct ChunkRenderStats
+{
+	// For the last frame
+	int numDraws; // one per pass a chunk has indices in
+	int numCalls; // one per pass that has draws
+	int numChunks;
+	double buildTime; // seconds spent building the commands
+};
+
+/*
+ * Draws every chunk with one glMultiDrawElementsIndirect call per pass.
+ *
+ * The chunk meshes all live in the renderer's MeshArena, so they share
+ * a VAO. Each chunk's indices are sorted by pass (see
+ * Chunk::GetBlockRenderPass), so each pass a chunk has blocks in is one
+ * range of its mesh and one draw. Each frame those draws are sorted by
+ * a RenderQueue, so each pass's draws are together and go front to
+ * back, then turned into indirect draw commands in that order (see
+ * DrawCommandBuilder).
+ *
+ * Only the translucent pass blends. Opaque blocks are drawn without it,
+ * and cutout blocks like leaves with a variant of mesh.frag that throws
+ * away their see-through texels instead, so both write depth and the
+ * opaque pass keeps early depth testing.
+ * The chunk origins go into a shader storage buffer that mesh.vert
+ * indexes by draw.
+ *
+ * OpenGL 4.5 has no gl_DrawID without an extension, so each command's
+ * base instance is its draw index and an instanced attribute reading a
+ * buffer of 0, 1, 2, ... passes it to the shader instead.
+ */
+class ChunkRenderer
+{
+	MeshArena* arena_;
+	DrawCommandBuilder commandBuilder_;
+	RenderQueue renderQueue_;
+	shader cutoutShaderProgram_; // mesh.frag with ALPHA_TEST
+
+	unsigned int indirectBuffer_;
+	unsigned int drawDataBuffer_;
+	unsigned int drawIndexBuffer_;
+	int maxDraws_;
+
+	ChunkRenderStats stats_;
+
+	// Grows the per draw buffers so they can hold at least this many draws
+	void ReserveDraws(int numDraws);
+public:
+	ChunkRenderer();
+	~ChunkRenderer();
+
+	MeshArena* GetArena();
+
+	/*
+	 * Draws the visible chunks that are loaded, visibleChunks are indices
+	 * into chunks. Call this between Mesh::StartDrawBatch(MeshType::Chunk)
+	 * and EndDrawBatch. Blending is left on and the chunk shader program
+	 * in use afterwards.
+	 */
+	void Draw(const std::vector<Chunk*>& chunks, const std::vector<int>& visibleChunks, Texture2DArray& texture, glm::vec3 cameraPos);
+
+	ChunkRenderStats GetStats();
+	RenderQueueStats GetQueueStats();
+};
@@ -0,0 +1,89 @@
+#include "chunkStore.h"
+
+#include <filesystem>
+#include <stdio.h>
+
+#include "chunkCodec.h"
+#include "fileUtils.h"
+#include "logging.h"
+
+bool ChunkKey::operator==(ChunkKey const& chunkKey) const
+{
+	return x == chunkKey.x && y == chunkKey.y && z == chunkKey.z;
+}
+
+size_t ChunkKeyHash::operator()(ChunkKey const& chunkKey) const
+{
+	size_t hash = std::hash<int>()(chunkKey.x);
+	hash = hash * 31 + std::hash<int>()(chunkKey.y);
+	hash = hash * 31 + std::hash<int>()(chunkKey.z);
+	return hash;
+}
+
+ChunkStore::ChunkStore(const std::string& directory)
+{
+	directory_ = directory;
+	savedChunks_ = std::unordered_set<ChunkKey, ChunkKeyHash>();
+
+	if (!FileUtils::CreateDirectories(directory_))
+	{
+		LOG("Couldn't create the chunk save folder %s\n", directory_.c_str());
+		return;
+	}
+
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory_, error))
+	{
+		ChunkKey chunkKey{};
+		if (sscanf(entry.path().filename().string().c_str(), "%d_%d_%d.chunk", &chunkKey.x, &chunkKey.y, &chunkKey.z) == 3)
+		{
+			savedChunks_.insert(chunkKey);
+		}
+	}
+}
+
+bool ChunkStore::Save(const ChunkKey& chunkKey, const std::vector<uint8_t>& blocks, size_t* bytesWrittenOut)
+{
+	std::vector<uint8_t> data = ChunkCodec::Encode(blocks);
+	if (!FileUtils::WriteFileDurably(GetChunkPath(chunkKey), data))
+	{
+		return false;
+	}
+
+	if (bytesWrittenOut)
+	{
+		*bytesWrittenOut = data.size();
+	}
+
+	std::lock_guard<std::mutex> lock(savedChunksMutex_);
+	savedChunks_.insert(chunkKey);
+	return true;
+}
+
+bool ChunkStore::Load(const ChunkKey& chunkKey, std::vector<uint8_t>& blocksOut)
+{
+	if (!HasSave(chunkKey))
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> data = std::vector<uint8_t>();
+	if (!FileUtils::ReadFile(GetChunkPath(chunkKey), data) || !ChunkCodec::Decode(data, blocksOut))
+	{
+		LOG("Couldn't load the save for chunk (%d, %d, %d)\n", chunkKey.x, chunkKey.y, chunkKey.z);
+		return false;
+	}
+
+	return true;
+}
+
+bool ChunkStore::HasSave(const ChunkKey& chunkKey)
+{
+	std::lock_guard<std::mutex> lock(savedChunksMutex_);
+	return savedChunks_.find(chunkKey) != savedChunks_.end();
+}
+
+std::string ChunkStore::GetChunkPath(const ChunkKey& chunkKey)
+{
+	return directory_ + "/" + std::to_string(chunkKey.x) + "_" + std::to_string(chunkKey.y) + "_" + std::to_string(chunkKey.z) + ".chunk";
+}
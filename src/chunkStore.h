@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * Identifies a chunk by its position in chunks rather than
+ * blocks, i.e. the chunk at (32, -16, 48) has the key (2, -1, 3).
+ */
+struct ChunkKey
+{
+	int x;
+	int y;
+	int z;
+
+	bool operator==(ChunkKey const& chunkKey) const;
+};
+
+struct ChunkKeyHash
+{
+	size_t operator()(ChunkKey const& chunkKey) const;
+};
+
+/*
+ * Saves and loads chunk blocks (in fill order) to a folder with one
+ * file per chunk, encoded with the ChunkCodec. It's safe to use from
+ * the worker threads.
+ */
+class ChunkStore
+{
+	std::string directory_;
+
+	// The chunks that have a save, so loading a chunk that
+	// doesn't have one never touches the disk.
+	std::unordered_set<ChunkKey, ChunkKeyHash> savedChunks_;
+	std::mutex savedChunksMutex_;
+public:
+	ChunkStore(const std::string& directory);
+
+	bool Save(const ChunkKey& chunkKey, const std::vector<uint8_t>& blocks, size_t* bytesWrittenOut = nullptr);
+	bool Load(const ChunkKey& chunkKey, std::vector<uint8_t>& blocksOut);
+	bool HasSave(const ChunkKey& chunkKey);
+
+	std::string GetChunkPath(const ChunkKey& chunkKey);
+};
@@ -0,0 +1,326 @@
+#include "chunkVisibility.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "chunkLayout.h"
+
+// Indexed by ChunkFace
+static const glm::ivec3 kFaceOffsets[6] = {
+	glm::ivec3(-1, 0, 0),
+	glm::ivec3(1, 0, 0),
+	glm::ivec3(0, -1, 0),
+	glm::ivec3(0, 1, 0),
+	glm::ivec3(0, 0, -1),
+	glm::ivec3(0, 0, 1)
+};
+
+bool ChunkFaceConnections::AreConnected(ChunkFace a, ChunkFace b) const
+{
+	return (bits >> (static_cast<int>(a) * 6 + static_cast<int>(b))) & 1;
+}
+
+void ChunkFaceConnections::Connect(ChunkFace a, ChunkFace b)
+{
+	bits |= uint64_t(1) << (static_cast<int>(a) * 6 + static_cast<int>(b));
+	bits |= uint64_t(1) << (static_cast<int>(b) * 6 + static_cast<int>(a));
+}
+
+ChunkFaceConnections ChunkFaceConnections::All()
+{
+	return { (uint64_t(1) << 36) - 1 };
+}
+
+ChunkFaceConnections ChunkFaceConnections::None()
+{
+	return { 0 };
+}
+
+ChunkVisibilityGraph::ChunkVisibilityGraph()
+{
+	min_ = glm::ivec3(0, 0, 0);
+	dimensions_ = glm::ivec3(0, 0, 0);
+	connections_ = std::vector<ChunkFaceConnections>();
+	isReachable_ = std::vector<uint8_t>();
+	enteredFaces_ = std::vector<uint8_t>();
+	queue_ = std::vector<Step>();
+}
+
+void ChunkVisibilityGraph::Reset(const glm::ivec3& min, const glm::ivec3& max)
+{
+	min_ = min;
+	dimensions_ = glm::ivec3(max.x - min.x + 1, max.y - min.y + 1, max.z - min.z + 1);
+
+	size_t numCells = static_cast<size_t>(dimensions_.x) * dimensions_.y * dimensions_.z;
+	connections_.assign(numCells, ChunkFaceConnections::All());
+	isReachable_.assign(numCells, 0);
+	enteredFaces_.assign(numCells, 0);
+}
+
+int ChunkVisibilityGraph::GetCell(const glm::ivec3& position)
+{
+	int x = position.x - min_.x;
+	int y = position.y - min_.y;
+	int z = position.z - min_.z;
+	if (x < 0 || y < 0 || z < 0 || x >= dimensions_.x || y >= dimensions_.y || z >= dimensions_.z)
+	{
+		return -1;
+	}
+
+	return (z * dimensions_.y + y) * dimensions_.x + x;
+}
+
+void ChunkVisibilityGraph::SetChunk(const glm::ivec3& position, ChunkFaceConnections connections)
+{
+	int cell = GetCell(position);
+	if (cell >= 0)
+	{
+		connections_[cell] = connections;
+	}
+}
+
+bool ChunkVisibilityGraph::Search(const glm::ivec3& cameraChunk)
+{
+	std::fill(isReachable_.begin(), isReachable_.end(), 0);
+	std::fill(enteredFaces_.begin(), enteredFaces_.end(), 0);
+	queue_.clear();
+
+	int start = GetCell(cameraChunk);
+	if (start < 0)
+	{
+		return false;
+	}
+
+	isReachable_[start] = 1;
+	queue_.push_back({ cameraChunk, start, -1, 0 });
+
+	// A chunk can be queued once for each face it's entered through, as
+	// what can be seen through it depends on which way you're looking in
+	for (size_t next = 0; next < queue_.size(); next++)
+	{
+		Step step = queue_[next];
+		for (int face = 0; face < 6; face++)
+		{
+			int oppositeFace = face ^ 1;
+
+			// Never head back towards the camera
+			if (step.directions & (1 << oppositeFace))
+			{
+				continue;
+			}
+
+			if (step.enteredFace != -1 && !connections_[step.cell].AreConnected(static_cast<ChunkFace>(step.enteredFace), static_cast<ChunkFace>(face)))
+			{
+				continue;
+			}
+
+			glm::ivec3 neighbour = step.position + kFaceOffsets[face];
+			int cell = GetCell(neighbour);
+			if (cell < 0 || (enteredFaces_[cell] & (1 << oppositeFace)))
+			{
+				continue;
+			}
+
+			enteredFaces_[cell] |= 1 << oppositeFace;
+			isReachable_[cell] = 1;
+			queue_.push_back({ neighbour, cell, oppositeFace, static_cast<uint8_t>(step.directions | (1 << face)) });
+		}
+	}
+
+	return true;
+}
+
+bool ChunkVisibilityGraph::IsReachable(const glm::ivec3& position)
+{
+	int cell = GetCell(position);
+	return cell >= 0 && isReachable_[cell];
+}
+
+ChunkFaceConnections ChunkVisibilityGraph::BuildFaceConnections(const std::vector<uint8_t>& isSolid, int size)
+{
+	ChunkFaceConnections connections = ChunkFaceConnections::None();
+
+	std::vector<uint8_t> isVisited = std::vector<uint8_t>(isSolid);
+	std::vector<int> stack = std::vector<int>();
+
+	int numBlocks = size * size * size;
+	for (int startIndex = 0; startIndex < numBlocks; startIndex++)
+	{
+		if (isVisited[startIndex])
+		{
+			continue;
+		}
+
+		// Flood fill the open blocks joined to this one, noting the faces they touch
+		int touchedFaces = 0;
+		isVisited[startIndex] = 1;
+		stack.push_back(startIndex);
+		while (!stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+
+			// Fill order is (z * size + x) * size + y
+			int y = index % size;
+			int x = (index / size) % size;
+			int z = index / (size * size);
+
+			touchedFaces |= (x == 0) << static_cast<int>(ChunkFace::NegativeX);
+			touchedFaces |= (x == size - 1) << static_cast<int>(ChunkFace::PositiveX);
+			touchedFaces |= (y == 0) << static_cast<int>(ChunkFace::NegativeY);
+			touchedFaces |= (y == size - 1) << static_cast<int>(ChunkFace::PositiveY);
+			touchedFaces |= (z == 0) << static_cast<int>(ChunkFace::NegativeZ);
+			touchedFaces |= (z == size - 1) << static_cast<int>(ChunkFace::PositiveZ);
+
+			for (int face = 0; face < 6; face++)
+			{
+				int neighbourX = x + kFaceOffsets[face].x;
+				int neighbourY = y + kFaceOffsets[face].y;
+				int neighbourZ = z + kFaceOffsets[face].z;
+				if (neighbourX < 0 || neighbourY < 0 || neighbourZ < 0 || neighbourX >= size || neighbourY >= size || neighbourZ >= size)
+				{
+					continue;
+				}
+
+				int neighbourIndex = (neighbourZ * size + neighbourX) * size + neighbourY;
+				if (!isVisited[neighbourIndex])
+				{
+					isVisited[neighbourIndex] = 1;
+					stack.push_back(neighbourIndex);
+				}
+			}
+		}
+
+		for (int a = 0; a < 6; a++)
+		{
+			for (int b = a; b < 6; b++)
+			{
+				if ((touchedFaces & (1 << a)) && (touchedFaces & (1 << b)))
+				{
+					connections.Connect(static_cast<ChunkFace>(a), static_cast<ChunkFace>(b));
+				}
+			}
+		}
+
+		if (connections.bits == ChunkFaceConnections::All().bits)
+		{
+			break;
+		}
+	}
+
+	return connections;
+}
+
+bool ChunkVisibilityGraph::RunBenchmark(int renderDistance)
+{
+	const int numSearches = 100;
+
+	// Solid underground with a tunnel along x in every third row, the
+	// ground's bottom half is solid and everything above it is air
+	std::vector<uint8_t> solid = std::vector<uint8_t>(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE, 1);
+	std::vector<uint8_t> tunnel = std::vector<uint8_t>(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE, 1);
+	std::vector<uint8_t> ground = std::vector<uint8_t>(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE, 1);
+	std::vector<uint8_t> air = std::vector<uint8_t>(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE, 0);
+	for (int z = 0; z < CHUNK_SIZE; z++)
+	{
+		for (int x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int y = 0; y < CHUNK_SIZE; y++)
+			{
+				int index = (z * CHUNK_SIZE + x) * CHUNK_SIZE + y;
+				tunnel[index] = !(y >= 6 && y < 10 && z >= 6 && z < 10);
+				ground[index] = y < CHUNK_SIZE / 2;
+			}
+		}
+	}
+
+	ChunkFaceConnections solidConnections = BuildFaceConnections(solid, CHUNK_SIZE);
+	ChunkFaceConnections tunnelConnections = BuildFaceConnections(tunnel, CHUNK_SIZE);
+	ChunkFaceConnections groundConnections = BuildFaceConnections(ground, CHUNK_SIZE);
+	ChunkFaceConnections airConnections = BuildFaceConnections(air, CHUNK_SIZE);
+
+	bool isCorrect = true;
+	if (solidConnections.bits != 0 || airConnections.bits != ChunkFaceConnections::All().bits ||
+		!tunnelConnections.AreConnected(ChunkFace::NegativeX, ChunkFace::PositiveX) || tunnelConnections.AreConnected(ChunkFace::NegativeX, ChunkFace::PositiveY) ||
+		!groundConnections.AreConnected(ChunkFace::PositiveY, ChunkFace::NegativeZ) || groundConnections.AreConnected(ChunkFace::NegativeY, ChunkFace::PositiveY))
+	{
+		printf("The face connections are wrong\n");
+		isCorrect = false;
+	}
+
+	auto isTunnelRow = [](int z) {
+		return ((z % 3) + 3) % 3 == 0;
+	};
+
+	ChunkVisibilityGraph graph = ChunkVisibilityGraph();
+	glm::ivec3 min = glm::ivec3(-renderDistance, MIN_CHUNK_Y, -renderDistance);
+	glm::ivec3 max = glm::ivec3(renderDistance, MAX_CHUNK_Y, renderDistance);
+	graph.Reset(min, max);
+	for (int z = min.z; z <= max.z; z++)
+	{
+		for (int x = min.x; x <= max.x; x++)
+		{
+			graph.SetChunk(glm::ivec3(x, -1, z), isTunnelRow(z) ? tunnelConnections : solidConnections);
+			graph.SetChunk(glm::ivec3(x, 0, z), groundConnections);
+			graph.SetChunk(glm::ivec3(x, 1, z), airConnections);
+			graph.SetChunk(glm::ivec3(x, 2, z), airConnections);
+		}
+	}
+
+	int numChunks = (max.x - min.x + 1) * (max.y - min.y + 1) * (max.z - min.z + 1);
+	glm::ivec3 cameras[2] = {
+		glm::ivec3(1, 0, 1), // Standing on the ground
+		glm::ivec3(1, -1, 3) // In a tunnel
+	};
+
+	for (const glm::ivec3& camera : cameras)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		for (int search = 0; search < numSearches; search++)
+		{
+			graph.Search(camera);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		// From the ground everything above ground is in view, underground only the chunk right below.
+		// From a tunnel it's the tunnel and the chunks around the camera's chunk.
+		int numReachable = 0;
+		for (int z = min.z; z <= max.z; z++)
+		{
+			for (int y = min.y; y <= max.y; y++)
+			{
+				for (int x = min.x; x <= max.x; x++)
+				{
+					glm::ivec3 position = glm::ivec3(x, y, z);
+					glm::ivec3 offset = glm::ivec3(x - camera.x, y - camera.y, z - camera.z);
+					bool isNextToCamera = abs(offset.x) + abs(offset.y) + abs(offset.z) <= 1;
+
+					bool shouldBeReachable = false;
+					if (camera.y >= 0)
+					{
+						shouldBeReachable = y >= 0 || isNextToCamera;
+					}
+					else
+					{
+						shouldBeReachable = (y == camera.y && z == camera.z) || isNextToCamera;
+					}
+
+					bool isReachable = graph.IsReachable(position);
+					numReachable += isReachable;
+					if (isReachable != shouldBeReachable)
+					{
+						printf("Chunk (%d, %d, %d) should%s be reachable from (%d, %d, %d)\n", x, y, z, shouldBeReachable ? "" : "n't", camera.x, camera.y, camera.z);
+						isCorrect = false;
+					}
+				}
+			}
+		}
+
+		printf("From (%d, %d, %d): %d of %d chunks reachable, %.3fms per search\n",
+			camera.x, camera.y, camera.z, numReachable, numChunks, seconds * 1000.0 / numSearches);
+	}
+
+	return isCorrect;
+}
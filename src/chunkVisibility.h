@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+enum class ChunkFace
+{
+	NegativeX,
+	PositiveX,
+	NegativeY,
+	PositiveY,
+	NegativeZ,
+	PositiveZ
+};
+
+// Which faces of a chunk can be seen from which, through the open blocks inside it
+struct ChunkFaceConnections
+{
+	// Bit a * 6 + b is set when faces a and b are connected
+	uint64_t bits;
+
+	bool AreConnected(ChunkFace a, ChunkFace b) const;
+	void Connect(ChunkFace a, ChunkFace b);
+
+	// For chunks that are all open, or that we don't know about yet
+	static ChunkFaceConnections All();
+	static ChunkFaceConnections None();
+};
+
+/*
+ * Culls chunks that can't be seen through open space from the camera's
+ * chunk, i.e. caves and the underground chunks that are completely
+ * enclosed. It doesn't need a depth buffer or anything from the GPU.
+ *
+ * Each chunk records which of its faces are joined through its open
+ * blocks when it's meshed (BuildFaceConnections). The graph is then
+ * searched breadth first from the camera's chunk: a chunk entered
+ * through one face can only be left through the faces connected to it,
+ * and the search never steps back towards the camera, so it doesn't
+ * wrap around behind walls.
+ *
+ * This is pure CPU, chunk positions are in chunks (see Chunk::GetKey).
+ */
+class ChunkVisibilityGraph
+{
+	struct Step
+	{
+		glm::ivec3 position;
+		int cell;
+		int enteredFace; // -1 for the camera's chunk
+		uint8_t directions; // faces that have been stepped out of to get here
+	};
+
+	glm::ivec3 min_;
+	glm::ivec3 dimensions_;
+
+	std::vector<ChunkFaceConnections> connections_;
+	std::vector<uint8_t> isReachable_;
+	std::vector<uint8_t> enteredFaces_;
+	std::vector<Step> queue_;
+
+	int GetCell(const glm::ivec3& position);
+public:
+	ChunkVisibilityGraph();
+
+	// Empties the graph and sizes it to hold the chunks from min to max, inclusive. Unset chunks let everything through.
+	void Reset(const glm::ivec3& min, const glm::ivec3& max);
+	void SetChunk(const glm::ivec3& position, ChunkFaceConnections connections);
+
+	/*
+	 * Finds the chunks that can be seen from the camera's chunk. Returns
+	 * false if the camera is outside the graph, then nothing can be culled.
+	 */
+	bool Search(const glm::ivec3& cameraChunk);
+
+	// Whether the last search reached the chunk
+	bool IsReachable(const glm::ivec3& position);
+
+	// isSolid is in chunk fill order (z, then x, then y), the rest of the blocks are open
+	static ChunkFaceConnections BuildFaceConnections(const std::vector<uint8_t>& isSolid, int size);
+
+	/*
+	 * Builds a world of enclosed caves under open ground, searches from
+	 * several spots and prints how much was culled and how long it
+	 * took. Returns false if a chunk that an open path leads to wasn't
+	 * reached, or if a sealed off chunk was.
+	 */
+	static bool RunBenchmark(int renderDistance);
+};
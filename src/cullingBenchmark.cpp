@@ -0,0 +1,43 @@
+#include "cullingBenchmark.h"
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "chunkLayout.h"
+
+std::vector<AABB> CullingBenchmark::CreateChunkBoxes(int renderDistance)
+{
+	std::vector<AABB> boxes = std::vector<AABB>();
+	for (int chunkZ = -renderDistance; chunkZ <= renderDistance; chunkZ++)
+	{
+		for (int chunkX = -renderDistance; chunkX <= renderDistance; chunkX++)
+		{
+			for (int chunkY = MIN_CHUNK_Y; chunkY <= MAX_CHUNK_Y; chunkY++)
+			{
+				AABB box{};
+				box.origin = glm::vec3(chunkX * CHUNK_SIZE, chunkY * CHUNK_SIZE, chunkZ * CHUNK_SIZE);
+				box.size = glm::vec3(CHUNK_SIZE / 2.0f);
+				boxes.push_back(box);
+			}
+		}
+	}
+
+	return boxes;
+}
+
+std::vector<Frustum> CullingBenchmark::CreateFrustums(int renderDistance, int numFrames)
+{
+	float zFar = renderDistance * CHUNK_SIZE * 1.5f;
+	std::vector<Frustum> frustums = std::vector<Frustum>();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		float yaw = frame * 6.2831853f / numFrames;
+		float pitch = -0.3f + 0.2f * sinf(frame * 0.1f);
+		glm::vec3 forward = glm::vec3(cosf(yaw) * cosf(pitch), sinf(pitch), sinf(yaw) * cosf(pitch));
+		glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+		glm::vec3 up = glm::cross(right, forward);
+		frustums.push_back(CreateFrustum(glm::vec3(3.0f, 40.0f, -5.0f), forward, right, up, glm::radians(45.0f), 16.0f / 9.0f, 0.1f, zFar));
+	}
+
+	return frustums;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <vector>
+
+#include "frustum.h"
+
+/*
+ * The scene the culling benchmarks share, so the flat culler and the
+ * quadtree are timed against the same chunks and the same camera.
+ */
+namespace CullingBenchmark
+{
+	// A box per chunk of a square of chunk columns around the origin
+	std::vector<AABB> CreateChunkBoxes(int renderDistance);
+
+	// Turning on the spot and looking a little down, like walking around
+	std::vector<Frustum> CreateFrustums(int renderDistance, int numFrames);
+}
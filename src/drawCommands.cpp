@@ -0,0 +1,159 @@
+#include "drawCommands.h"
+
+#include <chrono>
+#include <cstdio>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "chunkLayout.h"
+
+DrawCommandBuilder::DrawCommandBuilder()
+{
+	commands_ = std::vector<DrawElementsIndirectCommand>();
+	drawData_ = std::vector<ChunkDrawData>();
+}
+
+void DrawCommandBuilder::Clear()
+{
+	commands_.clear();
+	drawData_.clear();
+}
+
+void DrawCommandBuilder::Add(const ChunkDrawRange& range)
+{
+	if (range.numIndices == 0)
+	{
+		return;
+	}
+
+	// Filled in place
+	uint32_t drawIndex = commands_.size();
+	DrawElementsIndirectCommand& command = commands_.emplace_back();
+	command.count = range.numIndices;
+	command.instanceCount = 1;
+	command.firstIndex = range.firstIndex;
+	command.baseVertex = range.baseVertex;
+	command.baseInstance = drawIndex;
+
+	ChunkDrawData& drawData = drawData_.emplace_back();
+	drawData.originX = range.origin.x;
+	drawData.originY = range.origin.y;
+	drawData.originZ = range.origin.z;
+	drawData.padding = 0;
+}
+
+const std::vector<DrawElementsIndirectCommand>& DrawCommandBuilder::GetCommands()
+{
+	return commands_;
+}
+
+const std::vector<ChunkDrawData>& DrawCommandBuilder::GetDrawData()
+{
+	return drawData_;
+}
+
+int DrawCommandBuilder::GetNumDraws()
+{
+	return commands_.size();
+}
+
+bool DrawCommandBuilder::RunBenchmark(int renderDistance)
+{
+	const int numFrames = 1000;
+
+	// Glue the old loop made per chunk: 2 uniform lookups, 2 uniform
+	// sets, texture bind and unbind, VAO bind, EBO bind, draw and use program
+	const int callsPerChunkBefore = 10;
+
+	// Use program, texture bind, VAO bind, 2 buffer uploads, 2 buffer binds and the draw
+	const int callsPerFrameAfter = 8;
+
+	std::vector<ChunkDrawRange> ranges = std::vector<ChunkDrawRange>();
+	uint32_t firstIndex = 0;
+	int32_t baseVertex = 0;
+	for (int x = -renderDistance; x <= renderDistance; x++)
+	{
+		for (int z = -renderDistance; z <= renderDistance; z++)
+		{
+			for (int y = MIN_CHUNK_Y; y <= MAX_CHUNK_Y; y++)
+			{
+				// Roughly what a surface chunk meshes to, air chunks have nothing
+				uint32_t numIndices = y == MAX_CHUNK_Y ? 0 : 3000 + ((x * 31 + z * 17 + y) & 1023) * 6;
+				uint32_t numVertices = numIndices / 6 * 4;
+
+				ranges.push_back({ glm::ivec3(x * CHUNK_SIZE, y * CHUNK_SIZE, z * CHUNK_SIZE), firstIndex, numIndices, baseVertex });
+				firstIndex += numIndices;
+				baseVertex += numVertices;
+			}
+		}
+	}
+
+	// A stand-in for the old per chunk uniform loop, it builds the same model
+	// matrices but makes none of the GL calls. The matrices are summed and
+	// printed so they can't be optimised away.
+	float modelSum = 0.0f;
+	int numDrawsBefore = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		numDrawsBefore = 0;
+		for (const ChunkDrawRange& range : ranges)
+		{
+			glm::mat4 model = glm::mat4(1.0f);
+			model = glm::translate(model, glm::vec3(range.origin));
+			model = glm::rotate(model, 0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+			model = glm::rotate(model, 0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+			model = glm::rotate(model, 0.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+			model = glm::scale(model, glm::vec3(1.0f));
+			const float* modelData = glm::value_ptr(model);
+			for (int i = 0; i < 16; i++)
+			{
+				modelSum += modelData[i];
+			}
+			numDrawsBefore++;
+		}
+	}
+	double secondsBefore = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	DrawCommandBuilder builder = DrawCommandBuilder();
+	startTime = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		builder.Clear();
+		for (const ChunkDrawRange& range : ranges)
+		{
+			builder.Add(range);
+		}
+	}
+	double secondsAfter = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	// Every non-empty chunk should have a command pointing at its own range
+	bool isCorrect = true;
+	int commandIndex = 0;
+	for (const ChunkDrawRange& range : ranges)
+	{
+		if (range.numIndices == 0)
+		{
+			continue;
+		}
+
+		const DrawElementsIndirectCommand& command = builder.GetCommands()[commandIndex];
+		const ChunkDrawData& drawData = builder.GetDrawData()[commandIndex];
+		if (command.count != range.numIndices || command.firstIndex != range.firstIndex || command.baseVertex != range.baseVertex ||
+			command.baseInstance != static_cast<uint32_t>(commandIndex) || drawData.originY != range.origin.y)
+		{
+			printf("Command %d doesn't match its chunk\n", commandIndex);
+			isCorrect = false;
+			break;
+		}
+		commandIndex++;
+	}
+
+	printf("%d chunks, %d non-empty\n", static_cast<int>(ranges.size()), builder.GetNumDraws());
+	printf("Per chunk loop (synthetic, model matrices only, no GL calls made): %.1fus per frame, %d draws, %d GL calls it would make (matrix sum %g)\n",
+		secondsBefore / numFrames * 1000000.0, numDrawsBefore, numDrawsBefore * callsPerChunkBefore, modelSum);
+	printf("Indirect commands: %.1fus per frame, 1 draw, %d GL calls\n",
+		secondsAfter / numFrames * 1000000.0, callsPerFrameAfter);
+
+	return isCorrect && commandIndex == builder.GetNumDraws();
+}
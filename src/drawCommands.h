@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Laid out the way glMultiDrawElementsIndirect reads it
+struct DrawElementsIndirectCommand
+{
+	uint32_t count;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t baseInstance;
+};
+
+// One per draw in the chunk shader's storage buffer (std430, so padded to an ivec4)
+struct ChunkDrawData
+{
+	int32_t originX;
+	int32_t originY;
+	int32_t originZ;
+	int32_t padding;
+};
+
+// Where a chunk's mesh lives in the shared buffers
+struct ChunkDrawRange
+{
+	glm::ivec3 origin;
+	uint32_t firstIndex;
+	uint32_t numIndices;
+	int32_t baseVertex;
+};
+
+/*
+ * Builds the commands for drawing every visible chunk with one
+ * glMultiDrawElementsIndirect call. This is only the CPU side, it
+ * doesn't touch OpenGL, so it can run without a GPU.
+ *
+ * Each command draws one instance with the draw's index as its base
+ * instance. The chunk shader reads that back through an instanced
+ * attribute and uses it to look up the chunk's origin in the draw data.
+ */
+class DrawCommandBuilder
+{
+	std::vector<DrawElementsIndirectCommand> commands_;
+	std::vector<ChunkDrawData> drawData_;
+public:
+	DrawCommandBuilder();
+
+	// Call at the start of each frame, keeps the memory from the last one
+	void Clear();
+
+	// Chunks without any indices are skipped
+	void Add(const ChunkDrawRange& range);
+
+	const std::vector<DrawElementsIndirectCommand>& GetCommands();
+	const std::vector<ChunkDrawData>& GetDrawData();
+	int GetNumDraws();
+
+	/*
+	 * Compares the CPU cost of building the commands for a frame with
+	 * the per chunk work the old draw loop did (building a model matrix
+	 * and issuing around ten GL calls per chunk), for every chunk in the
+	 * render distance. Only the CPU side is timed, there's no GPU here.
+	 */
+	static bool RunBenchmark(int renderDistance);
+};
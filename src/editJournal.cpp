@@ -0,0 +1,340 @@
+#include "editJournal.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "fileUtils.h"
+#include "logging.h"
+
+namespace
+{
+	const uint8_t JOURNAL_MAGIC[4] = { 'B', 'G', 'E', 'J' };
+	const size_t HEADER_SIZE = 4;
+
+	// chunk key (3 x i32), local index (u16), block type (u8), checksum (u8)
+	const size_t RECORD_SIZE = 16;
+
+	void WriteI32(uint8_t* out, int32_t value)
+	{
+		uint32_t bits = static_cast<uint32_t>(value);
+		out[0] = static_cast<uint8_t>(bits);
+		out[1] = static_cast<uint8_t>(bits >> 8);
+		out[2] = static_cast<uint8_t>(bits >> 16);
+		out[3] = static_cast<uint8_t>(bits >> 24);
+	}
+
+	int32_t ReadI32(const uint8_t* data)
+	{
+		uint32_t bits = static_cast<uint32_t>(data[0]) |
+			(static_cast<uint32_t>(data[1]) << 8) |
+			(static_cast<uint32_t>(data[2]) << 16) |
+			(static_cast<uint32_t>(data[3]) << 24);
+		return static_cast<int32_t>(bits);
+	}
+
+	// Catches records that were only partly written before a crash
+	uint8_t GetRecordChecksum(const uint8_t* data)
+	{
+		uint8_t checksum = 0x5a;
+		for (size_t i = 0; i < RECORD_SIZE - 1; i++)
+		{
+			checksum = static_cast<uint8_t>((checksum * 31) ^ data[i]);
+		}
+		return checksum;
+	}
+
+	void WriteRecord(std::vector<uint8_t>& out, const EditRecord& record)
+	{
+		uint8_t data[RECORD_SIZE];
+		WriteI32(data, record.chunkKey.x);
+		WriteI32(data + 4, record.chunkKey.y);
+		WriteI32(data + 8, record.chunkKey.z);
+		data[12] = static_cast<uint8_t>(record.localIndex);
+		data[13] = static_cast<uint8_t>(record.localIndex >> 8);
+		data[14] = record.blockType;
+		data[15] = GetRecordChecksum(data);
+
+		out.insert(out.end(), data, data + RECORD_SIZE);
+	}
+
+	bool ReadRecord(const uint8_t* data, EditRecord& recordOut)
+	{
+		if (GetRecordChecksum(data) != data[15])
+		{
+			return false;
+		}
+
+		recordOut.chunkKey = { ReadI32(data), ReadI32(data + 4), ReadI32(data + 8) };
+		recordOut.localIndex = static_cast<uint16_t>(data[12] | (data[13] << 8));
+		recordOut.blockType = data[14];
+		return true;
+	}
+}
+
+EditJournal::EditJournal(const std::string& path)
+{
+	path_ = path;
+	file_ = nullptr;
+	pending_ = std::vector<EditRecord>();
+	isWriting_ = false;
+	shouldStop_ = false;
+	rewriteRecords_ = std::vector<EditRecord>();
+	hasPendingRewrite_ = false;
+	hasFailed_ = false;
+	committedSize_ = 0;
+
+	OpenForAppend();
+
+	commitThread_ = std::thread(&EditJournal::RunCommitThread, this);
+}
+
+EditJournal::~EditJournal()
+{
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex_);
+		shouldStop_ = true;
+	}
+	pendingCondition_.notify_all();
+
+	// The commit thread writes anything still pending before it stops
+	commitThread_.join();
+
+	if (file_)
+	{
+		fclose(file_);
+	}
+}
+
+bool EditJournal::OpenForAppend()
+{
+	// Appending after a torn record would make every record after it
+	// unreadable, so cut the journal back to its valid records first.
+	std::vector<EditRecord> records = Replay(path_);
+
+	std::error_code error;
+	uintmax_t fileSize = std::filesystem::file_size(path_, error);
+
+	committedSize_ = HEADER_SIZE + records.size() * RECORD_SIZE;
+	if (error || fileSize != committedSize_)
+	{
+		std::vector<uint8_t> data = std::vector<uint8_t>(JOURNAL_MAGIC, JOURNAL_MAGIC + HEADER_SIZE);
+		for (const EditRecord& record : records)
+		{
+			WriteRecord(data, record);
+		}
+
+		if (!FileUtils::WriteFileDurably(path_, data))
+		{
+			LOG("Couldn't create the edit journal %s\n", path_.c_str());
+			return false;
+		}
+	}
+
+	file_ = fopen(path_.c_str(), "ab");
+	if (!file_)
+	{
+		LOG("Couldn't open the edit journal %s\n", path_.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void EditJournal::Append(const EditRecord& record)
+{
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex_);
+		pending_.push_back(record);
+	}
+	pendingCondition_.notify_one();
+}
+
+void EditJournal::RunCommitThread()
+{
+	std::unique_lock<std::mutex> lock(pendingMutex_);
+
+	while (true)
+	{
+		pendingCondition_.wait(lock, [this]() { return shouldStop_ || !pending_.empty() || hasPendingRewrite_; });
+
+		if (hasPendingRewrite_)
+		{
+			std::vector<EditRecord> records = std::vector<EditRecord>();
+			records.swap(rewriteRecords_);
+			hasPendingRewrite_ = false;
+			isWriting_ = true;
+			lock.unlock();
+
+			bool wasRewritten = WriteRewrite(records);
+
+			lock.lock();
+			isWriting_ = false;
+			hasFailed_ = !wasRewritten;
+			committedCondition_.notify_all();
+			continue;
+		}
+
+		if (pending_.empty())
+		{
+			break;
+		}
+
+		std::vector<EditRecord> batch = std::vector<EditRecord>();
+		batch.swap(pending_);
+		isWriting_ = true;
+
+		// Edits keep queueing up while this batch is written and synced
+		lock.unlock();
+
+		std::vector<uint8_t> data = std::vector<uint8_t>();
+		data.reserve(batch.size() * RECORD_SIZE);
+		for (const EditRecord& record : batch)
+		{
+			WriteRecord(data, record);
+		}
+
+		bool wasWritten = file_ && fwrite(data.data(), 1, data.size(), file_) == data.size() && FileUtils::SyncFile(file_);
+		if (wasWritten)
+		{
+			committedSize_ += data.size();
+		}
+		else
+		{
+			// The edits are still in the chunks, they get saved by the autosave
+			// and the next Rewrite, but a torn record would hide every later one
+			LOG("Couldn't write %zu edits to the edit journal\n", batch.size());
+			TruncateToCommitted();
+		}
+
+		lock.lock();
+		isWriting_ = false;
+		if (wasWritten)
+		{
+			numRecordsCommitted_ += batch.size();
+			numSyncs_++;
+		}
+		else
+		{
+			hasFailed_ = true;
+		}
+		committedCondition_.notify_all();
+	}
+}
+
+void EditJournal::TruncateToCommitted()
+{
+	// Reopening drops anything left in the stream's buffer too
+	if (file_)
+	{
+		fclose(file_);
+	}
+
+	std::error_code error;
+	std::filesystem::resize_file(path_, committedSize_, error);
+	if (error)
+	{
+		LOG("Couldn't truncate the edit journal %s: %s\n", path_.c_str(), error.message().c_str());
+	}
+
+	file_ = fopen(path_.c_str(), "ab");
+}
+
+bool EditJournal::Flush()
+{
+	std::unique_lock<std::mutex> lock(pendingMutex_);
+	committedCondition_.wait(lock, [this]() { return pending_.empty() && !hasPendingRewrite_ && !isWriting_; });
+	return !hasFailed_;
+}
+
+bool EditJournal::HasFailed()
+{
+	std::lock_guard<std::mutex> lock(pendingMutex_);
+	return hasFailed_;
+}
+
+void EditJournal::Rewrite(std::vector<EditRecord> records)
+{
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex_);
+
+		// They're in the records, a later rewrite replaces an earlier one
+		pending_.clear();
+		rewriteRecords_ = std::move(records);
+		hasPendingRewrite_ = true;
+	}
+	pendingCondition_.notify_one();
+}
+
+bool EditJournal::WriteRewrite(const std::vector<EditRecord>& records)
+{
+	if (file_)
+	{
+		fclose(file_);
+		file_ = nullptr;
+	}
+
+	std::vector<uint8_t> data = std::vector<uint8_t>(JOURNAL_MAGIC, JOURNAL_MAGIC + HEADER_SIZE);
+	data.reserve(HEADER_SIZE + records.size() * RECORD_SIZE);
+	for (const EditRecord& record : records)
+	{
+		WriteRecord(data, record);
+	}
+
+	bool wasRewritten = FileUtils::WriteFileDurably(path_, data);
+	if (wasRewritten)
+	{
+		committedSize_ = data.size();
+	}
+
+	// A failed rewrite leaves the old journal, truncated back to its last good
+	// record. The records dropped from the queue are only in the next rewrite.
+	file_ = fopen(path_.c_str(), "ab");
+	if (!file_)
+	{
+		LOG("Couldn't open the edit journal %s\n", path_.c_str());
+		return false;
+	}
+
+	return wasRewritten;
+}
+
+std::vector<EditRecord> EditJournal::Replay(const std::string& path)
+{
+	std::vector<EditRecord> records = std::vector<EditRecord>();
+
+	std::vector<uint8_t> data = std::vector<uint8_t>();
+	if (!FileUtils::ReadFile(path, data) || data.size() < HEADER_SIZE)
+	{
+		return records;
+	}
+
+	if (!std::equal(JOURNAL_MAGIC, JOURNAL_MAGIC + HEADER_SIZE, data.begin()))
+	{
+		LOG("%s isn't an edit journal\n", path.c_str());
+		return records;
+	}
+
+	for (size_t offset = HEADER_SIZE; offset + RECORD_SIZE <= data.size(); offset += RECORD_SIZE)
+	{
+		EditRecord record{};
+		if (!ReadRecord(data.data() + offset, record))
+		{
+			LOG("Stopped replaying %s at a torn record (offset %zu)\n", path.c_str(), offset);
+			break;
+		}
+
+		records.push_back(record);
+	}
+
+	return records;
+}
+
+uint64_t EditJournal::GetNumRecordsCommitted()
+{
+	return numRecordsCommitted_.load();
+}
+
+uint64_t EditJournal::GetNumSyncs()
+{
+	return numSyncs_.load();
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chunkStore.h"
+
+/*
+ * A single block edit, the block at localIndex (in fill order)
+ * inside the chunk was set to blockType.
+ */
+struct EditRecord
+{
+	ChunkKey chunkKey;
+	uint16_t localIndex;
+	uint8_t blockType;
+};
+
+/*
+ * An append-only log of block edits so they survive a crash.
+ *
+ * Append never touches the disk, it just queues the record. A background
+ * thread writes everything that has been queued since its last write in one
+ * go and then syncs the file, so any number of edits made while a sync is in
+ * progress share the next one (group commit).
+ */
+class EditJournal
+{
+	std::string path_;
+	FILE* file_;
+	size_t committedSize_; // bytes of the file that hold whole, synced records
+
+	std::vector<EditRecord> pending_;
+	bool isWriting_;
+	bool shouldStop_;
+
+	// The records the journal is replaced with next, see Rewrite
+	std::vector<EditRecord> rewriteRecords_;
+	bool hasPendingRewrite_;
+
+	// Set when a batch couldn't be written, until a Rewrite succeeds
+	bool hasFailed_;
+	std::mutex pendingMutex_;
+	std::condition_variable pendingCondition_;
+	std::condition_variable committedCondition_;
+
+	std::thread commitThread_;
+
+	std::atomic<uint64_t> numRecordsCommitted_{0};
+	std::atomic<uint64_t> numSyncs_{0};
+
+	void RunCommitThread();
+	bool OpenForAppend();
+
+	// On the commit thread, returns false if the old journal had to be kept
+	bool WriteRewrite(const std::vector<EditRecord>& records);
+
+	// Cuts off whatever a failed write left after the last whole record
+	void TruncateToCommitted();
+public:
+	EditJournal(const std::string& path);
+	~EditJournal();
+
+	void Append(const EditRecord& record);
+
+	/*
+	 * Blocks until every record appended so far has been written. Returns
+	 * false if any write has failed since the journal was opened or last
+	 * rewritten, those records are only safe once a Rewrite succeeds.
+	 */
+	bool Flush();
+	bool HasFailed();
+
+	/*
+	 * Replaces the journal with just the records passed in, used once the
+	 * rest have been compacted into chunk saves. Like Append this only
+	 * queues it, the commit thread does the write. The records have to
+	 * include every record appended so far that's still needed, anything
+	 * queued before this that hasn't been written yet is dropped. Records
+	 * appended afterwards go after them. Succeeding clears a failed write.
+	 */
+	void Rewrite(std::vector<EditRecord> records);
+
+	/*
+	 * Reads the records from a journal, in the order they were made.
+	 * A torn record at the end (from a crash mid-write) is ignored.
+	 */
+	static std::vector<EditRecord> Replay(const std::string& path);
+
+	uint64_t GetNumRecordsCommitted();
+	uint64_t GetNumSyncs();
+};
@@ -0,0 +1,134 @@
+#include "epochReclaimer.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <thread>
+
+EpochGuard::EpochGuard(EpochReclaimer* reclaimer)
+{
+	reclaimer_ = reclaimer;
+	slotIndex_ = reclaimer_->Enter();
+}
+
+EpochGuard::~EpochGuard()
+{
+	reclaimer_->Leave(slotIndex_);
+}
+
+EpochReclaimer::EpochReclaimer(int numSlots)
+{
+	numSlots_ = numSlots;
+	slots_ = std::make_unique<ReaderSlot[]>(numSlots_);
+	for (int i = 0; i < numSlots_; i++)
+	{
+		slots_[i].epoch.store(kInactive);
+	}
+
+	// Starts above kInactive so a reader's slot is never mistaken for a free one
+	epoch_.store(1);
+
+	retired_ = std::vector<RetiredObject>();
+	stats_ = {};
+}
+
+EpochReclaimer::~EpochReclaimer()
+{
+	for (RetiredObject& object : retired_)
+	{
+		object.free();
+	}
+}
+
+int EpochReclaimer::Enter()
+{
+	// Start somewhere different on each thread so readers don't fight over the first slots
+	int firstSlotIndex = std::hash<std::thread::id>()(std::this_thread::get_id()) % numSlots_;
+
+	while (true)
+	{
+		uint64_t epoch = epoch_.load();
+
+		for (int i = 0; i < numSlots_; i++)
+		{
+			int slotIndex = (firstSlotIndex + i) % numSlots_;
+			uint64_t expected = kInactive;
+			if (slots_[slotIndex].epoch.compare_exchange_strong(expected, epoch))
+			{
+				return slotIndex;
+			}
+		}
+
+		// Every slot is taken, wait for a reader to leave
+		std::this_thread::yield();
+	}
+}
+
+void EpochReclaimer::Leave(int slotIndex)
+{
+	slots_[slotIndex].epoch.store(kInactive);
+}
+
+void EpochReclaimer::Retire(std::function<void()> free, size_t numBytes)
+{
+	// Read after the pointer was swapped, so a reader in this epoch or
+	// earlier might still have the old one but a later reader can't
+	uint64_t epoch = epoch_.load();
+
+	std::lock_guard<std::mutex> lock(retiredMutex_);
+	retired_.push_back({ std::move(free), numBytes, epoch, glfwGetTime() });
+	stats_.numPending++;
+	stats_.pendingBytes += numBytes;
+}
+
+void EpochReclaimer::Collect()
+{
+	uint64_t oldestEpoch = epoch_.fetch_add(1) + 1;
+
+	for (int i = 0; i < numSlots_; i++)
+	{
+		uint64_t epoch = slots_[i].epoch.load();
+		if (epoch != kInactive)
+		{
+			oldestEpoch = std::min(oldestEpoch, epoch);
+		}
+	}
+
+	std::vector<RetiredObject> safeToFree = std::vector<RetiredObject>();
+	{
+		std::lock_guard<std::mutex> lock(retiredMutex_);
+
+		auto firstKept = std::partition(retired_.begin(), retired_.end(), [oldestEpoch](const RetiredObject& object) {
+			return object.epoch < oldestEpoch;
+		});
+		safeToFree.insert(safeToFree.end(), std::make_move_iterator(retired_.begin()), std::make_move_iterator(firstKept));
+		retired_.erase(retired_.begin(), firstKept);
+	}
+
+	// Freed outside the lock so writers retiring more aren't held up
+	double currentTime = glfwGetTime();
+	size_t freedBytes = 0;
+	for (RetiredObject& object : safeToFree)
+	{
+		object.free();
+		freedBytes += object.numBytes;
+	}
+
+	std::lock_guard<std::mutex> lock(retiredMutex_);
+	for (RetiredObject& object : safeToFree)
+	{
+		double latency = currentTime - object.retiredTime;
+		stats_.averageFreeLatency += (latency - stats_.averageFreeLatency) / (stats_.numFreed + 1);
+		stats_.longestFreeLatency = std::max(stats_.longestFreeLatency, latency);
+		stats_.numFreed++;
+	}
+	stats_.numPending -= safeToFree.size();
+	stats_.pendingBytes -= freedBytes;
+}
+
+EpochStats EpochReclaimer::GetStats()
+{
+	std::lock_guard<std::mutex> lock(retiredMutex_);
+	EpochStats stats = stats_;
+	stats.epoch = epoch_.load();
+	return stats;
+}
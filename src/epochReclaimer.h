@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct EpochStats
+{
+	uint64_t epoch;
+
+	// Retired but still waiting for readers to leave
+	int numPending;
+	size_t pendingBytes;
+
+	int numFreed;
+	double averageFreeLatency; // seconds from being retired to being freed
+	double longestFreeLatency;
+};
+
+class EpochReclaimer;
+
+/*
+ * Marks the current thread as reading shared data until it goes out
+ * of scope. Anything loaded while the guard is alive won't be freed
+ * until after the guard is destroyed.
+ */
+class EpochGuard
+{
+	EpochReclaimer* reclaimer_;
+	int slotIndex_;
+public:
+	EpochGuard(EpochReclaimer* reclaimer);
+	~EpochGuard();
+
+	EpochGuard(const EpochGuard&) = delete;
+	EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+/*
+ * Epoch based reclamation for data that's swapped out while other
+ * threads may still be reading it.
+ *
+ * Readers take a slot and write the current epoch into it for as long
+ * as they are reading (see EpochGuard). A writer swaps the shared
+ * pointer first and then retires the old data, which records the epoch
+ * it was retired in. Collect moves the epoch on and frees everything
+ * that was retired before the oldest epoch a reader is still in, since
+ * any reader that started later can only have loaded the new pointer.
+ *
+ * Entering and leaving is a compare-exchange and a store on the
+ * reader's own slot, so the read path never takes a lock. Retiring
+ * and collecting take a mutex, they only happen on writes.
+ *
+ * The shared pointers must be loaded and stored with the default
+ * (sequentially consistent) memory order for this to hold.
+ */
+class EpochReclaimer
+{
+	struct RetiredObject
+	{
+		std::function<void()> free;
+		size_t numBytes;
+		uint64_t epoch;
+		double retiredTime;
+	};
+
+	struct alignas(64) ReaderSlot
+	{
+		std::atomic<uint64_t> epoch;
+	};
+
+	// Slots that aren't in use hold this instead of an epoch
+	static const uint64_t kInactive = 0;
+
+	std::unique_ptr<ReaderSlot[]> slots_;
+	int numSlots_;
+
+	std::atomic<uint64_t> epoch_;
+
+	std::mutex retiredMutex_;
+	std::vector<RetiredObject> retired_;
+	EpochStats stats_;
+
+	friend class EpochGuard;
+	int Enter();
+	void Leave(int slotIndex);
+public:
+	EpochReclaimer(int numSlots = 256);
+
+	// Frees everything that's left, there must be no readers by now
+	~EpochReclaimer();
+
+	EpochReclaimer(const EpochReclaimer&) = delete;
+	EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+	// Call after the data has been swapped out, free is called once no reader can see it
+	void Retire(std::function<void()> free, size_t numBytes);
+
+	template<typename T>
+	void Retire(const T* object, size_t numBytes)
+	{
+		Retire([object]() { delete object; }, numBytes);
+	}
+
+	// Moves the epoch on and frees what's safe to, i.e. once per frame
+	void Collect();
+
+	EpochStats GetStats();
+};
@@ -0,0 +1,98 @@
+#include "fileUtils.h"
+
+#include <atomic>
+#include <filesystem>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+#include "logging.h"
+
+namespace
+{
+	// Gives every write its own temporary file
+	std::atomic<uint64_t> nextTempFile{0};
+}
+
+namespace FileUtils
+{
+	bool ReadFile(const std::string& path, std::vector<uint8_t>& dataOut)
+	{
+		dataOut.clear();
+
+		FILE* file = fopen(path.c_str(), "rb");
+		if (!file)
+		{
+			return false;
+		}
+
+		uint8_t buffer[4096];
+		size_t numRead = 0;
+		while ((numRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			dataOut.insert(dataOut.end(), buffer, buffer + numRead);
+		}
+
+		bool wasRead = ferror(file) == 0;
+		fclose(file);
+
+		return wasRead;
+	}
+
+	bool WriteFileDurably(const std::string& path, const std::vector<uint8_t>& data)
+	{
+		// Two writes to the same path at once each rename a whole file into
+		// place, rather than one renaming the other's half written one
+		std::string tempPath = path + "." + std::to_string(nextTempFile.fetch_add(1)) + ".tmp";
+
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (!file)
+		{
+			LOG("Couldn't open %s for writing\n", tempPath.c_str());
+			return false;
+		}
+
+		bool wasWritten = fwrite(data.data(), 1, data.size(), file) == data.size() && SyncFile(file);
+		fclose(file);
+
+		if (!wasWritten)
+		{
+			LOG("Couldn't write %s\n", tempPath.c_str());
+			return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			LOG("Couldn't rename %s to %s: %s\n", tempPath.c_str(), path.c_str(), error.message().c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SyncFile(FILE* file)
+	{
+		if (fflush(file) != 0)
+		{
+			return false;
+		}
+
+#ifdef _WIN32
+		return _commit(_fileno(file)) == 0;
+#else
+		return fsync(fileno(file)) == 0;
+#endif
+	}
+
+	bool CreateDirectories(const std::string& path)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(path, error);
+		return !error;
+	}
+}
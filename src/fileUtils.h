@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/*
+ * Small helpers for the save files. These are kept separate
+ * from the save code itself since both the chunk store and the
+ * edit journal need to make sure data actually reaches the disk.
+ */
+namespace FileUtils
+{
+	bool ReadFile(const std::string& path, std::vector<uint8_t>& dataOut);
+
+	/*
+	 * Writes to a temporary file, syncs it and then renames it over the
+	 * path. A crash part way through leaves either the old or the new file.
+	 * Safe to call for the same path from more than one thread, the last
+	 * rename wins.
+	 */
+	bool WriteFileDurably(const std::string& path, const std::vector<uint8_t>& data);
+
+	// Flushes the file and waits for the OS to write it to disk (fsync)
+	bool SyncFile(FILE* file);
+
+	bool CreateDirectories(const std::string& path);
+}
@@ -1,5 +1,7 @@
 #include "frustum.h"
 
+#include <cmath>
+
 #include "logging.h"
 
 Plane::Plane(const glm::vec3& p1, glm::vec3 normal_)
@@ -9,25 +11,30 @@ Plane::Plane(const glm::vec3& p1, glm::vec3 normal_)
 }
 
 Frustum CreateFrustum(TransformComponent* cameraTransform, float fovy, float aspectRatio, float zNear, float zFar)
+{
+	return CreateFrustum(cameraTransform->GetTranslation(), cameraTransform->GetForwardVector(), cameraTransform->GetRightVector(), cameraTransform->GetUpVector(), fovy, aspectRatio, zNear, zFar);
+}
+
+Frustum CreateFrustum(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& right, const glm::vec3& up, float fovy, float aspectRatio, float zNear, float zFar)
 {
 	Frustum frustum{};
 
 	float halfVSide = zFar * tanf(fovy * 0.5f);
 	float halfHSide = halfVSide * aspectRatio;
-	glm::vec3 forwardMultFar = zFar * cameraTransform->GetForwardVector();
-
-	frustum.near = { cameraTransform->GetTranslation() + zNear * cameraTransform->GetForwardVector(), cameraTransform->GetForwardVector() };
-	frustum.far = { cameraTransform->GetTranslation() + forwardMultFar, -cameraTransform->GetForwardVector() };
-	frustum.right = { cameraTransform->GetTranslation(), glm::cross(forwardMultFar - cameraTransform->GetRightVector() * halfHSide, cameraTransform->GetUpVector()) };
-	frustum.left = { cameraTransform->GetTranslation(), glm::cross(cameraTransform->GetUpVector(), forwardMultFar + cameraTransform->GetRightVector() * halfHSide) };
-	frustum.top = { cameraTransform->GetTranslation(), glm::cross(cameraTransform->GetRightVector(), forwardMultFar - cameraTransform->GetUpVector() * halfVSide) };
-	frustum.bottom = { cameraTransform->GetTranslation(), glm::cross(forwardMultFar + cameraTransform->GetUpVector() * halfVSide, cameraTransform->GetRightVector()) };
+	glm::vec3 forwardMultFar = zFar * forward;
+
+	frustum.near = { position + zNear * forward, forward };
+	frustum.far = { position + forwardMultFar, -forward };
+	frustum.right = { position, glm::cross(forwardMultFar - right * halfHSide, up) };
+	frustum.left = { position, glm::cross(up, forwardMultFar + right * halfHSide) };
+	frustum.top = { position, glm::cross(right, forwardMultFar - up * halfVSide) };
+	frustum.bottom = { position, glm::cross(forwardMultFar + up * halfVSide, right) };
 	return frustum;
 }
 
 bool IsBoundingBoxInsidePlane(const Plane& plane, const AABB& aabb)
 {
-	float r = aabb.size.x * abs(plane.normal.x) + aabb.size.y * abs(plane.normal.y) + aabb.size.z * abs(plane.normal.z);
+	float r = aabb.size.x * std::fabs(plane.normal.x) + aabb.size.y * std::fabs(plane.normal.y) + aabb.size.z * std::fabs(plane.normal.z);
 	float distanceToPlane = glm::dot(plane.normal, aabb.origin) - plane.distanceFromOrigin;
 	return -r <= distanceToPlane;
 }
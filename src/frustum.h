@@ -39,6 +39,9 @@ struct AABB
 };
 
 Frustum CreateFrustum(TransformComponent* cameraTransform, float fovy, float aspectRatio, float zNear, float zFar);
+
+// The directions are the camera's, normalised
+Frustum CreateFrustum(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& right, const glm::vec3& up, float fovy, float aspectRatio, float zNear, float zFar);
 bool IsBoundingBoxInsideFrustum(const Frustum& frustum, const AABB& aabb);
 
 bool IsPointInsidePlane(const Plane& plane, const glm::vec3& point);
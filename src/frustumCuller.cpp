@@ -0,0 +1,209 @@
+#include "frustumCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <xmmintrin.h>
+
+#include "cullingBenchmark.h"
+
+FrustumCuller::FrustumCuller()
+{
+	numBoxes_ = 0;
+	centreX_ = std::vector<float>();
+	centreY_ = std::vector<float>();
+	centreZ_ = std::vector<float>();
+	halfSizeX_ = std::vector<float>();
+	halfSizeY_ = std::vector<float>();
+	halfSizeZ_ = std::vector<float>();
+}
+
+void FrustumCuller::SetNumBoxes(int numBoxes)
+{
+	numBoxes_ = numBoxes;
+
+	// NaN fails every comparison, so the padding and boxes that haven't been set are never visible
+	size_t numPadded = numBoxes + 3;
+	float nan = std::numeric_limits<float>::quiet_NaN();
+	centreX_.resize(numPadded, nan);
+	centreY_.resize(numPadded, nan);
+	centreZ_.resize(numPadded, nan);
+	halfSizeX_.resize(numPadded, 0.0f);
+	halfSizeY_.resize(numPadded, 0.0f);
+	halfSizeZ_.resize(numPadded, 0.0f);
+
+	// Shrinking can leave an old box in the padding
+	for (size_t i = numBoxes; i < numPadded; i++)
+	{
+		centreX_[i] = nan;
+	}
+}
+
+int FrustumCuller::GetNumBoxes()
+{
+	return numBoxes_;
+}
+
+void FrustumCuller::SetBox(int index, const glm::vec3& centre, const glm::vec3& halfSize)
+{
+	centreX_[index] = centre.x;
+	centreY_[index] = centre.y;
+	centreZ_[index] = centre.z;
+	halfSizeX_[index] = halfSize.x;
+	halfSizeY_[index] = halfSize.y;
+	halfSizeZ_[index] = halfSize.z;
+}
+
+void FrustumCuller::Cull(const Frustum& frustum, std::vector<int>& visibleOut)
+{
+	visibleOut.clear();
+	CullRanges(frustum, { { 0, numBoxes_ } }, visibleOut);
+}
+
+void FrustumCuller::CullRanges(const Frustum& frustum, const std::vector<BoxRange>& ranges, std::vector<int>& visibleOut)
+{
+	const Plane* planes[6] = { &frustum.right, &frustum.left, &frustum.top, &frustum.bottom, &frustum.near, &frustum.far };
+
+	// Each plane's components broadcast to all four lanes
+	__m128 normalX[6];
+	__m128 normalY[6];
+	__m128 normalZ[6];
+	__m128 absNormalX[6];
+	__m128 absNormalY[6];
+	__m128 absNormalZ[6];
+	__m128 distance[6];
+	for (int i = 0; i < 6; i++)
+	{
+		normalX[i] = _mm_set1_ps(planes[i]->normal.x);
+		normalY[i] = _mm_set1_ps(planes[i]->normal.y);
+		normalZ[i] = _mm_set1_ps(planes[i]->normal.z);
+		absNormalX[i] = _mm_set1_ps(std::fabs(planes[i]->normal.x));
+		absNormalY[i] = _mm_set1_ps(std::fabs(planes[i]->normal.y));
+		absNormalZ[i] = _mm_set1_ps(std::fabs(planes[i]->normal.z));
+		distance[i] = _mm_set1_ps(planes[i]->distanceFromOrigin);
+	}
+
+	// Written without branching on whether each box is visible, then trimmed
+	size_t maxVisible = 0;
+	for (const BoxRange& range : ranges)
+	{
+		maxVisible += (range.count + 3) / 4 * 4;
+	}
+
+	size_t numVisible = visibleOut.size();
+	visibleOut.resize(numVisible + maxVisible);
+	int* out = visibleOut.data();
+
+	__m128 zero = _mm_setzero_ps();
+	for (const BoxRange& range : ranges)
+	{
+		int end = range.first + range.count;
+		for (int i = range.first; i < end; i += 4)
+		{
+			__m128 centreX = _mm_loadu_ps(&centreX_[i]);
+			__m128 centreY = _mm_loadu_ps(&centreY_[i]);
+			__m128 centreZ = _mm_loadu_ps(&centreZ_[i]);
+			__m128 halfSizeX = _mm_loadu_ps(&halfSizeX_[i]);
+			__m128 halfSizeY = _mm_loadu_ps(&halfSizeY_[i]);
+			__m128 halfSizeZ = _mm_loadu_ps(&halfSizeZ_[i]);
+
+			__m128 isInside = _mm_cmpeq_ps(zero, zero);
+			for (int plane = 0; plane < 6; plane++)
+			{
+				// Same order of operations as IsBoundingBoxInsidePlane, so the results match exactly
+				__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(halfSizeX, absNormalX[plane]), _mm_mul_ps(halfSizeY, absNormalY[plane])), _mm_mul_ps(halfSizeZ, absNormalZ[plane]));
+				__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[plane], centreX), _mm_mul_ps(normalY[plane], centreY)), _mm_mul_ps(normalZ[plane], centreZ));
+				__m128 distanceToPlane = _mm_sub_ps(dot, distance[plane]);
+				isInside = _mm_and_ps(isInside, _mm_cmple_ps(_mm_sub_ps(zero, r), distanceToPlane));
+			}
+
+			// The lanes past the end of the range are other boxes
+			int numLanes = std::min(end - i, 4);
+			int mask = _mm_movemask_ps(isInside) & ((1 << numLanes) - 1);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				out[numVisible] = i + lane;
+				numVisible += (mask >> lane) & 1;
+			}
+		}
+	}
+
+	visibleOut.resize(numVisible);
+}
+
+bool FrustumCuller::RunBenchmark(int maxRenderDistance)
+{
+	const int numFrames = 256;
+
+	bool isCorrect = true;
+	for (int renderDistance = 8; renderDistance <= maxRenderDistance; renderDistance += 8)
+	{
+		std::vector<AABB> boxes = CullingBenchmark::CreateChunkBoxes(renderDistance);
+
+		FrustumCuller culler = FrustumCuller();
+		culler.SetNumBoxes(boxes.size());
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			culler.SetBox(i, boxes[i].origin, boxes[i].size);
+		}
+
+		std::vector<Frustum> frustums = CullingBenchmark::CreateFrustums(renderDistance, numFrames);
+
+		// Every frame has to keep exactly the same chunks as the scalar test
+		std::vector<int> visible = std::vector<int>();
+		std::vector<int> scalarVisible = std::vector<int>();
+		size_t numVisible = 0;
+		bool doesMatch = true;
+		for (const Frustum& frustum : frustums)
+		{
+			culler.Cull(frustum, visible);
+
+			scalarVisible.clear();
+			for (size_t i = 0; i < boxes.size(); i++)
+			{
+				if (IsBoundingBoxInsideFrustum(frustum, boxes[i]))
+				{
+					scalarVisible.push_back(i);
+				}
+			}
+
+			doesMatch = doesMatch && visible == scalarVisible;
+			numVisible += visible.size();
+		}
+
+		if (!doesMatch)
+		{
+			isCorrect = false;
+			printf("Render distance %d: the SIMD and scalar culling disagree\n", renderDistance);
+		}
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (const Frustum& frustum : frustums)
+		{
+			culler.Cull(frustum, visible);
+		}
+		double simdSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		startTime = std::chrono::steady_clock::now();
+		for (const Frustum& frustum : frustums)
+		{
+			scalarVisible.clear();
+			for (size_t i = 0; i < boxes.size(); i++)
+			{
+				if (IsBoundingBoxInsideFrustum(frustum, boxes[i]))
+				{
+					scalarVisible.push_back(i);
+				}
+			}
+		}
+		double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		double numTests = static_cast<double>(boxes.size()) * numFrames;
+		printf("Render distance %d, %zu chunks, %zu visible on average: SIMD %.2fns per chunk, scalar %.2fns per chunk\n",
+			renderDistance, boxes.size(), numVisible / numFrames, simdSeconds * 1e9 / numTests, scalarSeconds * 1e9 / numTests);
+	}
+
+	return isCorrect;
+}
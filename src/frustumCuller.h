@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "frustum.h"
+
+// Boxes first to first + count - 1
+struct BoxRange
+{
+	int first;
+	int count;
+};
+
+/*
+ * Tests lots of boxes against a frustum at once. The boxes are stored as
+ * structure of arrays, one array per centre and half size component, so
+ * SSE can load four boxes' worth of each and test all four against a
+ * plane in a handful of instructions.
+ *
+ * The test is the same as IsBoundingBoxInsideFrustum, a box is culled if
+ * it's completely outside any of the six planes. Boxes keep their index,
+ * so callers can keep their own objects in the same order and use the
+ * visible indices to look them up.
+ */
+class FrustumCuller
+{
+	int numBoxes_;
+
+	// Padded with three boxes that are never visible, so four boxes can be loaded starting from any of them
+	std::vector<float> centreX_;
+	std::vector<float> centreY_;
+	std::vector<float> centreZ_;
+	std::vector<float> halfSizeX_;
+	std::vector<float> halfSizeY_;
+	std::vector<float> halfSizeZ_;
+public:
+	FrustumCuller();
+
+	// New boxes are never visible until they're set
+	void SetNumBoxes(int numBoxes);
+	int GetNumBoxes();
+
+	void SetBox(int index, const glm::vec3& centre, const glm::vec3& halfSize);
+
+	// Replaces visibleOut with the indices of the boxes that are at least partly inside, in order
+	void Cull(const Frustum& frustum, std::vector<int>& visibleOut);
+
+	// Only tests the boxes in the ranges, and adds the visible ones' indices to the end of visibleOut
+	void CullRanges(const Frustum& frustum, const std::vector<BoxRange>& ranges, std::vector<int>& visibleOut);
+
+	/*
+	 * Culls a grid of chunks laid out like the World's at render
+	 * distances from 8 up to maxRenderDistance, with the camera turning
+	 * on the spot, and prints how long the SIMD and scalar tests took per
+	 * chunk. Returns false if they disagree on any chunk.
+	 */
+	static bool RunBenchmark(int maxRenderDistance);
+};
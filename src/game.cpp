@@ -7,10 +7,12 @@
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include "logging.h"
+#include "assetPack.h"
 #include "mesh.h"
 #include "chunk.h"
 #include "entity.h"
 #include "freeFormController.h"
+#include "glRenderDevice.h"
 #include "image.h"
 #include "meshComponent.h"
 #include "transformComponent.h"
@@ -37,6 +39,15 @@ MessageCallback(GLenum source,
 Game::Game()
 {
     isFullscreen = false;
+	renderDevice = nullptr;
+
+	// Anything that isn't packed (or everything, without a pack) is read from the Assets folder
+	assetPack = new AssetPack();
+	if (assetPack->Open("./Assets.pack"))
+	{
+		LOG("Loaded %d assets from ./Assets.pack\n", assetPack->GetNumAssets());
+		AssetPack::Set(assetPack);
+	}
 
 	if (glfwInit() != GLFW_TRUE)
 	{
@@ -64,7 +75,11 @@ Game::Game()
 		return;
 	}
 
-	glViewport(0, 0, 1280, 720);
+	// Everything else goes through this rather than calling OpenGL itself
+	renderDevice = new GLRenderDevice();
+	RenderDevice::Set(renderDevice);
+
+	renderDevice->SetViewport(0, 0, 1280, 720);
 	glfwSetFramebufferSizeCallback(window, ResizeViewportCallback);
 
 #ifdef _DEBUG
@@ -84,17 +99,17 @@ Game::Game()
 	glDebugMessageCallback(MessageCallback, 0);
 #endif
 
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_TRUE);
+	renderDevice->SetDepthTest(true);
+	renderDevice->SetDepthMask(true);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	renderDevice->SetBlend(true);
+	renderDevice->SetBlendFunction(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void Game::Run()
 {
-	glClearColor(0.0f, 0.3f, 0.5f, 1.0f);
-	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+	renderDevice->SetClearColour(0.0f, 0.3f, 0.5f, 1.0f);
+	renderDevice->Clear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 	glfwSwapBuffers(window);
 
 	debugInfo = DebugInfo();
@@ -151,7 +166,7 @@ void Game::Run()
 
 	bool shouldShowDebugInfo = true;
 
-	glClearColor(0.0f, 0.3f, 0.5f, 1.0f);
+	renderDevice->SetClearColour(0.0f, 0.3f, 0.5f, 1.0f);
 
 	double startPhysicsUpdateTime = glfwGetTime();
 	double targetPhysicsUpdateTime = 1.0f / 60;
@@ -186,11 +201,6 @@ void Game::Run()
 
 		world.Update(playerTransform->GetTranslation());
 
-		for (Chunk* chunk : world.GetWorld())
-		{
-			chunk->Update();
-		}
-
 		// Perform Fixed 60 FPS Physics Update
 		if ((glfwGetTime() - startPhysicsUpdateTime) >= targetPhysicsUpdateTime) {
 			playerController.Update(&world);
@@ -215,21 +225,22 @@ void Game::Run()
 		TransformComponent* cameraTransform = static_cast<TransformComponent*>(playerController.GetComponentByName("cameraTransform"));
 		glm::mat4 view = cameraComponent->GetView(cameraTransform);
 
-		bool shouldUpdateViews = false;
-		if (view != oldView)
+		bool shouldUpdateViews = view != oldView;
+		if (shouldUpdateViews || world.HaveOccludersChanged())
 		{
-			shouldUpdateViews = true;
 			int width, height;
 			glfwGetWindowSize(window, &width, &height);
 			float aspectRatio = width / height;
 			Frustum frustum = CreateFrustum(cameraTransform, fov, aspectRatio, zNear, zFar);
 			world.FrustumCullChunks(frustum);
+			world.VisibilityCullChunks(cameraTransform->GetTranslation());
+			world.OcclusionCullChunks(perspective * view, cameraTransform->GetTranslation());
 		}
 
 		debugInfo.EndUpdate();
 		debugInfo.StartRender();
 
-		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+		renderDevice->Clear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
 		// Set the Chunk Batching Data
 		if (shouldUpdateViews) {
@@ -240,11 +251,10 @@ void Game::Run()
 			Mesh::SetCommonData(MeshType::Chunk, ChunkCommonData);
 		}
 
+		world.UploadChunkMeshes(cameraTransform->GetTranslation());
+
 		Mesh::StartDrawBatch(MeshType::Chunk);
-		for (auto chunk : world.GetWorld())
-		{
-			chunk->Draw();
-		}
+		world.DrawChunks(cameraTransform->GetTranslation());
 		Mesh::EndDrawBatch();
 
 		glm::mat4 orthoProjection = glm::mat4(1.0f);
@@ -258,6 +268,8 @@ void Game::Run()
 #endif
 
 		glfwSwapBuffers(window);
+		world.MarkFrameDrawn();
+		renderDevice->EndFrame();
 
 		debugInfo.EndRender();
 		debugInfo.EndFrame();
@@ -274,6 +286,12 @@ Game::~Game()
 	ImGui::DestroyContext();
 #endif
 
+	RenderDevice::Set(nullptr);
+	delete renderDevice;
+
+	AssetPack::Set(nullptr);
+	delete assetPack;
+
 	glfwDestroyWindow(window);
 	glfwTerminate();
 }
@@ -282,7 +300,7 @@ void ResizeViewportCallback(GLFWwindow* window, int width, int height)
 {
 	if (width > 0 && height > 0) {
 		LOG("Resized window to %dx%d\n", width, height);
-		glViewport(0, 0, width, height);
+		RenderDevice::Get()->SetViewport(0, 0, width, height);
 	}
 }
 
@@ -416,8 +434,14 @@ void DebugInfo::Display(const glm::vec3& playerPos, World* world)
 	fpsData << "\nFPS Avg.: " << fpsAverage;
 	fpsData << "\nFPS Min: " << fpsMin;
 
+	RenderDeviceStats deviceStats = RenderDevice::Get()->GetStats();
+	std::stringstream deviceData;
+	deviceData << "GPU Calls: " << deviceStats.numDrawCalls << " draw calls (" << deviceStats.numDraws << " draws), " << deviceStats.numStateChanges << " state changes";
+	deviceData << "\nGPU Data: " << deviceStats.numUploadBytes / 1024 << "KB uploaded, " << deviceStats.numCopyBytes / 1024 << "KB copied";
+
 	ImGui::Text(glVersion.str().c_str());
 	ImGui::Text(fpsData.str().c_str());
+	ImGui::Text(deviceData.str().c_str());
 
 	ImGui::SeparatorText("Game Data:");
 
@@ -432,9 +456,87 @@ void DebugInfo::Display(const glm::vec3& playerPos, World* world)
 	ImGui::Text(playerPosStream.str().c_str());
 
 	std::stringstream chunksCulled;
-	chunksCulled << "No. Chunks Frustum Culled: ";
+	chunksCulled << "No. Chunks Culled: ";
 	chunksCulled << world->NumChunksCulled();
 	ImGui::Text(chunksCulled.str().c_str());
+
+	ChunkQuadtreeStats quadtreeStats = world->GetQuadtreeStats();
+	std::stringstream quadtreeData;
+	quadtreeData << "Quadtree Tests: " << quadtreeStats.numNodesVisited << "/" << quadtreeStats.numNodes << " nodes, ";
+	quadtreeData << quadtreeStats.numChunksTested << " chunks, " << quadtreeStats.numOcclusionTests << " occlusion";
+	ImGui::Text(quadtreeData.str().c_str());
+
+	std::stringstream visibilityData;
+	visibilityData << "Unreachable Chunks: " << world->GetNumUnreachableChunks();
+	visibilityData << " (" << world->GetVisibilityCullTime() * 1000.0 << "ms)";
+	ImGui::Text(visibilityData.str().c_str());
+
+	OcclusionStats occlusionStats = world->GetOcclusionStats();
+	std::stringstream occlusionData;
+	occlusionData << "Occluded Boxes: " << occlusionStats.numOccluded << "/" << occlusionStats.numTested;
+	occlusionData << " (" << occlusionStats.numOccluders << " occluders, " << occlusionStats.numTriangles << " tris)\n";
+	occlusionData << "Occlusion Cull Time: " << world->GetOcclusionCullTime() * 1000.0 << "ms";
+	ImGui::Text(occlusionData.str().c_str());
+
+	WorldStartupStats startupStats = world->GetStartupStats();
+	std::stringstream startupData;
+	startupData << "Time To First Frame: " << startupStats.timeToFirstFrame * 1000.0f << "ms";
+	if (startupStats.hasFinished)
+	{
+		startupData << "\nTime To Full Render Distance: " << startupStats.timeToFullRenderDistance * 1000.0f << "ms";
+	}
+	ImGui::Text(startupData.str().c_str());
+
+	AutosaveStats autosaveStats = world->GetAutosaveStats();
+	std::stringstream autosaveData;
+	autosaveData << "Autosave: " << autosaveStats.numChunksWritten << " chunks, " << autosaveStats.bytesWritten << " bytes";
+	autosaveData << "\nAutosave Pause Max: " << autosaveStats.longestPause * 1000.0f << "ms";
+	ImGui::Text(autosaveData.str().c_str());
+
+	ChunkHandoffStats handoffStats = world->GetHandoffStats();
+	std::stringstream handoffData;
+	handoffData << "Chunk Handoff: " << handoffStats.numResultsApplied << " applied, " << handoffStats.numResultsDropped << " dropped";
+	handoffData << "\nHandoff Latency Avg/Max: " << handoffStats.averageLatency * 1000.0f << "ms / " << handoffStats.longestLatency * 1000.0f << "ms";
+	ImGui::Text(handoffData.str().c_str());
+
+	ChunkRenderStats renderStats = world->GetChunkRenderer()->GetStats();
+	MeshArenaStats arenaStats = world->GetChunkRenderer()->GetArena()->GetStats();
+	RenderQueueStats queueStats = world->GetChunkRenderer()->GetQueueStats();
+	std::stringstream renderData;
+	renderData << "Chunk Draws: " << renderStats.numDraws << " of " << renderStats.numChunks << " in " << renderStats.numCalls << " calls, " << renderStats.buildTime * 1000.0f << "ms to build";
+	renderData << "\nRender Queue: " << queueStats.numItems[static_cast<int>(RenderPass::Opaque)] << " opaque, " << queueStats.numItems[static_cast<int>(RenderPass::Cutout)] << " cutout, ";
+	renderData << queueStats.numItems[static_cast<int>(RenderPass::Translucent)] << " translucent, " << queueStats.numStateChanges << " state changes (" << queueStats.numUnsortedStateChanges << " unsorted), ";
+	renderData << queueStats.sortTime * 1000.0 << "ms to sort";
+	renderData << "\nMesh Arena: " << arenaStats.bytesUsed / 1024 << "KB used of " << arenaStats.bytesCapacity / 1024 << "KB, " << arenaStats.numAllocations << " meshes, " << arenaStats.numGrows << " grows";
+	renderData << "\nArena Free: " << arenaStats.bytesFree / 1024 << "KB in " << arenaStats.numFreeBlocks << " blocks, largest " << arenaStats.largestFreeBlock / 1024 << "KB, " << arenaStats.fragmentation * 100.0f << "% fragmented";
+	ImGui::Text(renderData.str().c_str());
+
+	StagingRingStats stagingStats = world->GetChunkRenderer()->GetArena()->GetStagingBuffer()->GetStats();
+	std::stringstream stagingData;
+	stagingData << "Staging: " << stagingStats.bytesInUse / 1024 << "KB of " << stagingStats.capacity / 1024 << "KB in use, " << stagingStats.numInUse << " meshes, " << stagingStats.numFull << " didn't fit";
+	ImGui::Text(stagingData.str().c_str());
+
+	EpochStats epochStats = world->GetEpochReclaimer()->GetStats();
+	std::stringstream epochData;
+	epochData << "Epoch: " << epochStats.epoch << ", " << epochStats.numPending << " retired (" << epochStats.pendingBytes / 1024 << "KB), " << epochStats.numFreed << " freed";
+	epochData << "\nRetire To Free Avg/Max: " << epochStats.averageFreeLatency * 1000.0f << "ms / " << epochStats.longestFreeLatency * 1000.0f << "ms";
+	ImGui::Text(epochData.str().c_str());
+
+	UploadScheduler* uploadScheduler = world->GetUploadScheduler();
+	UploadStats uploadStats = uploadScheduler->GetStats();
+	std::stringstream uploadData;
+	uploadData << "Uploads: " << uploadStats.numUploaded << " meshes, " << uploadStats.bytesUploaded / 1024 << "KB, " << uploadStats.uploadTime * 1000.0f << "ms";
+	uploadData << "\nUploads Pending: " << uploadStats.numPending;
+	ImGui::Text(uploadData.str().c_str());
+
+	int uploadBudgetKilobytes = uploadScheduler->GetBytesPerFrame() / 1024;
+	float uploadBudgetMilliseconds = uploadScheduler->GetSecondsPerFrame() * 1000.0;
+	bool hasChangedBudget = ImGui::SliderInt("Upload Budget (KB)", &uploadBudgetKilobytes, 64, 16384);
+	hasChangedBudget |= ImGui::SliderFloat("Upload Budget (ms)", &uploadBudgetMilliseconds, 0.1f, 16.0f);
+	if (hasChangedBudget)
+	{
+		uploadScheduler->SetBudget(uploadBudgetKilobytes * 1024, uploadBudgetMilliseconds / 1000.0);
+	}
 #endif
 }
 
@@ -10,6 +10,8 @@
     #include <backends/imgui_impl_opengl3.h>
 #endif
 
+class AssetPack;
+class GLRenderDevice;
 class World;
 
 struct DebugInfo
@@ -55,6 +57,8 @@ struct DebugInfo
 struct Game
 {
 	GLFWwindow* window;
+	GLRenderDevice* renderDevice;
+	AssetPack* assetPack; // open while the game runs, if there is one
 	DebugInfo debugInfo;
     bool hasJustPressedFullscreen;
     bool isFullscreen;
@@ -0,0 +1,383 @@
+#include "glRenderDevice.h"
+
+#include "logging.h"
+
+namespace
+{
+	// Returns 0 and logs the error if it didn't compile
+	unsigned int CompileShader(GLenum type, const char* source)
+	{
+		unsigned int shaderObject = glCreateShader(type);
+		glShaderSource(shaderObject, 1, &source, NULL);
+		glCompileShader(shaderObject);
+
+		int wasSuccessful;
+		glGetShaderiv(shaderObject, GL_COMPILE_STATUS, &wasSuccessful);
+		if (!wasSuccessful)
+		{
+			char infoLog[512];
+			glGetShaderInfoLog(shaderObject, 512, NULL, infoLog);
+			LOG("%s Shader Error: %s\n", type == GL_VERTEX_SHADER ? "Vertex" : "Fragment", infoLog);
+			glDeleteShader(shaderObject);
+			return 0;
+		}
+
+		return shaderObject;
+	}
+}
+
+GLRenderDevice::GLRenderDevice()
+	: RenderDevice()
+{
+	// Read once, so the cached state starts out matching the context
+	isBlendEnabled_ = glIsEnabled(GL_BLEND) == GL_TRUE;
+	isDepthTestEnabled_ = glIsEnabled(GL_DEPTH_TEST) == GL_TRUE;
+	GLboolean depthMask = GL_TRUE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+	isDepthMaskEnabled_ = depthMask == GL_TRUE;
+}
+
+unsigned int GLRenderDevice::CreateBuffer()
+{
+	unsigned int buffer = 0;
+	glCreateBuffers(1, &buffer);
+	return buffer;
+}
+
+void GLRenderDevice::DeleteBuffer(unsigned int buffer)
+{
+	glDeleteBuffers(1, &buffer);
+}
+
+void GLRenderDevice::BufferStorage(unsigned int buffer, size_t size, const void* data, GLbitfield flags)
+{
+	stats_.numUploadBytes += data != nullptr ? size : 0;
+	glNamedBufferStorage(buffer, size, data, flags);
+}
+
+void GLRenderDevice::BufferData(unsigned int buffer, size_t size, const void* data, GLenum usage)
+{
+	stats_.numUploadBytes += data != nullptr ? size : 0;
+	glNamedBufferData(buffer, size, data, usage);
+}
+
+void GLRenderDevice::BufferSubData(unsigned int buffer, size_t offset, size_t size, const void* data)
+{
+	stats_.numUploadBytes += size;
+	glNamedBufferSubData(buffer, offset, size, data);
+}
+
+void GLRenderDevice::CopyBufferSubData(unsigned int source, unsigned int destination, size_t sourceOffset, size_t destinationOffset, size_t size)
+{
+	stats_.numCopyBytes += size;
+	glCopyNamedBufferSubData(source, destination, sourceOffset, destinationOffset, size);
+}
+
+void* GLRenderDevice::MapBufferRange(unsigned int buffer, size_t offset, size_t size, GLbitfield access)
+{
+	return glMapNamedBufferRange(buffer, offset, size, access);
+}
+
+void GLRenderDevice::UnmapBuffer(unsigned int buffer)
+{
+	glUnmapNamedBuffer(buffer);
+}
+
+void GLRenderDevice::BindBuffer(GLenum target, unsigned int buffer)
+{
+	glBindBuffer(target, buffer);
+}
+
+void GLRenderDevice::BindBufferBase(GLenum target, unsigned int index, unsigned int buffer)
+{
+	glBindBufferBase(target, index, buffer);
+}
+
+unsigned int GLRenderDevice::CreateVertexArray()
+{
+	unsigned int vertexArray = 0;
+	glCreateVertexArrays(1, &vertexArray);
+	return vertexArray;
+}
+
+void GLRenderDevice::DeleteVertexArray(unsigned int vertexArray)
+{
+	ForgetVertexArray(vertexArray);
+	glDeleteVertexArrays(1, &vertexArray);
+}
+
+void GLRenderDevice::VertexArrayAttribFormat(unsigned int vertexArray, unsigned int attribute, int size, GLenum type, bool isNormalised, unsigned int offset)
+{
+	glVertexArrayAttribFormat(vertexArray, attribute, size, type, isNormalised ? GL_TRUE : GL_FALSE, offset);
+}
+
+void GLRenderDevice::VertexArrayAttribIFormat(unsigned int vertexArray, unsigned int attribute, int size, GLenum type, unsigned int offset)
+{
+	glVertexArrayAttribIFormat(vertexArray, attribute, size, type, offset);
+}
+
+void GLRenderDevice::VertexArrayAttribBinding(unsigned int vertexArray, unsigned int attribute, unsigned int binding)
+{
+	glVertexArrayAttribBinding(vertexArray, attribute, binding);
+}
+
+void GLRenderDevice::VertexArrayBindingDivisor(unsigned int vertexArray, unsigned int binding, unsigned int divisor)
+{
+	glVertexArrayBindingDivisor(vertexArray, binding, divisor);
+}
+
+void GLRenderDevice::EnableVertexArrayAttrib(unsigned int vertexArray, unsigned int attribute)
+{
+	glEnableVertexArrayAttrib(vertexArray, attribute);
+}
+
+void GLRenderDevice::VertexArrayVertexBuffer(unsigned int vertexArray, unsigned int binding, unsigned int buffer, size_t offset, int stride)
+{
+	glVertexArrayVertexBuffer(vertexArray, binding, buffer, offset, stride);
+}
+
+void GLRenderDevice::VertexArrayElementBuffer(unsigned int vertexArray, unsigned int buffer)
+{
+	glVertexArrayElementBuffer(vertexArray, buffer);
+}
+
+void GLRenderDevice::BindVertexArray(unsigned int vertexArray)
+{
+	if (ChangeState(vertexArray_, vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+	}
+}
+
+unsigned int GLRenderDevice::CreateTexture(GLenum target)
+{
+	unsigned int texture = 0;
+	glCreateTextures(target, 1, &texture);
+	return texture;
+}
+
+void GLRenderDevice::DeleteTexture(unsigned int texture)
+{
+	ForgetTexture(texture);
+	glDeleteTextures(1, &texture);
+}
+
+void GLRenderDevice::TextureParameter(unsigned int texture, GLenum name, GLint value)
+{
+	glTextureParameteri(texture, name, value);
+}
+
+void GLRenderDevice::TextureStorage2D(unsigned int texture, int levels, GLenum internalFormat, int width, int height)
+{
+	glTextureStorage2D(texture, levels, internalFormat, width, height);
+}
+
+void GLRenderDevice::TextureStorage3D(unsigned int texture, int levels, GLenum internalFormat, int width, int height, int depth)
+{
+	glTextureStorage3D(texture, levels, internalFormat, width, height, depth);
+}
+
+void GLRenderDevice::TextureSubImage2D(unsigned int texture, int level, int width, int height, GLenum format, GLenum type, const void* data)
+{
+	stats_.numUploadBytes += GetImageSize(width, height, 1, format, type);
+
+	// Rows aren't padded, i.e. RGB images with odd widths
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTextureSubImage2D(texture, level, 0, 0, width, height, format, type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void GLRenderDevice::TextureSubImage3D(unsigned int texture, int level, int zOffset, int width, int height, int depth, GLenum format, GLenum type,
+	const void* data, int rowLength, int skipPixels, int skipRows)
+{
+	stats_.numUploadBytes += GetImageSize(width, height, depth, format, type);
+
+	// Small mips of RGB data have rows that aren't a multiple of 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, skipPixels);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, skipRows);
+	glTextureSubImage3D(texture, level, 0, 0, zOffset, width, height, depth, format, type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+}
+
+void GLRenderDevice::GenerateTextureMipmap(unsigned int texture)
+{
+	glGenerateTextureMipmap(texture);
+}
+
+void GLRenderDevice::BindTextureUnit(unsigned int unit, unsigned int texture)
+{
+	if (unit >= MAX_TEXTURE_UNITS || ChangeState(textures_[unit], texture))
+	{
+		glBindTextureUnit(unit, texture);
+	}
+}
+
+shader GLRenderDevice::CreateProgram(const char* vertexSource, const char* fragmentSource)
+{
+	unsigned int vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	unsigned int fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	if (vertexShader == 0 || fragmentShader == 0)
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return SHADER_ERROR;
+	}
+
+	shader program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+
+	// The program keeps what it needs from them
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	int wasSuccessful;
+	glGetProgramiv(program, GL_LINK_STATUS, &wasSuccessful);
+	if (!wasSuccessful)
+	{
+		char infoLog[512];
+		glGetProgramInfoLog(program, 512, NULL, infoLog);
+		LOG("Shader Linking Error: %s\n", infoLog);
+		glDeleteProgram(program);
+		return SHADER_ERROR;
+	}
+
+	return program;
+}
+
+void GLRenderDevice::DeleteProgram(shader program)
+{
+	ForgetProgram(program);
+	glDeleteProgram(program);
+}
+
+std::vector<std::pair<std::string, GLint>> GLRenderDevice::GetActiveUniforms(shader program)
+{
+	std::vector<std::pair<std::string, GLint>> uniforms = std::vector<std::pair<std::string, GLint>>();
+
+	GLint numUniforms = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::string name = std::string();
+	for (GLint i = 0; i < numUniforms; i++)
+	{
+		name.resize(maxNameLength);
+		GLsizei nameLength = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(program, i, maxNameLength, &nameLength, &size, &type, &name[0]);
+		name.resize(nameLength);
+
+		uniforms.push_back({ name, glGetUniformLocation(program, name.c_str()) });
+	}
+
+	return uniforms;
+}
+
+void GLRenderDevice::UseProgram(shader program)
+{
+	if (ChangeState(program_, program))
+	{
+		glUseProgram(program);
+	}
+}
+
+void GLRenderDevice::Uniform1i(GLint location, int value)
+{
+	glUniform1i(location, value);
+}
+
+void GLRenderDevice::UniformMatrix4fv(GLint location, const float* value)
+{
+	glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+GLsync GLRenderDevice::FenceSync()
+{
+	return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool GLRenderDevice::IsSyncSignalled(GLsync sync)
+{
+	// Doesn't wait
+	GLenum result = glClientWaitSync(sync, 0, 0);
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void GLRenderDevice::DeleteSync(GLsync sync)
+{
+	glDeleteSync(sync);
+}
+
+void GLRenderDevice::SetBlend(bool isEnabled)
+{
+	if (ChangeState(isBlendEnabled_, isEnabled))
+	{
+		isEnabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+	}
+}
+
+void GLRenderDevice::SetBlendFunction(GLenum source, GLenum destination)
+{
+	glBlendFunc(source, destination);
+}
+
+void GLRenderDevice::SetDepthTest(bool isEnabled)
+{
+	if (ChangeState(isDepthTestEnabled_, isEnabled))
+	{
+		isEnabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+	}
+}
+
+void GLRenderDevice::SetDepthMask(bool isEnabled)
+{
+	if (ChangeState(isDepthMaskEnabled_, isEnabled))
+	{
+		glDepthMask(isEnabled ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void GLRenderDevice::SetViewport(int x, int y, int width, int height)
+{
+	glViewport(x, y, width, height);
+}
+
+void GLRenderDevice::SetClearColour(float r, float g, float b, float a)
+{
+	glClearColor(r, g, b, a);
+}
+
+void GLRenderDevice::Clear(GLbitfield mask)
+{
+	glClear(mask);
+}
+
+void GLRenderDevice::DrawArrays(GLenum mode, int first, int count)
+{
+	stats_.numDrawCalls++;
+	stats_.numDraws++;
+	glDrawArrays(mode, first, count);
+}
+
+void GLRenderDevice::DrawElements(GLenum mode, int count, GLenum type, size_t offset)
+{
+	stats_.numDrawCalls++;
+	stats_.numDraws++;
+	glDrawElements(mode, count, type, reinterpret_cast<const void*>(offset));
+}
+
+void GLRenderDevice::MultiDrawElementsIndirect(GLenum mode, GLenum type, size_t offset, int drawCount, int stride)
+{
+	stats_.numDrawCalls++;
+	stats_.numDraws += drawCount;
+	glMultiDrawElementsIndirect(mode, type, reinterpret_cast<const void*>(offset), drawCount, stride);
+}
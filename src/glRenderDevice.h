@@ -0,0 +1,72 @@
+#pragma once
+#include "renderDevice.h"
+
+/*
+ * The RenderDevice the game runs on, each call is the OpenGL call of
+ * the same name. Needs a current OpenGL 4.5 context with GLAD loaded.
+ *
+ * Binding what's already bound is skipped, so callers don't have to
+ * keep track of it themselves. ImGui restores everything it changes,
+ * so nothing else changes the state behind its back.
+ */
+class GLRenderDevice : public RenderDevice
+{
+public:
+	GLRenderDevice();
+
+	unsigned int CreateBuffer() override;
+	void DeleteBuffer(unsigned int buffer) override;
+	void BufferStorage(unsigned int buffer, size_t size, const void* data, GLbitfield flags) override;
+	void BufferData(unsigned int buffer, size_t size, const void* data, GLenum usage) override;
+	void BufferSubData(unsigned int buffer, size_t offset, size_t size, const void* data) override;
+	void CopyBufferSubData(unsigned int source, unsigned int destination, size_t sourceOffset, size_t destinationOffset, size_t size) override;
+	void* MapBufferRange(unsigned int buffer, size_t offset, size_t size, GLbitfield access) override;
+	void UnmapBuffer(unsigned int buffer) override;
+	void BindBuffer(GLenum target, unsigned int buffer) override;
+	void BindBufferBase(GLenum target, unsigned int index, unsigned int buffer) override;
+
+	unsigned int CreateVertexArray() override;
+	void DeleteVertexArray(unsigned int vertexArray) override;
+	void VertexArrayAttribFormat(unsigned int vertexArray, unsigned int attribute, int size, GLenum type, bool isNormalised, unsigned int offset) override;
+	void VertexArrayAttribIFormat(unsigned int vertexArray, unsigned int attribute, int size, GLenum type, unsigned int offset) override;
+	void VertexArrayAttribBinding(unsigned int vertexArray, unsigned int attribute, unsigned int binding) override;
+	void VertexArrayBindingDivisor(unsigned int vertexArray, unsigned int binding, unsigned int divisor) override;
+	void EnableVertexArrayAttrib(unsigned int vertexArray, unsigned int attribute) override;
+	void VertexArrayVertexBuffer(unsigned int vertexArray, unsigned int binding, unsigned int buffer, size_t offset, int stride) override;
+	void VertexArrayElementBuffer(unsigned int vertexArray, unsigned int buffer) override;
+	void BindVertexArray(unsigned int vertexArray) override;
+
+	unsigned int CreateTexture(GLenum target) override;
+	void DeleteTexture(unsigned int texture) override;
+	void TextureParameter(unsigned int texture, GLenum name, GLint value) override;
+	void TextureStorage2D(unsigned int texture, int levels, GLenum internalFormat, int width, int height) override;
+	void TextureStorage3D(unsigned int texture, int levels, GLenum internalFormat, int width, int height, int depth) override;
+	void TextureSubImage2D(unsigned int texture, int level, int width, int height, GLenum format, GLenum type, const void* data) override;
+	void TextureSubImage3D(unsigned int texture, int level, int zOffset, int width, int height, int depth, GLenum format, GLenum type,
+		const void* data, int rowLength, int skipPixels, int skipRows) override;
+	void GenerateTextureMipmap(unsigned int texture) override;
+	void BindTextureUnit(unsigned int unit, unsigned int texture) override;
+
+	shader CreateProgram(const char* vertexSource, const char* fragmentSource) override;
+	void DeleteProgram(shader program) override;
+	std::vector<std::pair<std::string, GLint>> GetActiveUniforms(shader program) override;
+	void UseProgram(shader program) override;
+	void Uniform1i(GLint location, int value) override;
+	void UniformMatrix4fv(GLint location, const float* value) override;
+
+	GLsync FenceSync() override;
+	bool IsSyncSignalled(GLsync sync) override;
+	void DeleteSync(GLsync sync) override;
+
+	void SetBlend(bool isEnabled) override;
+	void SetBlendFunction(GLenum source, GLenum destination) override;
+	void SetDepthTest(bool isEnabled) override;
+	void SetDepthMask(bool isEnabled) override;
+	void SetViewport(int x, int y, int width, int height) override;
+	void SetClearColour(float r, float g, float b, float a) override;
+	void Clear(GLbitfield mask) override;
+
+	void DrawArrays(GLenum mode, int first, int count) override;
+	void DrawElements(GLenum mode, int count, GLenum type, size_t offset) override;
+	void MultiDrawElementsIndirect(GLenum mode, GLenum type, size_t offset, int drawCount, int stride) override;
+};
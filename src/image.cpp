@@ -3,6 +3,8 @@
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "renderDevice.h"
+
 Image::Image(const char* imageFile)
 {
 	TextureData textureData = Texture2D::LoadTextureDataFromFile(imageFile, 4);
@@ -19,29 +21,31 @@ Image::Image(const char* imageFile)
 		{{1.0f, -1.0f, 0.0f}, {1.0f, 0.0f}}, // BR
 	};
 
-	glCreateVertexArrays(1, &vao_);
-	glBindVertexArray(vao_);
-
-	glCreateBuffers(1, &vbo_);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(ImageVertex) * 6, vertices, GL_STATIC_DRAW);
+	RenderDevice* device = RenderDevice::Get();
+	vao_ = device->CreateVertexArray();
+	vbo_ = device->CreateBuffer();
+	device->BufferData(vbo_, sizeof(ImageVertex) * 6, vertices, GL_STATIC_DRAW);
+	device->VertexArrayVertexBuffer(vao_, 0, vbo_, 0, sizeof(ImageVertex));
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ImageVertex), (void*)0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImageVertex), (void*)(3 * sizeof(float)));
+	device->VertexArrayAttribFormat(vao_, 0, 3, GL_FLOAT, false, 0);
+	device->VertexArrayAttribFormat(vao_, 1, 2, GL_FLOAT, false, 3 * sizeof(float));
 
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-
-	// Unbind
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	for (int attribute = 0; attribute < 2; attribute++)
+	{
+		device->VertexArrayAttribBinding(vao_, attribute, 0);
+		device->EnableVertexArrayAttrib(vao_, attribute);
+	}
 
 	// Create the Shader
 	imageShader_ = CreateShader("./Assets/image.vert", "./Assets/image.frag");
 
-	glUseProgram(imageShader_);
-	glUniform1i(glGetAttribLocation(imageShader_, "imageTexture"), 0);
-	glUseProgram(0);
+	ShaderReflection reflection = ShaderReflection(imageShader_);
+	projectionLocation_ = reflection.GetUniformLocation("projection");
+	modelLocation_ = reflection.GetUniformLocation("model");
+
+	device->UseProgram(imageShader_);
+	device->Uniform1i(reflection.GetUniformLocation("imageTexture"), 0);
+	device->UseProgram(0);
 
 	if (textureData.data)
 		free(textureData.data);
@@ -49,8 +53,9 @@ Image::Image(const char* imageFile)
 
 void Image::Draw(glm::mat4 orthoProjection, glm::vec2 pos, glm::vec2 rotation, glm::vec2 scale)
 {
-	glUseProgram(imageShader_);
-	glBindVertexArray(vao_);
+	RenderDevice* device = RenderDevice::Get();
+	device->UseProgram(imageShader_);
+	device->BindVertexArray(vao_);
 	texture_->Bind(GL_TEXTURE0);
 
 	glm::mat4 model = glm::mat4(1.0f);
@@ -60,12 +65,12 @@ void Image::Draw(glm::mat4 orthoProjection, glm::vec2 pos, glm::vec2 rotation, g
 	model = glm::rotate(model, 0.0f, glm::vec3(0.0f, 0.0f, 1.0f));
 	model = glm::scale(model, glm::vec3(scale, 1.0f));
 
-	glUniformMatrix4fv(glGetUniformLocation(imageShader_, "projection"), 1, GL_FALSE, glm::value_ptr(orthoProjection));
-	glUniformMatrix4fv(glGetUniformLocation(imageShader_, "model"), 1, GL_FALSE, glm::value_ptr(model));
+	device->UniformMatrix4fv(projectionLocation_, glm::value_ptr(orthoProjection));
+	device->UniformMatrix4fv(modelLocation_, glm::value_ptr(model));
 
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	device->DrawArrays(GL_TRIANGLES, 0, 6);
 
 	texture_->Unbind(GL_TEXTURE0);
-	glBindVertexArray(0);
-	glUseProgram(0);
+	device->BindVertexArray(0);
+	device->UseProgram(0);
 }
\ No newline at end of file
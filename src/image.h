@@ -19,5 +19,7 @@ public:
 protected:
 	GLuint vao_, vbo_;
 	shader imageShader_;
+	GLint projectionLocation_;
+	GLint modelLocation_;
 	Texture2D* texture_;
 };
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "jobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+	// The index of the worker's queue, -1 for threads that aren't workers
+	thread_local int currentQueueIndex = -1;
+	thread_local JobSystem* currentJobSystem = nullptr;
+}
+
+JobCounter::JobCounter()
+{
+	numJobs_.store(0);
+}
+
+void JobCounter::Add(int numJobs)
+{
+	numJobs_.fetch_add(numJobs);
+}
+
+bool JobCounter::Done()
+{
+	return numJobs_.fetch_sub(1) == 1;
+}
+
+bool JobCounter::IsDone()
+{
+	return numJobs_.load() == 0;
+}
+
+JobSystem::JobSystem(int numThreads)
+{
+	if (numThreads <= 0)
+	{
+		numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	numQueuedJobs_.store(0);
+	nextExternalQueue_.store(0);
+	numJobsRun_.store(0);
+	numJobsStolen_.store(0);
+	numWaiting_.store(0);
+	shouldStop_ = false;
+
+	queues_ = std::vector<std::unique_ptr<WorkerQueue>>();
+	for (int i = 0; i < numThreads; i++)
+	{
+		queues_.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	threads_ = std::vector<std::thread>();
+	for (int i = 0; i < numThreads; i++)
+	{
+		threads_.push_back(std::thread(&JobSystem::RunThread, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+		shouldStop_ = true;
+	}
+	sleepCondition_.notify_all();
+
+	for (std::thread& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+void JobSystem::Schedule(std::function<void()> func, JobCounter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->Add(1);
+	}
+
+	// Workers keep the jobs they schedule, everyone else spreads them out
+	int queueIndex = currentQueueIndex;
+	if (currentJobSystem != this || queueIndex < 0)
+	{
+		queueIndex = nextExternalQueue_.fetch_add(1) % queues_.size();
+	}
+
+	WorkerQueue& queue = *queues_[queueIndex];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back({ std::move(func), counter });
+	}
+	numQueuedJobs_.fetch_add(1);
+
+	// Taking the lock means a worker can't miss the wake up between
+	// checking for jobs and going to sleep
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+	}
+	sleepCondition_.notify_one();
+
+	// A waiting thread can run it too
+	WakeWaiting();
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+	int queueIndex = currentJobSystem == this ? currentQueueIndex : -1;
+
+	while (!counter->IsDone())
+	{
+		Job job;
+		if (TryGetJob(queueIndex, job))
+		{
+			RunJob(job);
+			continue;
+		}
+
+		// The last jobs are running on other threads. Counting this thread as
+		// waiting before checking means whoever schedules a job or finishes
+		// the counter after the check sees it and wakes it up.
+		std::unique_lock<std::mutex> lock(waitMutex_);
+		numWaiting_.fetch_add(1);
+		waitCondition_.wait(lock, [this, counter]() { return counter->IsDone() || numQueuedJobs_.load() > 0; });
+		numWaiting_.fetch_sub(1);
+	}
+}
+
+void JobSystem::WakeWaiting()
+{
+	if (numWaiting_.load() == 0)
+	{
+		return;
+	}
+
+	// Same as the workers, the lock stops the wake up landing between a
+	// waiting thread's check and it going to sleep
+	{
+		std::lock_guard<std::mutex> lock(waitMutex_);
+	}
+	waitCondition_.notify_all();
+}
+
+void JobSystem::ParallelFor(int count, const std::function<void(int)>& func)
+{
+	JobCounter counter = JobCounter();
+	for (int i = 0; i < count; i++)
+	{
+		Schedule([&func, i]() { func(i); }, &counter);
+	}
+
+	Wait(&counter);
+}
+
+int JobSystem::GetNumThreads()
+{
+	return threads_.size();
+}
+
+JobSystemStats JobSystem::GetStats()
+{
+	return { GetNumThreads(), numJobsRun_.load(), numJobsStolen_.load() };
+}
+
+void JobSystem::RunThread(int index)
+{
+	currentQueueIndex = index;
+	currentJobSystem = this;
+
+	while (true)
+	{
+		Job job;
+		if (TryGetJob(index, job))
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex_);
+		sleepCondition_.wait(lock, [this]() { return shouldStop_ || numQueuedJobs_.load() > 0; });
+
+		if (shouldStop_)
+		{
+			return;
+		}
+	}
+}
+
+bool JobSystem::TryGetJob(int queueIndex, Job& jobOut)
+{
+	if (queueIndex >= 0)
+	{
+		WorkerQueue& queue = *queues_[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.jobs.empty())
+		{
+			jobOut = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			numQueuedJobs_.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// Start at the next queue along so the workers don't all steal from the same one
+	int numQueues = queues_.size();
+	int firstVictimIndex = queueIndex >= 0 ? queueIndex + 1 : nextExternalQueue_.load();
+	for (int i = 0; i < numQueues; i++)
+	{
+		int victimIndex = (firstVictimIndex + i) % numQueues;
+		if (victimIndex == queueIndex)
+		{
+			continue;
+		}
+
+		WorkerQueue& queue = *queues_[victimIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.jobs.empty())
+		{
+			jobOut = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			numQueuedJobs_.fetch_sub(1);
+			numJobsStolen_.fetch_add(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::RunJob(Job& job)
+{
+	job.func();
+	numJobsRun_.fetch_add(1);
+
+	if (job.counter != nullptr && job.counter->Done())
+	{
+		WakeWaiting();
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Counts the jobs that still have to finish. A job scheduled against
+ * a counter can schedule its children against the same counter, the
+ * counter won't reach zero until the parent and all of its children
+ * are done.
+ */
+class JobCounter
+{
+	std::atomic<int> numJobs_;
+public:
+	JobCounter();
+
+	void Add(int numJobs);
+
+	// Returns true if that was the last job
+	bool Done();
+	bool IsDone();
+};
+
+struct Job
+{
+	std::function<void()> func;
+	JobCounter* counter;
+};
+
+struct JobSystemStats
+{
+	int numThreads;
+	uint64_t numJobsRun;
+	uint64_t numJobsStolen;
+};
+
+/*
+ * A pool of worker threads that run small jobs, i.e. generating
+ * or meshing a single chunk.
+ *
+ * Every worker has its own deque. Workers push and pop their own jobs
+ * from the back, so the jobs a job schedules are run while their data
+ * is still in the cache, and steal the oldest jobs from the front of
+ * the other deques when their own is empty. Workers with nothing to
+ * run or steal sleep until a job is scheduled.
+ *
+ * Waiting on a counter runs jobs on the waiting thread until the
+ * counter is done, so jobs can wait on their children without
+ * holding up a worker. Once the last jobs are running elsewhere it
+ * sleeps rather than spinning.
+ */
+class JobSystem
+{
+	struct WorkerQueue
+	{
+		std::deque<Job> jobs;
+		std::mutex mutex;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues_;
+	std::vector<std::thread> threads_;
+
+	std::atomic<int> numQueuedJobs_;
+	std::atomic<int> nextExternalQueue_;
+	std::atomic<uint64_t> numJobsRun_;
+	std::atomic<uint64_t> numJobsStolen_;
+
+	// Idle workers sleep on this
+	std::mutex sleepMutex_;
+	std::condition_variable sleepCondition_;
+	bool shouldStop_;
+
+	// Threads in Wait with nothing to run sleep on this until a job is
+	// scheduled or a counter finishes
+	std::mutex waitMutex_;
+	std::condition_variable waitCondition_;
+	std::atomic<int> numWaiting_;
+	void WakeWaiting();
+
+	void RunThread(int index);
+
+	// Pops from the back of the thread's own queue, then steals from the
+	// front of the others. Threads that aren't workers only steal.
+	bool TryGetJob(int queueIndex, Job& jobOut);
+	void RunJob(Job& job);
+public:
+	// Uses one thread per core if numThreads is 0
+	JobSystem(int numThreads = 0);
+	~JobSystem();
+
+	void Schedule(std::function<void()> func, JobCounter* counter = nullptr);
+
+	// Runs other jobs on this thread until the counter is done
+	void Wait(JobCounter* counter);
+
+	// Schedules a job for every index from 0 to count and waits for them
+	void ParallelFor(int count, const std::function<void(int)>& func);
+
+	int GetNumThreads();
+	JobSystemStats GetStats();
+};
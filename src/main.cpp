@@ -1,15 +1,81 @@
 #include <iostream>
+#include <string.h>
 #include "logging.h"
 #include "game.h"
+#include "assetPack.h"
+#include "chunkCodec.h"
+#include "chunkQuadtree.h"
+#include "chunkVisibility.h"
+#include "drawCommands.h"
+#include "frustumCuller.h"
+#include "occlusionCuller.h"
+#include "rangeAllocator.h"
+#include "renderQueue.h"
+#include "stagingRing.h"
+#include "textureBaker.h"
+#include "world.h"
 #include <FastNoise/FastNoise.h>
 
-/*
- * The entry point for the game.
- */
+namespace
+{
+	// Runs instead of the game when its flag is the first argument
+	struct Tool
+	{
+		const char* flag;
+		bool (*run)();
+	};
+
+	// None of these need a window or a GPU
+	const Tool TOOLS[] = {
+		// The chunk codec benchmark
+		{ "--benchmark-codec", []() { return ChunkCodec::RunBenchmark({ 1, 1337, 42069, 987654321 }, 5); } },
+		// The chunk streaming benchmark
+		{ "--benchmark-jobs", []() { return World::RunStreamingBenchmark(1337, 8); } },
+		// The chunk draw command benchmark
+		{ "--benchmark-draws", []() { return DrawCommandBuilder::RunBenchmark(16); } },
+		// The mesh arena allocator benchmark
+		{ "--benchmark-arena", []() { return RangeAllocator::RunBenchmark(1337, 200000); } },
+		// The staging ring benchmark
+		{ "--benchmark-staging", []() { return StagingRing::RunBenchmark(2000); } },
+		// The occlusion culling benchmark
+		{ "--benchmark-occlusion", []() { return OcclusionCuller::RunBenchmark(16); } },
+		// The cave culling benchmark
+		{ "--benchmark-visibility", []() { return ChunkVisibilityGraph::RunBenchmark(16); } },
+		// The frustum culling benchmark
+		{ "--benchmark-frustum", []() { return FrustumCuller::RunBenchmark(32); } },
+		// The quadtree culling benchmark
+		{ "--benchmark-quadtree", []() { return ChunkQuadtree::RunBenchmark(32); } },
+		// The render queue benchmark
+		{ "--benchmark-renderqueue", []() { return RenderQueue::RunBenchmark(16); } },
+		// Frames of the world on the null render device
+		{ "--benchmark-headless", []() { return World::RunFrameBenchmark(5, 600); } },
+		// Bakes the texture atlas and prints how much startup time that saves
+		{ "--bake-textures", []() { return TextureBaker::RunBake("./Assets/textureAtlas.png", "./Assets/textureAtlas.baked", 6, 8); } },
+		// Packs the Assets folder into Assets.pack
+		{ "--build-asset-pack", []() {
+			// The atlas goes in baked, so bake it first if it's out of date
+			BakedTexture bakedTexture{};
+			return TextureBaker::LoadOrBake("./Assets/textureAtlas.png", "./Assets/textureAtlas.baked", 6, 8, bakedTexture) &&
+				AssetPack::Build("./Assets", "./Assets.pack");
+		} },
+		// The collision query benchmark
+		{ "--benchmark-collision", []() { return World::RunCollisionBenchmark(1337, 8); } },
+	};
+}
+
+// The entry point for the game, or one of the tools above
 int main(int argc, char **argv)
 {
+	for (const Tool& tool : TOOLS)
+	{
+		if (argc > 1 && strcmp(argv[1], tool.flag) == 0)
+		{
+			return tool.run() ? 0 : 1;
+		}
+	}
+
 	LOG("Launching the game!\n");
 	Game game = Game();
 	game.Run();
 	return 0;
-}
\ No newline at end of file
+}
@@ -5,6 +5,8 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "logging.h"
+#include "meshArena.h"
+#include "renderDevice.h"
 
 std::unordered_map<MeshType, MeshTypeCommonData> Mesh::commonData_;
 
@@ -17,50 +19,65 @@ bool Vertex::operator==(Vertex const& vertex) const
 }
 
 Mesh::Mesh()
-{}
+{
+	arena_ = nullptr;
+	arenaHandle_ = -1;
+	hasStagedMesh_ = false;
+}
 
-Mesh::Mesh(Texture2DArray* texture, const MeshType& type)
+Mesh::Mesh(Texture2DArray* texture, const MeshType& type, MeshArena* arena)
 {
 	vertices_ = std::vector<Vertex>();
 	indices_ = std::vector<unsigned int>();
 	texture_ = texture;
 	type_ = type;
+	arena_ = arena;
+	arenaHandle_ = -1;
+	hasStagedMesh_ = false;
+	shouldUpdateOnGPU.store(false);
+	numIndicesOnGPU_ = 0;
+	passIndexCounts_ = { 0, 0, 0 };
+	passIndexCountsOnGPU_ = { 0, 0, 0 };
 
-	glUseProgram(commonData_.at(type_).shaderProgram);
-
-	// Tell the shader which texture unit to use.
-	unsigned int textureLoc = glGetUniformLocation(commonData_.at(type_).shaderProgram, "texture1");
-	glUniform1i(textureLoc, 0);
+	if (arena_ != nullptr)
+	{
+		return;
+	}
 
 	// Create the vao, vbo and ebo
-	glCreateVertexArrays(1, &vao_);
-
-	glBindVertexArray(vao_);
-	glCreateBuffers(1, &vbo_);
-	glCreateBuffers(1, &ebo_);
+	RenderDevice* device = RenderDevice::Get();
+	vao_ = device->CreateVertexArray();
+	vbo_ = device->CreateBuffer();
+	ebo_ = device->CreateBuffer();
 
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+	device->VertexArrayVertexBuffer(vao_, 0, vbo_, 0, sizeof(Vertex));
+	device->VertexArrayElementBuffer(vao_, ebo_);
 
 	// Position of the vertex
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex), (void*)0);
+	device->VertexArrayAttribFormat(vao_, 0, 3, GL_FLOAT, true, 0);
 	// Normal vector for the vertex
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
+	device->VertexArrayAttribFormat(vao_, 1, 3, GL_FLOAT, false, 3 * sizeof(float));
 	// Texture coordinates for the vertex
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(6 * sizeof(float)));
+	device->VertexArrayAttribFormat(vao_, 2, 2, GL_FLOAT, false, 6 * sizeof(float));
 	// Texture Atlas Index
-	glVertexAttribIPointer(3, 1, GL_INT, sizeof(Vertex), (void*)(8 * sizeof(float)));
+	device->VertexArrayAttribIFormat(vao_, 3, 1, GL_INT, 8 * sizeof(float));
 
 	// Enable the vertex attributes
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glEnableVertexAttribArray(3);
-
-	shouldUpdateOnGPU.store(false);
+	for (int attribute = 0; attribute < 4; attribute++)
+	{
+		device->VertexArrayAttribBinding(vao_, attribute, 0);
+		device->EnableVertexArrayAttrib(vao_, attribute);
+	}
 }
 
 Mesh::~Mesh()
 {
+	if (arena_ != nullptr)
+	{
+		DropStagedMesh();
+		arena_->Free(arenaHandle_);
+	}
+
 	/*
 	if (glIsBuffer(vbo_) == GL_TRUE)
 		glDeleteBuffers(1, &vbo_);
@@ -129,16 +146,60 @@ void Mesh::AddFace(std::vector<Vertex> vertices)
 
 void Mesh::SetVertices(std::vector<Vertex>& vertices)
 {
+	DropStagedMesh();
 	vertices_ = vertices;
 	shouldUpdateOnGPU.store(true);
 }
 
 void Mesh::SetIndices(std::vector<unsigned int>& indices)
 {
+	DropStagedMesh();
 	indices_ = indices;
+	passIndexCounts_ = { static_cast<uint32_t>(indices_.size()), 0, 0 };
+	shouldUpdateOnGPU.store(true);
+}
+
+void Mesh::SetVertices(std::vector<Vertex>&& vertices)
+{
+	DropStagedMesh();
+	vertices_ = std::move(vertices);
 	shouldUpdateOnGPU.store(true);
 }
 
+void Mesh::SetIndices(std::vector<unsigned int>&& indices)
+{
+	DropStagedMesh();
+	indices_ = std::move(indices);
+	passIndexCounts_ = { static_cast<uint32_t>(indices_.size()), 0, 0 };
+	shouldUpdateOnGPU.store(true);
+}
+
+void Mesh::SetPassIndexCounts(const PassIndexCounts& passIndexCounts)
+{
+	passIndexCounts_ = passIndexCounts;
+}
+
+const PassIndexCounts& Mesh::GetPassIndexCountsOnGPU()
+{
+	return passIndexCountsOnGPU_;
+}
+
+void Mesh::SetStagedMesh(const StagedMesh& stagedMesh)
+{
+	DropStagedMesh();
+	stagedMesh_ = stagedMesh;
+	hasStagedMesh_ = true;
+}
+
+void Mesh::DropStagedMesh()
+{
+	if (hasStagedMesh_)
+	{
+		arena_->GetStagingBuffer()->Release(stagedMesh_);
+		hasStagedMesh_ = false;
+	}
+}
+
 void Mesh::AddFace(std::vector<unsigned int> indices)
 {
 	indices_.insert(indices_.end(), indices.begin(), indices.end());
@@ -151,55 +212,121 @@ int Mesh::GetNumVertices()
 
 void Mesh::SetModel(glm::mat4 const& model)
 {
-	shader shaderProgram = commonData_.at(type_).shaderProgram;
-	glUseProgram(shaderProgram);
-	unsigned int modelLoc = glGetUniformLocation(shaderProgram, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	const MeshTypeCommonData& commonData = commonData_.at(type_);
+
+	// The chunk shader doesn't have one, chunks are moved by their draw data instead
+	if (commonData.modelLocation == -1)
+	{
+		return;
+	}
+
+	RenderDevice* device = RenderDevice::Get();
+	device->UseProgram(commonData.shaderProgram);
+	device->UniformMatrix4fv(commonData.modelLocation, glm::value_ptr(model));
 }
 
 void Mesh::StartDrawBatch(const MeshType& type)
 {
 	const MeshTypeCommonData& commonData = commonData_.at(type);
-	glUseProgram(commonData.shaderProgram);
+	RenderDevice* device = RenderDevice::Get();
+	device->UseProgram(commonData.shaderProgram);
+	device->BindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, commonData.frameUniformBuffer);
 }
 
 void Mesh::EndDrawBatch()
 {
-	glUseProgram(0);
+	RenderDevice::Get()->UseProgram(0);
 }
 
 void Mesh::Draw(glm::mat4 const& model)
 {
-	// Since I use batching, this needs to be specified :-
-	unsigned int textureLoc = glGetUniformLocation(commonData_.at(type_).shaderProgram, "texture1");
-	glUniform1i(textureLoc, 0);
+	// Drawn along with the rest of the arena
+	if (arena_ != nullptr)
+	{
+		return;
+	}
 
 	SetModel(model);
 
 	texture_->Bind(GL_TEXTURE0);
 
-	glBindVertexArray(vao_);
+	// The ebo is part of the vao
+	RenderDevice* device = RenderDevice::Get();
+	device->BindVertexArray(vao_);
+	device->DrawElements(GL_TRIANGLES, numIndicesOnGPU_, GL_UNSIGNED_INT, 0);
+
+	texture_->Unbind(GL_TEXTURE0);
+}
+
+bool Mesh::NeedsUpload()
+{
+	return shouldUpdateOnGPU.load();
+}
 
-	if (shouldUpdateOnGPU.load())
+size_t Mesh::GetUploadSize()
+{
+	return vertices_.size() * sizeof(Vertex) + indices_.size() * sizeof(unsigned int);
+}
+
+size_t Mesh::Upload()
+{
+	if (arena_ != nullptr)
 	{
-		glNamedBufferData(vbo_, vertices_.size() * sizeof(Vertex), vertices_.data(), GL_DYNAMIC_DRAW);
-		glNamedBufferData(ebo_, indices_.size() * sizeof(unsigned int), indices_.data(), GL_DYNAMIC_DRAW);
+		if (hasStagedMesh_)
+		{
+			// The arena releases it once the copy's been issued
+			arenaHandle_ = arena_->UploadStaged(arenaHandle_, stagedMesh_);
+			hasStagedMesh_ = false;
+		}
+		else
+		{
+			arenaHandle_ = arena_->Upload(arenaHandle_, vertices_, indices_);
+		}
 
+		numIndicesOnGPU_ = indices_.size();
+		passIndexCountsOnGPU_ = passIndexCounts_;
 		shouldUpdateOnGPU.store(false);
+
+		return GetUploadSize();
 	}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-	glDrawElements(GL_TRIANGLES, indices_.size(), GL_UNSIGNED_INT, nullptr);
+	RenderDevice* device = RenderDevice::Get();
+	device->BufferData(vbo_, vertices_.size() * sizeof(Vertex), vertices_.data(), GL_DYNAMIC_DRAW);
+	device->BufferData(ebo_, indices_.size() * sizeof(unsigned int), indices_.data(), GL_DYNAMIC_DRAW);
 
-	texture_->Unbind(GL_TEXTURE0);
+	numIndicesOnGPU_ = indices_.size();
+	passIndexCountsOnGPU_ = passIndexCounts_;
+	shouldUpdateOnGPU.store(false);
+
+	return GetUploadSize();
 }
 
 void Mesh::Unload()
 {
-	glNamedBufferData(vbo_, vertices_.size() * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
-	glNamedBufferData(ebo_, indices_.size() * sizeof(unsigned int), NULL, GL_DYNAMIC_DRAW);
+	if (arena_ != nullptr)
+	{
+		DropStagedMesh();
+		arena_->Free(arenaHandle_);
+		arenaHandle_ = -1;
+	}
+	else
+	{
+		RenderDevice* device = RenderDevice::Get();
+		device->BufferData(vbo_, vertices_.size() * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
+		device->BufferData(ebo_, indices_.size() * sizeof(unsigned int), NULL, GL_DYNAMIC_DRAW);
+	}
 	vertices_.clear();
 	indices_.clear();
+
+	numIndicesOnGPU_ = 0;
+	passIndexCounts_ = { 0, 0, 0 };
+	passIndexCountsOnGPU_ = { 0, 0, 0 };
+	shouldUpdateOnGPU.store(false);
+}
+
+int Mesh::GetArenaHandle()
+{
+	return arenaHandle_;
 }
 
 std::vector<Vertex>& Mesh::GetVertices()
@@ -217,29 +344,34 @@ void Mesh::CreateCommonData(MeshType type)
 	MeshTypeCommonData commonData{};
 	commonData.shaderProgram = CreateShader("./Assets/mesh.vert", "./Assets/mesh.frag");
 
+	// Look the uniforms up once here, rather than by name every draw
+	ShaderReflection reflection = ShaderReflection(commonData.shaderProgram);
+	commonData.modelLocation = reflection.GetUniformLocation("model");
+
+	// Every mesh's texture is bound to unit 0, so this never changes
+	RenderDevice* device = RenderDevice::Get();
+	device->UseProgram(commonData.shaderProgram);
+	device->Uniform1i(reflection.GetUniformLocation("texture1"), 0);
+	device->UseProgram(0);
+
+	commonData.frameUniformBuffer = device->CreateBuffer();
+	device->BufferStorage(commonData.frameUniformBuffer, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
 	SetCommonData(type, commonData);
 }
 
 void Mesh::SetCommonData(MeshType type, MeshTypeCommonData commonData)
 {
-	shader shaderProgram = commonData.shaderProgram;
-	glUseProgram(shaderProgram);
-
-	// Update View Position (For Lighting in Fragment Shader)
-	GLuint viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
-	glUniform3f(viewPosLoc, commonData.viewPos.x, commonData.viewPos.y, commonData.viewPos.z);
-
-
-	// Update View Matrix (For Vertex Shader)
-	unsigned int viewLoc = glGetUniformLocation(shaderProgram, "view");
-	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(commonData.view));
-
-	// Update Projection Matrix (For Vertex Shader)
-	unsigned int projectionlLoc = glGetUniformLocation(shaderProgram, "projection");
-	glUniformMatrix4fv(projectionlLoc, 1, GL_FALSE, glm::value_ptr(commonData.projection));
-
-	// Set Directional Light
-	PassDirectionalLightToShader(shaderProgram, commonData.directionalLight);
+	// All of it goes to the uniform buffer in one go, StartDrawBatch binds it
+	FrameUniforms frameUniforms{};
+	frameUniforms.view = commonData.view;
+	frameUniforms.projection = commonData.projection;
+	frameUniforms.viewPos = glm::vec4(commonData.viewPos, 0.0f);
+	frameUniforms.lightDirection = glm::vec4(commonData.directionalLight.direction, 0.0f);
+	frameUniforms.lightAmbient = glm::vec4(commonData.directionalLight.ambient, 0.0f);
+	frameUniforms.lightDiffuse = glm::vec4(commonData.directionalLight.diffuse, 0.0f);
+	frameUniforms.lightSpecular = glm::vec4(commonData.directionalLight.specular, 0.0f);
+	RenderDevice::Get()->BufferSubData(commonData.frameUniformBuffer, 0, sizeof(FrameUniforms), &frameUniforms);
 
 	// Pass Data to the Static HashMap
 	commonData_.insert_or_assign(type, commonData);
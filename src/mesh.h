@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <atomic>
 #include <unordered_map>
 #include <vector>
@@ -6,9 +7,16 @@
 #include <glm/fwd.hpp>
 
 #include "meshTypes.h"
+#include "renderQueue.h"
 #include "shader.h"
+#include "stagingRing.h"
 #include "texture.h"
 
+class MeshArena;
+
+// How many of a mesh's indices are in each pass, the indices are sorted by pass
+typedef std::array<uint32_t, NUM_RENDER_PASSES> PassIndexCounts;
+
 struct Vertex
 {
 	float x;
@@ -53,13 +61,32 @@ class Mesh
 
 	std::atomic<bool> shouldUpdateOnGPU{false};
 
+	// Meshes in an arena share its buffers instead of having their own,
+	// and are drawn all at once by whatever owns the arena
+	MeshArena* arena_;
+	int arenaHandle_;
+
+	// Set when a worker wrote the mesh into the arena's staging buffer,
+	// so uploading is a copy on the GPU
+	StagedMesh stagedMesh_;
+	bool hasStagedMesh_;
+
+	void DropStagedMesh();
+
+	// What was last uploaded, the vertices and indices can be newer
+	// than this while the upload waits for the UploadScheduler
+	int numIndicesOnGPU_;
+
+	PassIndexCounts passIndexCounts_;
+	PassIndexCounts passIndexCountsOnGPU_;
+
 	static std::unordered_map<MeshType, MeshTypeCommonData> commonData_;
 public:
 	// Default constructor, this is only to satisfy C++, you shouldn't use this
 	// constructor.
 	Mesh();
 
-	Mesh(Texture2DArray* texture, const MeshType& type);
+	Mesh(Texture2DArray* texture, const MeshType& type, MeshArena* arena = nullptr);
 	~Mesh();
 
 	/*
@@ -80,6 +107,19 @@ public:
 	void SetVertices(std::vector<Vertex>& vertices);
 	void SetIndices(std::vector<unsigned int>& indices);
 
+	// Takes the data rather than copying it, i.e. for meshes built on another thread
+	void SetVertices(std::vector<Vertex>&& vertices);
+	void SetIndices(std::vector<unsigned int>&& indices);
+
+	// The vertices and indices that were just set are also in the arena's staging buffer, call after setting them
+	void SetStagedMesh(const StagedMesh& stagedMesh);
+
+	// Setting the indices puts them all in the opaque pass, call this after to split them up
+	void SetPassIndexCounts(const PassIndexCounts& passIndexCounts);
+
+	// For what was last uploaded, so it matches the arena allocation
+	const PassIndexCounts& GetPassIndexCountsOnGPU();
+
 	int GetNumVertices();
 
 	shader GetShaderProgram();
@@ -96,11 +136,23 @@ public:
 	 * Draws the mesh to the screen.
 	 * IMPORTANT: This doesn't set the shader, you need to
 	 * call StartDrawBatch to do that.
+	 *
+	 * This draws what's on the GPU, changes to the vertices
+	 * and indices only show up once Upload has been called.
 	 */
 	void Draw(glm::mat4 const& model);
 
+	bool NeedsUpload();
+	size_t GetUploadSize(); // bytes
+
+	// Copies the vertices and indices to the GPU, returns the bytes uploaded
+	size_t Upload();
+
 	void Unload();
 
+	// The mesh's range in its arena, -1 if it isn't in one or hasn't been uploaded
+	int GetArenaHandle();
+
 	std::vector<Vertex>& GetVertices();
 
 	const MeshType& GetMeshType();
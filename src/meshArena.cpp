@@ -0,0 +1,229 @@
+#include "meshArena.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <glad/gl.h>
+
+#include "logging.h"
+#include "renderDevice.h"
+
+MeshArena::MeshArena(uint32_t vertexCapacity, uint32_t indexCapacity)
+	: vertexAllocator_(vertexCapacity), indexAllocator_(indexCapacity)
+{
+	allocations_ = std::vector<MeshArenaAllocation>();
+	freeHandles_ = std::vector<int>();
+	numGrows_ = 0;
+
+	// Room for a few hundred chunk meshes waiting to be copied in
+	stagingBuffer_ = new StagingBuffer(32 * 1024 * 1024);
+
+	RenderDevice* device = RenderDevice::Get();
+	vao_ = device->CreateVertexArray();
+
+	// Position of the vertex
+	device->VertexArrayAttribFormat(vao_, 0, 3, GL_FLOAT, false, offsetof(Vertex, x));
+	// Normal vector for the vertex
+	device->VertexArrayAttribFormat(vao_, 1, 3, GL_FLOAT, false, offsetof(Vertex, normalX));
+	// Texture coordinates for the vertex
+	device->VertexArrayAttribFormat(vao_, 2, 2, GL_FLOAT, false, offsetof(Vertex, s));
+	// Texture Atlas Index
+	device->VertexArrayAttribIFormat(vao_, 3, 1, GL_INT, offsetof(Vertex, textureAtlasZ));
+
+	for (int attribute = 0; attribute < 4; attribute++)
+	{
+		device->VertexArrayAttribBinding(vao_, attribute, 0);
+		device->EnableVertexArrayAttrib(vao_, attribute);
+	}
+
+	CreateBuffers();
+}
+
+MeshArena::~MeshArena()
+{
+	delete stagingBuffer_;
+
+	RenderDevice* device = RenderDevice::Get();
+	device->DeleteBuffer(vbo_);
+	device->DeleteBuffer(ebo_);
+	device->DeleteVertexArray(vao_);
+}
+
+void MeshArena::CreateBuffers()
+{
+	// Immutable storage, the size never changes so the driver doesn't have to be ready to reallocate it
+	RenderDevice* device = RenderDevice::Get();
+	vbo_ = device->CreateBuffer();
+	ebo_ = device->CreateBuffer();
+	device->BufferStorage(vbo_, static_cast<size_t>(vertexAllocator_.GetCapacity()) * sizeof(Vertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	device->BufferStorage(ebo_, static_cast<size_t>(indexAllocator_.GetCapacity()) * sizeof(unsigned int), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	device->VertexArrayVertexBuffer(vao_, 0, vbo_, 0, sizeof(Vertex));
+	device->VertexArrayElementBuffer(vao_, ebo_);
+}
+
+void MeshArena::Grow(uint32_t extraVertices, uint32_t extraIndices)
+{
+	uint32_t oldVertexCapacity = vertexAllocator_.GetCapacity();
+	uint32_t oldIndexCapacity = indexAllocator_.GetCapacity();
+
+	// The new space is at the end, so make sure that alone is big enough
+	uint32_t vertexCapacity = oldVertexCapacity;
+	while (vertexCapacity - oldVertexCapacity < extraVertices)
+	{
+		vertexCapacity *= 2;
+	}
+
+	uint32_t indexCapacity = oldIndexCapacity;
+	while (indexCapacity - oldIndexCapacity < extraIndices)
+	{
+		indexCapacity *= 2;
+	}
+
+	// Always grow both, one running out usually means the other is close
+	vertexCapacity = std::max(vertexCapacity, oldVertexCapacity * 2);
+	indexCapacity = std::max(indexCapacity, oldIndexCapacity * 2);
+
+	unsigned int oldVbo = vbo_;
+	unsigned int oldEbo = ebo_;
+	vertexAllocator_.Grow(vertexCapacity);
+	indexAllocator_.Grow(indexCapacity);
+	CreateBuffers();
+
+	// Every mesh keeps its offset, so the old buffers are copied across as they are
+	RenderDevice* device = RenderDevice::Get();
+	device->CopyBufferSubData(oldVbo, vbo_, 0, 0, static_cast<size_t>(oldVertexCapacity) * sizeof(Vertex));
+	device->CopyBufferSubData(oldEbo, ebo_, 0, 0, static_cast<size_t>(oldIndexCapacity) * sizeof(unsigned int));
+
+	device->DeleteBuffer(oldVbo);
+	device->DeleteBuffer(oldEbo);
+
+	numGrows_++;
+	LOG("Grew the mesh arena to %u vertices and %u indices\n", vertexCapacity, indexCapacity);
+}
+
+int MeshArena::Reserve(int handle, uint32_t numVertices, uint32_t numIndices)
+{
+	// Keep the range if the mesh still fits, unless it's shrunk so much most of the range would sit empty
+	bool fitsInPlace = handle >= 0 && allocations_[handle].isInUse &&
+		allocations_[handle].vertexCapacity >= numVertices && allocations_[handle].indexCapacity >= numIndices &&
+		numVertices * 2 >= allocations_[handle].vertexCapacity && numIndices * 2 >= allocations_[handle].indexCapacity;
+
+	if (!fitsInPlace)
+	{
+		Free(handle);
+
+		uint32_t firstVertex = vertexAllocator_.Allocate(numVertices);
+		uint32_t firstIndex = indexAllocator_.Allocate(numIndices);
+		if (firstVertex == RangeAllocator::kInvalidOffset || firstIndex == RangeAllocator::kInvalidOffset)
+		{
+			vertexAllocator_.Free(firstVertex, numVertices);
+			indexAllocator_.Free(firstIndex, numIndices);
+
+			Grow(numVertices, numIndices);
+			firstVertex = vertexAllocator_.Allocate(numVertices);
+			firstIndex = indexAllocator_.Allocate(numIndices);
+		}
+
+		if (freeHandles_.empty())
+		{
+			handle = allocations_.size();
+			allocations_.push_back({});
+		}
+		else
+		{
+			handle = freeHandles_.back();
+			freeHandles_.pop_back();
+		}
+
+		MeshArenaAllocation& allocation = allocations_[handle];
+		allocation.firstVertex = firstVertex;
+		allocation.vertexCapacity = numVertices;
+		allocation.firstIndex = firstIndex;
+		allocation.indexCapacity = numIndices;
+		allocation.isInUse = true;
+	}
+
+	MeshArenaAllocation& allocation = allocations_[handle];
+	allocation.numVertices = numVertices;
+	allocation.numIndices = numIndices;
+	return handle;
+}
+
+int MeshArena::Upload(int handle, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+	uint32_t numVertices = vertices.size();
+	uint32_t numIndices = indices.size();
+
+	handle = Reserve(handle, numVertices, numIndices);
+	const MeshArenaAllocation& allocation = allocations_[handle];
+
+	RenderDevice* device = RenderDevice::Get();
+	device->BufferSubData(vbo_, static_cast<size_t>(allocation.firstVertex) * sizeof(Vertex), numVertices * sizeof(Vertex), vertices.data());
+	device->BufferSubData(ebo_, static_cast<size_t>(allocation.firstIndex) * sizeof(unsigned int), numIndices * sizeof(unsigned int), indices.data());
+
+	return handle;
+}
+
+int MeshArena::UploadStaged(int handle, const StagedMesh& stagedMesh)
+{
+	handle = Reserve(handle, stagedMesh.numVertices, stagedMesh.numIndices);
+	const MeshArenaAllocation& allocation = allocations_[handle];
+
+	RenderDevice* device = RenderDevice::Get();
+	unsigned int stagingBuffer = stagingBuffer_->GetBuffer();
+	device->CopyBufferSubData(stagingBuffer, vbo_, stagedMesh.allocation.offset,
+		static_cast<size_t>(allocation.firstVertex) * sizeof(Vertex), static_cast<size_t>(stagedMesh.numVertices) * sizeof(Vertex));
+	device->CopyBufferSubData(stagingBuffer, ebo_, stagedMesh.indexOffset,
+		static_cast<size_t>(allocation.firstIndex) * sizeof(unsigned int), static_cast<size_t>(stagedMesh.numIndices) * sizeof(unsigned int));
+
+	// Reused once this frame's fence has signalled
+	stagingBuffer_->Release(stagedMesh);
+	return handle;
+}
+
+void MeshArena::Free(int handle)
+{
+	if (handle < 0 || !allocations_[handle].isInUse)
+	{
+		return;
+	}
+
+	MeshArenaAllocation& allocation = allocations_[handle];
+	vertexAllocator_.Free(allocation.firstVertex, allocation.vertexCapacity);
+	indexAllocator_.Free(allocation.firstIndex, allocation.indexCapacity);
+
+	allocation.isInUse = false;
+	freeHandles_.push_back(handle);
+}
+
+const MeshArenaAllocation& MeshArena::GetAllocation(int handle)
+{
+	return allocations_[handle];
+}
+
+unsigned int MeshArena::GetVertexArray()
+{
+	return vao_;
+}
+
+StagingBuffer* MeshArena::GetStagingBuffer()
+{
+	return stagingBuffer_;
+}
+
+MeshArenaStats MeshArena::GetStats()
+{
+	RangeAllocatorStats vertexStats = vertexAllocator_.GetStats();
+	RangeAllocatorStats indexStats = indexAllocator_.GetStats();
+
+	MeshArenaStats stats{};
+	stats.bytesUsed = static_cast<size_t>(vertexStats.used) * sizeof(Vertex) + static_cast<size_t>(indexStats.used) * sizeof(unsigned int);
+	stats.bytesFree = static_cast<size_t>(vertexStats.free) * sizeof(Vertex) + static_cast<size_t>(indexStats.free) * sizeof(unsigned int);
+	stats.bytesCapacity = stats.bytesUsed + stats.bytesFree;
+	stats.largestFreeBlock = static_cast<size_t>(vertexStats.largestFreeBlock) * sizeof(Vertex) + static_cast<size_t>(indexStats.largestFreeBlock) * sizeof(unsigned int);
+	stats.numAllocations = allocations_.size() - freeHandles_.size();
+	stats.numFreeBlocks = vertexStats.numFreeBlocks + indexStats.numFreeBlocks;
+	stats.fragmentation = vertexStats.fragmentation;
+	stats.numGrows = numGrows_;
+	return stats;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+#include "rangeAllocator.h"
+#include "stagingBuffer.h"
+
+struct MeshArenaStats
+{
+	size_t bytesUsed;
+	size_t bytesFree;
+	size_t bytesCapacity;
+	size_t largestFreeBlock; // bytes, of the vertex and index buffers added together
+	int numAllocations;
+	int numFreeBlocks;
+	float fragmentation; // of the vertex buffer, see RangeAllocatorStats
+	int numGrows;
+};
+
+// A mesh's range in the arena's buffers, in vertices and indices rather than bytes
+struct MeshArenaAllocation
+{
+	uint32_t firstVertex;
+	uint32_t numVertices;
+	uint32_t vertexCapacity;
+
+	uint32_t firstIndex;
+	uint32_t numIndices;
+	uint32_t indexCapacity;
+
+	bool isInUse;
+};
+
+/*
+ * One large vertex buffer and index buffer that many meshes are packed
+ * into, so they can all be drawn with a single VAO bound (see
+ * ChunkRenderer). The indices stay relative to the mesh's first vertex,
+ * the draw passes that as the base vertex.
+ *
+ * The buffers are immutable storage, the space in them is handed out by
+ * a RangeAllocator for each, so an unloaded mesh's range is reused by
+ * the next mesh that fits. A mesh that's uploaded again keeps its range
+ * if it still fits. When nothing fits the buffers are replaced with ones
+ * twice the size and the old contents are copied over on the GPU,
+ * meshes keep their offsets so nothing else has to change.
+ *
+ * Meshes that were written to the arena's StagingBuffer by a worker are
+ * copied in on the GPU instead of being sent from our memory.
+ */
+class MeshArena
+{
+	unsigned int vao_;
+	unsigned int vbo_;
+	unsigned int ebo_;
+
+	RangeAllocator vertexAllocator_;
+	RangeAllocator indexAllocator_;
+
+	std::vector<MeshArenaAllocation> allocations_;
+	std::vector<int> freeHandles_;
+	int numGrows_;
+
+	StagingBuffer* stagingBuffer_;
+
+	void CreateBuffers();
+
+	// Makes the buffers big enough that the extra vertices and indices can be allocated
+	void Grow(uint32_t extraVertices, uint32_t extraIndices);
+
+	// Finds room for the mesh, keeping its old range if it can, and returns its handle
+	int Reserve(int handle, uint32_t numVertices, uint32_t numIndices);
+public:
+	MeshArena(uint32_t vertexCapacity, uint32_t indexCapacity);
+	~MeshArena();
+
+	/*
+	 * Copies the vertices and indices into the arena and returns the
+	 * mesh's handle. Pass the handle from the last upload (or -1 for a
+	 * new mesh) so its range can be reused.
+	 */
+	int Upload(int handle, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+
+	// The same, but copies the mesh from the staging buffer and releases it
+	int UploadStaged(int handle, const StagedMesh& stagedMesh);
+
+	// Gives the mesh's range back to be reused
+	void Free(int handle);
+
+	const MeshArenaAllocation& GetAllocation(int handle);
+
+	// Has the vertex layout set up and the index buffer attached, vertex buffer binding 0 is the arena's
+	unsigned int GetVertexArray();
+
+	// Workers write finished meshes here, see StagingBuffer
+	StagingBuffer* GetStagingBuffer();
+
+	MeshArenaStats GetStats();
+};
@@ -13,6 +13,25 @@ enum class MeshType
 	Chunk
 };
 
+// The uniform buffer binding point FrameUniforms is bound to, see mesh.vert and mesh.frag
+const unsigned int FRAME_UNIFORMS_BINDING = 0;
+
+/*
+ * The camera and lighting for the frame, laid out as the std140
+ * FrameData uniform block. vec3s take up 16 bytes in std140, hence the
+ * vec4s, the w is unused.
+ */
+struct FrameUniforms
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 viewPos;
+	glm::vec4 lightDirection;
+	glm::vec4 lightAmbient;
+	glm::vec4 lightDiffuse;
+	glm::vec4 lightSpecular;
+};
+
 struct MeshTypeCommonData
 {
 	glm::vec3 viewPos;
@@ -20,4 +39,8 @@ struct MeshTypeCommonData
 	glm::mat4 projection;
 	DirectionalLight directionalLight;
 	shader shaderProgram;
+
+	// Set up by Mesh::CreateCommonData, leave these as they are
+	unsigned int frameUniformBuffer;
+	GLint modelLocation;
 };
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/*
+ * A bounded, lock-free queue that any number of threads can push to
+ * and one thread pops from.
+ *
+ * Each cell in the ring has a sequence number that says whose turn it
+ * is. A producer claims a cell by moving the enqueue position on with a
+ * compare-exchange, writes the item and then bumps the sequence to
+ * publish it, so the consumer never sees a half-written item. The
+ * consumer is the only thread that moves the dequeue position, so it
+ * doesn't need a compare-exchange.
+ *
+ * The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class MpscQueue
+{
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T item;
+	};
+
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_;
+
+	// On separate cache lines so the producers and consumer don't fight over them
+	alignas(64) std::atomic<size_t> enqueuePos_;
+	alignas(64) size_t dequeuePos_;
+public:
+	MpscQueue(size_t capacity)
+	{
+		size_t roundedCapacity = 2;
+		while (roundedCapacity < capacity)
+		{
+			roundedCapacity *= 2;
+		}
+
+		cells_ = std::make_unique<Cell[]>(roundedCapacity);
+		mask_ = roundedCapacity - 1;
+
+		for (size_t i = 0; i < roundedCapacity; i++)
+		{
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		enqueuePos_.store(0, std::memory_order_relaxed);
+		dequeuePos_ = 0;
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	// Returns false if the queue is full, item is left untouched
+	bool TryPush(T&& item)
+	{
+		size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			Cell& cell = cells_[pos & mask_];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+			if (difference == 0)
+			{
+				// The cell is free, try to claim it
+				if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.item = std::move(item);
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				// The consumer hasn't popped this cell from the last lap yet
+				return false;
+			}
+			else
+			{
+				// Another producer claimed the cell first
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Only call this from the consumer thread
+	bool TryPop(T& itemOut)
+	{
+		Cell& cell = cells_[dequeuePos_ & mask_];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+		if (sequence != dequeuePos_ + 1)
+		{
+			// Empty, or the producer that claimed the cell hasn't finished writing it
+			return false;
+		}
+
+		itemOut = std::move(cell.item);
+		cell.item = T();
+		cell.sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+		dequeuePos_++;
+		return true;
+	}
+
+	size_t GetCapacity()
+	{
+		return mask_ + 1;
+	}
+};
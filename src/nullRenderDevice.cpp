@@ -0,0 +1,269 @@
+#include "nullRenderDevice.h"
+
+NullRenderDevice::NullRenderDevice()
+	: RenderDevice()
+{
+	// 0 means none, like in OpenGL
+	nextName_ = 1;
+
+	bufferSizes_ = std::unordered_map<unsigned int, size_t>();
+	mappedBuffers_ = std::unordered_map<unsigned int, std::vector<uint8_t>>();
+	numVertexArrays_ = 0;
+	numTextures_ = 0;
+	numPrograms_ = 0;
+}
+
+NullRenderDeviceObjects NullRenderDevice::GetObjects()
+{
+	NullRenderDeviceObjects objects{};
+	objects.numBuffers = bufferSizes_.size();
+	objects.numVertexArrays = numVertexArrays_;
+	objects.numTextures = numTextures_;
+	objects.numPrograms = numPrograms_;
+	for (const auto& buffer : bufferSizes_)
+	{
+		objects.bufferBytes += buffer.second;
+	}
+	return objects;
+}
+
+unsigned int NullRenderDevice::CreateBuffer()
+{
+	bufferSizes_[nextName_] = 0;
+	return nextName_++;
+}
+
+void NullRenderDevice::DeleteBuffer(unsigned int buffer)
+{
+	bufferSizes_.erase(buffer);
+	mappedBuffers_.erase(buffer);
+}
+
+void NullRenderDevice::BufferStorage(unsigned int buffer, size_t size, const void* data, GLbitfield flags)
+{
+	stats_.numUploadBytes += data != nullptr ? size : 0;
+	bufferSizes_[buffer] = size;
+}
+
+void NullRenderDevice::BufferData(unsigned int buffer, size_t size, const void* data, GLenum usage)
+{
+	stats_.numUploadBytes += data != nullptr ? size : 0;
+	bufferSizes_[buffer] = size;
+}
+
+void NullRenderDevice::BufferSubData(unsigned int buffer, size_t offset, size_t size, const void* data)
+{
+	stats_.numUploadBytes += size;
+}
+
+void NullRenderDevice::CopyBufferSubData(unsigned int source, unsigned int destination, size_t sourceOffset, size_t destinationOffset, size_t size)
+{
+	stats_.numCopyBytes += size;
+}
+
+void* NullRenderDevice::MapBufferRange(unsigned int buffer, size_t offset, size_t size, GLbitfield access)
+{
+	std::vector<uint8_t>& data = mappedBuffers_[buffer];
+	data.resize(bufferSizes_[buffer]);
+	return data.data() + offset;
+}
+
+void NullRenderDevice::UnmapBuffer(unsigned int buffer)
+{
+	mappedBuffers_.erase(buffer);
+}
+
+void NullRenderDevice::BindBuffer(GLenum target, unsigned int buffer)
+{
+}
+
+void NullRenderDevice::BindBufferBase(GLenum target, unsigned int index, unsigned int buffer)
+{
+}
+
+unsigned int NullRenderDevice::CreateVertexArray()
+{
+	numVertexArrays_++;
+	return nextName_++;
+}
+
+void NullRenderDevice::DeleteVertexArray(unsigned int vertexArray)
+{
+	ForgetVertexArray(vertexArray);
+	numVertexArrays_--;
+}
+
+void NullRenderDevice::VertexArrayAttribFormat(unsigned int vertexArray, unsigned int attribute, int size, GLenum type, bool isNormalised, unsigned int offset)
+{
+}
+
+void NullRenderDevice::VertexArrayAttribIFormat(unsigned int vertexArray, unsigned int attribute, int size, GLenum type, unsigned int offset)
+{
+}
+
+void NullRenderDevice::VertexArrayAttribBinding(unsigned int vertexArray, unsigned int attribute, unsigned int binding)
+{
+}
+
+void NullRenderDevice::VertexArrayBindingDivisor(unsigned int vertexArray, unsigned int binding, unsigned int divisor)
+{
+}
+
+void NullRenderDevice::EnableVertexArrayAttrib(unsigned int vertexArray, unsigned int attribute)
+{
+}
+
+void NullRenderDevice::VertexArrayVertexBuffer(unsigned int vertexArray, unsigned int binding, unsigned int buffer, size_t offset, int stride)
+{
+}
+
+void NullRenderDevice::VertexArrayElementBuffer(unsigned int vertexArray, unsigned int buffer)
+{
+}
+
+void NullRenderDevice::BindVertexArray(unsigned int vertexArray)
+{
+	ChangeState(vertexArray_, vertexArray);
+}
+
+unsigned int NullRenderDevice::CreateTexture(GLenum target)
+{
+	numTextures_++;
+	return nextName_++;
+}
+
+void NullRenderDevice::DeleteTexture(unsigned int texture)
+{
+	ForgetTexture(texture);
+	numTextures_--;
+}
+
+void NullRenderDevice::TextureParameter(unsigned int texture, GLenum name, GLint value)
+{
+}
+
+void NullRenderDevice::TextureStorage2D(unsigned int texture, int levels, GLenum internalFormat, int width, int height)
+{
+}
+
+void NullRenderDevice::TextureStorage3D(unsigned int texture, int levels, GLenum internalFormat, int width, int height, int depth)
+{
+}
+
+void NullRenderDevice::TextureSubImage2D(unsigned int texture, int level, int width, int height, GLenum format, GLenum type, const void* data)
+{
+	stats_.numUploadBytes += GetImageSize(width, height, 1, format, type);
+}
+
+void NullRenderDevice::TextureSubImage3D(unsigned int texture, int level, int zOffset, int width, int height, int depth, GLenum format, GLenum type,
+	const void* data, int rowLength, int skipPixels, int skipRows)
+{
+	stats_.numUploadBytes += GetImageSize(width, height, depth, format, type);
+}
+
+void NullRenderDevice::GenerateTextureMipmap(unsigned int texture)
+{
+}
+
+void NullRenderDevice::BindTextureUnit(unsigned int unit, unsigned int texture)
+{
+	if (unit < MAX_TEXTURE_UNITS)
+	{
+		ChangeState(textures_[unit], texture);
+	}
+}
+
+shader NullRenderDevice::CreateProgram(const char* vertexSource, const char* fragmentSource)
+{
+	numPrograms_++;
+	return nextName_++;
+}
+
+void NullRenderDevice::DeleteProgram(shader program)
+{
+	ForgetProgram(program);
+	numPrograms_--;
+}
+
+std::vector<std::pair<std::string, GLint>> NullRenderDevice::GetActiveUniforms(shader program)
+{
+	// Nothing was compiled, so every location is -1 and setting them does nothing
+	return std::vector<std::pair<std::string, GLint>>();
+}
+
+void NullRenderDevice::UseProgram(shader program)
+{
+	ChangeState(program_, program);
+}
+
+void NullRenderDevice::Uniform1i(GLint location, int value)
+{
+}
+
+void NullRenderDevice::UniformMatrix4fv(GLint location, const float* value)
+{
+}
+
+GLsync NullRenderDevice::FenceSync()
+{
+	return nullptr;
+}
+
+bool NullRenderDevice::IsSyncSignalled(GLsync sync)
+{
+	// Nothing's ever waiting on the GPU
+	return true;
+}
+
+void NullRenderDevice::DeleteSync(GLsync sync)
+{
+}
+
+void NullRenderDevice::SetBlend(bool isEnabled)
+{
+	ChangeState(isBlendEnabled_, isEnabled);
+}
+
+void NullRenderDevice::SetBlendFunction(GLenum source, GLenum destination)
+{
+}
+
+void NullRenderDevice::SetDepthTest(bool isEnabled)
+{
+	ChangeState(isDepthTestEnabled_, isEnabled);
+}
+
+void NullRenderDevice::SetDepthMask(bool isEnabled)
+{
+	ChangeState(isDepthMaskEnabled_, isEnabled);
+}
+
+void NullRenderDevice::SetViewport(int x, int y, int width, int height)
+{
+}
+
+void NullRenderDevice::SetClearColour(float r, float g, float b, float a)
+{
+}
+
+void NullRenderDevice::Clear(GLbitfield mask)
+{
+}
+
+void NullRenderDevice::DrawArrays(GLenum mode, int first, int count)
+{
+	stats_.numDrawCalls++;
+	stats_.numDraws++;
+}
+
+void NullRenderDevice::DrawElements(GLenum mode, int count, GLenum type, size_t offset)
+{
+	stats_.numDrawCalls++;
+	stats_.numDraws++;
+}
+
+void NullRenderDevice::MultiDrawElementsIndirect(GLenum mode, GLenum type, size_t offset, int drawCount, int stride)
+{
+	stats_.numDrawCalls++;
+	stats_.numDraws += drawCount;
+}
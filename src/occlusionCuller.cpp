@@ -0,0 +1,641 @@
+#include "occlusionCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <xmmintrin.h>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include "chunkLayout.h"
+
+// The corners of each face going anticlockwise seen from outside the box, a corner's bits are its x, y and z being the max
+static const int kFaceCorners[6][4] = {
+	{ 0, 4, 6, 2 }, // -x
+	{ 1, 3, 7, 5 }, // +x
+	{ 0, 1, 5, 4 }, // -y
+	{ 2, 6, 7, 3 }, // +y
+	{ 0, 2, 3, 1 }, // -z
+	{ 4, 5, 7, 6 }  // +z
+};
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+{
+	width_ = (width + 3) / 4 * 4;
+	height_ = height;
+	viewProjection_ = glm::mat4(1.0f);
+	stats_ = {};
+
+	levels_ = std::vector<std::vector<float>>();
+	levelWidths_ = std::vector<int>();
+	levelHeights_ = std::vector<int>();
+
+	int levelWidth = width_;
+	int levelHeight = height_;
+	while (true)
+	{
+		levels_.push_back(std::vector<float>(levelWidth * levelHeight, 1.0f));
+		levelWidths_.push_back(levelWidth);
+		levelHeights_.push_back(levelHeight);
+
+		if (levelWidth == 1 && levelHeight == 1)
+		{
+			break;
+		}
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+}
+
+void OcclusionCuller::BeginFrame(const glm::mat4& viewProjection)
+{
+	viewProjection_ = viewProjection;
+	std::fill(levels_[0].begin(), levels_[0].end(), 1.0f);
+	stats_ = {};
+}
+
+void OcclusionCuller::AddOccluder(const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec4 corners[8];
+	int numOutside[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+		glm::vec4 clip = viewProjection_ * glm::vec4(corner, 1.0f);
+		corners[i] = clip;
+
+		numOutside[0] += clip.x < -clip.w;
+		numOutside[1] += clip.x > clip.w;
+		numOutside[2] += clip.y < -clip.w;
+		numOutside[3] += clip.y > clip.w;
+		numOutside[4] += clip.z < -clip.w;
+		numOutside[5] += clip.z > clip.w;
+	}
+
+	// Off the screen
+	for (int plane = 0; plane < 6; plane++)
+	{
+		if (numOutside[plane] == 8)
+		{
+			return;
+		}
+	}
+
+	stats_.numOccluders++;
+	for (int face = 0; face < 6; face++)
+	{
+		glm::vec4 faceCorners[4] = {
+			corners[kFaceCorners[face][0]],
+			corners[kFaceCorners[face][1]],
+			corners[kFaceCorners[face][2]],
+			corners[kFaceCorners[face][3]]
+		};
+		RasteriseQuad(faceCorners);
+	}
+}
+
+void OcclusionCuller::RasteriseQuad(const glm::vec4 corners[4])
+{
+	// Clip against the near plane (z >= -w), anything behind it would divide by a negative w
+	glm::vec4 clipped[5];
+	int numClipped = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		const glm::vec4& current = corners[i];
+		const glm::vec4& next = corners[(i + 1) % 4];
+		float currentDistance = current.z + current.w;
+		float nextDistance = next.z + next.w;
+
+		if (currentDistance >= 0.0f)
+		{
+			clipped[numClipped++] = current;
+		}
+		if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+		{
+			float t = currentDistance / (currentDistance - nextDistance);
+			clipped[numClipped++] = current + (next - current) * t;
+		}
+	}
+
+	if (numClipped < 3)
+	{
+		return;
+	}
+
+	glm::vec3 screen[5];
+	for (int i = 0; i < numClipped; i++)
+	{
+		float inverseW = 1.0f / clipped[i].w;
+		screen[i] = glm::vec3(
+			(clipped[i].x * inverseW * 0.5f + 0.5f) * width_,
+			(clipped[i].y * inverseW * 0.5f + 0.5f) * height_,
+			clipped[i].z * inverseW * 0.5f + 0.5f);
+	}
+
+	for (int i = 1; i + 1 < numClipped; i++)
+	{
+		RasteriseTriangle(screen[0], screen[i], screen[i + 1]);
+	}
+}
+
+void OcclusionCuller::RasteriseTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+	// Anticlockwise is front facing, the back faces are behind them anyway
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (area <= 0.0f)
+	{
+		return;
+	}
+
+	float minX = std::max(std::min({ a.x, b.x, c.x }), 0.0f);
+	float maxX = std::min(std::max({ a.x, b.x, c.x }), static_cast<float>(width_ - 1));
+	float minY = std::max(std::min({ a.y, b.y, c.y }), 0.0f);
+	float maxY = std::min(std::max({ a.y, b.y, c.y }), static_cast<float>(height_ - 1));
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	stats_.numTriangles++;
+
+	// Edge functions, each is the weight of the vertex opposite it scaled by the area
+	float edgeA[3] = { b.y - c.y, c.y - a.y, a.y - b.y };
+	float edgeB[3] = { c.x - b.x, a.x - c.x, b.x - a.x };
+	float edgeC[3] = {
+		-edgeA[0] * b.x - edgeB[0] * b.y,
+		-edgeA[1] * c.x - edgeB[1] * c.y,
+		-edgeA[2] * a.x - edgeB[2] * a.y
+	};
+
+	// The depth is linear in screen space, so it's a plane too
+	float inverseArea = 1.0f / area;
+	float depthA = (edgeA[0] * a.z + edgeA[1] * b.z + edgeA[2] * c.z) * inverseArea;
+	float depthB = (edgeB[0] * a.z + edgeB[1] * b.z + edgeB[2] * c.z) * inverseArea;
+	float depthC = (edgeC[0] * a.z + edgeC[1] * b.z + edgeC[2] * c.z) * inverseArea;
+
+	// Rows are a multiple of 4 wide, so starting on a multiple of 4 never runs off the end
+	int startX = static_cast<int>(minX) & ~3;
+	int endX = static_cast<int>(maxX);
+	int startY = static_cast<int>(minY);
+	int endY = static_cast<int>(maxY);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 edgeA0 = _mm_set1_ps(edgeA[0]);
+	const __m128 edgeA1 = _mm_set1_ps(edgeA[1]);
+	const __m128 edgeA2 = _mm_set1_ps(edgeA[2]);
+	const __m128 depthAs = _mm_set1_ps(depthA);
+
+	float* depth = levels_[0].data();
+	for (int y = startY; y <= endY; y++)
+	{
+		float pixelY = y + 0.5f;
+		__m128 rowEdge0 = _mm_set1_ps(edgeB[0] * pixelY + edgeC[0]);
+		__m128 rowEdge1 = _mm_set1_ps(edgeB[1] * pixelY + edgeC[1]);
+		__m128 rowEdge2 = _mm_set1_ps(edgeB[2] * pixelY + edgeC[2]);
+		__m128 rowDepth = _mm_set1_ps(depthB * pixelY + depthC);
+
+		float* row = depth + y * width_;
+		for (int x = startX; x <= endX; x += 4)
+		{
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelOffsets);
+
+			__m128 edge0 = _mm_add_ps(_mm_mul_ps(edgeA0, pixelX), rowEdge0);
+			__m128 edge1 = _mm_add_ps(_mm_mul_ps(edgeA1, pixelX), rowEdge1);
+			__m128 edge2 = _mm_add_ps(_mm_mul_ps(edgeA2, pixelX), rowEdge2);
+			__m128 isInside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+			if (_mm_movemask_ps(isInside) == 0)
+			{
+				continue;
+			}
+
+			__m128 pixelDepth = _mm_add_ps(_mm_mul_ps(depthAs, pixelX), rowDepth);
+			__m128 oldDepth = _mm_loadu_ps(row + x);
+			__m128 newDepth = _mm_min_ps(oldDepth, pixelDepth);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(isInside, newDepth), _mm_andnot_ps(isInside, oldDepth)));
+		}
+	}
+}
+
+void OcclusionCuller::BuildPyramid()
+{
+	for (size_t level = 1; level < levels_.size(); level++)
+	{
+		const std::vector<float>& below = levels_[level - 1];
+		int belowWidth = levelWidths_[level - 1];
+		int belowHeight = levelHeights_[level - 1];
+
+		std::vector<float>& current = levels_[level];
+		int width = levelWidths_[level];
+		int height = levelHeights_[level];
+
+		for (int y = 0; y < height; y++)
+		{
+			int y0 = y * 2;
+			int y1 = std::min(y0 + 1, belowHeight - 1);
+			for (int x = 0; x < width; x++)
+			{
+				int x0 = x * 2;
+				int x1 = std::min(x0 + 1, belowWidth - 1);
+
+				// The furthest, so anything behind it is behind all four
+				current[y * width + x] = std::max(
+					std::max(below[y0 * belowWidth + x0], below[y0 * belowWidth + x1]),
+					std::max(below[y1 * belowWidth + x0], below[y1 * belowWidth + x1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::IsVisible(const glm::vec3& min, const glm::vec3& max)
+{
+	float minX = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float minY = FLT_MAX;
+	float maxY = -FLT_MAX;
+	float minDepth = FLT_MAX;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+		glm::vec4 clip = viewProjection_ * glm::vec4(corner, 1.0f);
+
+		// Crosses the near plane, so it could cover the whole screen
+		if (clip.z < -clip.w)
+		{
+			return true;
+		}
+
+		float inverseW = 1.0f / clip.w;
+		float x = (clip.x * inverseW * 0.5f + 0.5f) * width_;
+		float y = (clip.y * inverseW * 0.5f + 0.5f) * height_;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		minDepth = std::min(minDepth, clip.z * inverseW * 0.5f + 0.5f);
+	}
+
+	// Off the screen, that's for the frustum culling to decide
+	if (maxX < 0.0f || maxY < 0.0f || minX >= width_ || minY >= height_)
+	{
+		return true;
+	}
+
+	stats_.numTested++;
+
+	int x0 = std::max(static_cast<int>(minX), 0);
+	int x1 = std::min(static_cast<int>(maxX), width_ - 1);
+	int y0 = std::max(static_cast<int>(minY), 0);
+	int y1 = std::min(static_cast<int>(maxY), height_ - 1);
+
+	// Go up the pyramid until the box is only a few pixels across
+	size_t level = 0;
+	while ((x1 - x0 >= 4 || y1 - y0 >= 4) && level + 1 < levels_.size())
+	{
+		x0 >>= 1;
+		x1 >>= 1;
+		y0 >>= 1;
+		y1 >>= 1;
+		level++;
+	}
+
+	const std::vector<float>& depth = levels_[level];
+	int width = levelWidths_[level];
+	for (int y = y0; y <= y1; y++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			if (minDepth <= depth[y * width + x])
+			{
+				return true;
+			}
+		}
+	}
+
+	stats_.numOccluded++;
+	return false;
+}
+
+int OcclusionCuller::GetWidth()
+{
+	return width_;
+}
+
+int OcclusionCuller::GetHeight()
+{
+	return height_;
+}
+
+const std::vector<float>& OcclusionCuller::GetDepth()
+{
+	return levels_[0];
+}
+
+OcclusionStats OcclusionCuller::GetStats()
+{
+	return stats_;
+}
+
+std::vector<OccluderBox> OcclusionCuller::BuildOccluders(const std::vector<uint8_t>& isSolid, int size, int cellSize)
+{
+	int numCells = size / cellSize;
+
+	auto isCellSolid = [&](int cellX, int cellY, int cellZ) {
+		for (int z = cellZ * cellSize; z < (cellZ + 1) * cellSize; z++)
+		{
+			for (int x = cellX * cellSize; x < (cellX + 1) * cellSize; x++)
+			{
+				for (int y = cellY * cellSize; y < (cellY + 1) * cellSize; y++)
+				{
+					if (!isSolid[(z * size + x) * size + y])
+					{
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	};
+
+	// Runs of solid cells going up each column, in cells for now
+	std::vector<OccluderBox> boxes = std::vector<OccluderBox>();
+	for (int z = 0; z < numCells; z++)
+	{
+		for (int x = 0; x < numCells; x++)
+		{
+			int runStart = -1;
+			for (int y = 0; y <= numCells; y++)
+			{
+				bool isCellInRun = y < numCells && isCellSolid(x, y, z);
+				if (isCellInRun && runStart == -1)
+				{
+					runStart = y;
+				}
+				else if (!isCellInRun && runStart != -1)
+				{
+					boxes.push_back({
+						static_cast<uint8_t>(x), static_cast<uint8_t>(runStart), static_cast<uint8_t>(z),
+						static_cast<uint8_t>(x + 1), static_cast<uint8_t>(y), static_cast<uint8_t>(z + 1)
+					});
+					runStart = -1;
+				}
+			}
+		}
+	}
+
+	// The boxes are in z then x order, so each one can only extend a box before it
+	auto mergeAlongX = [](const std::vector<OccluderBox>& in) {
+		std::vector<OccluderBox> out = std::vector<OccluderBox>();
+		for (const OccluderBox& box : in)
+		{
+			bool wasMerged = false;
+			for (OccluderBox& other : out)
+			{
+				if (other.maxX == box.minX && other.minY == box.minY && other.maxY == box.maxY && other.minZ == box.minZ && other.maxZ == box.maxZ)
+				{
+					other.maxX = box.maxX;
+					wasMerged = true;
+					break;
+				}
+			}
+			if (!wasMerged)
+			{
+				out.push_back(box);
+			}
+		}
+		return out;
+	};
+
+	auto mergeAlongZ = [](const std::vector<OccluderBox>& in) {
+		std::vector<OccluderBox> out = std::vector<OccluderBox>();
+		for (const OccluderBox& box : in)
+		{
+			bool wasMerged = false;
+			for (OccluderBox& other : out)
+			{
+				if (other.maxZ == box.minZ && other.minY == box.minY && other.maxY == box.maxY && other.minX == box.minX && other.maxX == box.maxX)
+				{
+					other.maxZ = box.maxZ;
+					wasMerged = true;
+					break;
+				}
+			}
+			if (!wasMerged)
+			{
+				out.push_back(box);
+			}
+		}
+		return out;
+	};
+
+	boxes = mergeAlongZ(mergeAlongX(boxes));
+
+	for (OccluderBox& box : boxes)
+	{
+		box.minX *= cellSize;
+		box.minY *= cellSize;
+		box.minZ *= cellSize;
+		box.maxX *= cellSize;
+		box.maxY *= cellSize;
+		box.maxZ *= cellSize;
+	}
+
+	return boxes;
+}
+
+bool OcclusionCuller::RunBenchmark(int renderDistance)
+{
+	const int numFrames = 200;
+	const int maxOccluderChunks = 128;
+
+	// Rolling hills with valleys deep enough to hide whole chunks
+	auto getHeight = [](int x, int z) {
+		return static_cast<int>(8.0f + 20.0f * sinf(x * 0.021f) * cosf(z * 0.017f) + 6.0f * sinf((x + z) * 0.05f));
+	};
+
+	struct BenchmarkChunk
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+		std::vector<OccluderBox> occluders;
+	};
+
+	std::vector<BenchmarkChunk> chunks = std::vector<BenchmarkChunk>();
+	std::vector<uint8_t> isSolid = std::vector<uint8_t>(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+	for (int chunkX = -renderDistance; chunkX <= renderDistance; chunkX++)
+	{
+		for (int chunkZ = -renderDistance; chunkZ <= renderDistance; chunkZ++)
+		{
+			for (int chunkY = MIN_CHUNK_Y; chunkY <= MAX_CHUNK_Y; chunkY++)
+			{
+				// Chunks are centred on their position, like the game's
+				glm::vec3 corner = glm::vec3(chunkX * CHUNK_SIZE - CHUNK_SIZE / 2, chunkY * CHUNK_SIZE - CHUNK_SIZE / 2, chunkZ * CHUNK_SIZE - CHUNK_SIZE / 2);
+				for (int z = 0; z < CHUNK_SIZE; z++)
+				{
+					for (int x = 0; x < CHUNK_SIZE; x++)
+					{
+						int height = getHeight(static_cast<int>(corner.x) + x, static_cast<int>(corner.z) + z);
+						for (int y = 0; y < CHUNK_SIZE; y++)
+						{
+							isSolid[(z * CHUNK_SIZE + x) * CHUNK_SIZE + y] = corner.y + y < height;
+						}
+					}
+				}
+
+				chunks.push_back({ corner, corner + glm::vec3(static_cast<float>(CHUNK_SIZE)), BuildOccluders(isSolid, CHUNK_SIZE, 4) });
+			}
+		}
+	}
+
+	// A ray hits the box if it gets inside it before reaching the end
+	auto doesRayHit = [](const glm::vec3& start, const glm::vec3& end, const glm::vec3& min, const glm::vec3& max) {
+		float tMin = 0.0f;
+		float tMax = 1.0f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float direction = end[axis] - start[axis];
+			if (fabsf(direction) < 1e-6f)
+			{
+				if (start[axis] < min[axis] || start[axis] > max[axis])
+				{
+					return false;
+				}
+				continue;
+			}
+			float t0 = (min[axis] - start[axis]) / direction;
+			float t1 = (max[axis] - start[axis]) / direction;
+			tMin = std::max(tMin, std::min(t0, t1));
+			tMax = std::min(tMax, std::max(t0, t1));
+		}
+		return tMin < tMax;
+	};
+
+	OcclusionCuller culler = OcclusionCuller(256, 128);
+	glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+
+	std::vector<std::pair<float, int>> byDistance = std::vector<std::pair<float, int>>();
+	std::vector<bool> isChunkVisible = std::vector<bool>(chunks.size());
+	int numTested = 0;
+	int numOccluded = 0;
+	int numWronglyCulled = 0;
+	double rasteriseSeconds = 0.0;
+	double testSeconds = 0.0;
+
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		// Walking along over the hills, turning as it goes
+		float cameraX = -renderDistance * CHUNK_SIZE * 0.5f + frame * (renderDistance * CHUNK_SIZE) / static_cast<float>(numFrames);
+		float cameraZ = 3.0f;
+		glm::vec3 camera = glm::vec3(cameraX, getHeight(static_cast<int>(cameraX), static_cast<int>(cameraZ)) + 1.7f, cameraZ);
+		float yaw = frame * 0.1f;
+		glm::vec3 forward = glm::vec3(cosf(yaw), -0.15f, sinf(yaw));
+		glm::mat4 view = glm::lookAt(camera, camera + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+
+		auto startTime = std::chrono::steady_clock::now();
+		culler.BeginFrame(projection * view);
+
+		byDistance.clear();
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			glm::vec3 offset = (chunks[i].min + chunks[i].max) * 0.5f - camera;
+			byDistance.push_back({ glm::dot(offset, offset), static_cast<int>(i) });
+		}
+		size_t numOccluderChunks = std::min(chunks.size(), static_cast<size_t>(maxOccluderChunks));
+		std::partial_sort(byDistance.begin(), byDistance.begin() + numOccluderChunks, byDistance.end());
+
+		for (size_t i = 0; i < numOccluderChunks; i++)
+		{
+			const BenchmarkChunk& chunk = chunks[byDistance[i].second];
+			for (const OccluderBox& box : chunk.occluders)
+			{
+				culler.AddOccluder(chunk.min + glm::vec3(box.minX, box.minY, box.minZ), chunk.min + glm::vec3(box.maxX, box.maxY, box.maxZ));
+			}
+		}
+		culler.BuildPyramid();
+		auto rasterisedTime = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			isChunkVisible[i] = culler.IsVisible(chunks[i].min, chunks[i].max);
+		}
+		auto endTime = std::chrono::steady_clock::now();
+
+		rasteriseSeconds += std::chrono::duration<double>(rasterisedTime - startTime).count();
+		testSeconds += std::chrono::duration<double>(endTime - rasterisedTime).count();
+		numTested += culler.GetStats().numTested;
+		numOccluded += culler.GetStats().numOccluded;
+
+		// Every few frames, check the culled chunks really are hidden by casting rays at points on them that are on the screen.
+		// The occluders are grown by a few pixels' worth so slivers at their edges don't count.
+		if (frame % 10 != 0)
+		{
+			continue;
+		}
+
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			if (isChunkVisible[i])
+			{
+				continue;
+			}
+
+			const BenchmarkChunk& chunk = chunks[i];
+			bool isSeen = false;
+			for (int point = 0; point < 27 && !isSeen; point++)
+			{
+				glm::vec3 t = glm::vec3(point % 3, (point / 3) % 3, point / 9) * 0.5f;
+				glm::vec3 target = chunk.min + (chunk.max - chunk.min) * t;
+
+				// Points off the screen can't be seen either
+				glm::vec4 clip = projection * view * glm::vec4(target, 1.0f);
+				if (clip.w <= 0.0f || fabsf(clip.x) > clip.w || fabsf(clip.y) > clip.w || fabsf(clip.z) > clip.w)
+				{
+					continue;
+				}
+
+				glm::vec3 offset = target - camera;
+				float slack = 0.5f + sqrtf(glm::dot(offset, offset)) * 0.02f;
+
+				bool isBlocked = false;
+				for (size_t j = 0; j < numOccluderChunks && !isBlocked; j++)
+				{
+					if (byDistance[j].second == static_cast<int>(i))
+					{
+						continue;
+					}
+
+					const BenchmarkChunk& occluderChunk = chunks[byDistance[j].second];
+					for (const OccluderBox& box : occluderChunk.occluders)
+					{
+						glm::vec3 boxMin = occluderChunk.min + glm::vec3(box.minX, box.minY, box.minZ) - glm::vec3(slack);
+						glm::vec3 boxMax = occluderChunk.min + glm::vec3(box.maxX, box.maxY, box.maxZ) + glm::vec3(slack);
+						if (doesRayHit(camera, target, boxMin, boxMax))
+						{
+							isBlocked = true;
+							break;
+						}
+					}
+				}
+				isSeen = !isBlocked;
+			}
+
+			if (isSeen)
+			{
+				numWronglyCulled++;
+			}
+		}
+	}
+
+	printf("%d chunks, %d frames: %.1f%% of the chunks on the screen were occluded\n",
+		static_cast<int>(chunks.size()), numFrames, numTested > 0 ? 100.0 * numOccluded / numTested : 0.0);
+	printf("Drawing occluders: %.3fms per frame, testing: %.3fms per frame (%.1fns per chunk)\n",
+		rasteriseSeconds * 1000.0 / numFrames, testSeconds * 1000.0 / numFrames, testSeconds * 1e9 / (static_cast<double>(chunks.size()) * numFrames));
+	if (numWronglyCulled > 0)
+	{
+		printf("%d chunks were culled that can be seen from the camera\n", numWronglyCulled);
+	}
+
+	return numWronglyCulled == 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// A box of solid blocks in a chunk, in blocks from the chunk's corner (the max is exclusive)
+struct OccluderBox
+{
+	uint8_t minX;
+	uint8_t minY;
+	uint8_t minZ;
+	uint8_t maxX;
+	uint8_t maxY;
+	uint8_t maxZ;
+};
+
+struct OcclusionStats
+{
+	// For the last frame
+	int numOccluders;
+	int numTriangles; // after clipping and back face culling
+	int numTested; // on the screen
+	int numOccluded;
+};
+
+/*
+ * Culls boxes that are hidden behind other boxes, using a small depth
+ * buffer that's drawn on the CPU. This is all CPU side, it doesn't touch
+ * OpenGL, so it can run without a GPU.
+ *
+ * Each frame the nearby chunks' occluders (boxes that are completely
+ * solid, see BuildOccluders) are drawn into the depth buffer four
+ * pixels at a time with SSE. The depth buffer is then reduced into a
+ * pyramid where each level keeps the furthest depth of the four pixels
+ * under it, so a box can be tested against a handful of pixels at the
+ * level where it's about 4x4 pixels big, rather than every pixel it
+ * covers.
+ *
+ * A box is only occluded if every pixel it could cover has something
+ * nearer than the box's nearest point. Occluders cover the pixels whose
+ * centres they're over, like the GPU does, so a box can peek out from
+ * behind an occluder's edge by up to half a pixel and still be culled.
+ */
+class OcclusionCuller
+{
+	int width_;
+	int height_;
+
+	glm::mat4 viewProjection_;
+
+	// Level 0 is the depth buffer itself, 0 is the near plane and 1 is the far plane
+	std::vector<std::vector<float>> levels_;
+	std::vector<int> levelWidths_;
+	std::vector<int> levelHeights_;
+
+	OcclusionStats stats_;
+
+	// The corners are in clip space, clipped against the near plane then drawn as a triangle fan
+	void RasteriseQuad(const glm::vec4 corners[4]);
+
+	// x and y are in pixels, z is the depth
+	void RasteriseTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c);
+public:
+	// The width is rounded up to a multiple of 4
+	OcclusionCuller(int width, int height);
+
+	// Clears the depth buffer, call before adding the frame's occluders
+	void BeginFrame(const glm::mat4& viewProjection);
+
+	// In world space
+	void AddOccluder(const glm::vec3& min, const glm::vec3& max);
+
+	// Call after the last occluder and before testing
+	void BuildPyramid();
+
+	// False if the box is definitely hidden, boxes that cross the near plane are always visible
+	bool IsVisible(const glm::vec3& min, const glm::vec3& max);
+
+	int GetWidth();
+	int GetHeight();
+
+	// The depth buffer, row by row from the bottom of the screen
+	const std::vector<float>& GetDepth();
+
+	OcclusionStats GetStats();
+
+	/*
+	 * Merges the solid cells of a chunk into a few boxes. The chunk is
+	 * split into cells of cellSize blocks a side, a cell is solid if all
+	 * of its blocks are, and runs of solid cells are merged upwards then
+	 * along x and z. isSolid is in chunk fill order (z, then x, then y).
+	 */
+	static std::vector<OccluderBox> BuildOccluders(const std::vector<uint8_t>& isSolid, int size, int cellSize);
+
+	/*
+	 * Culls a hilly heightmap world with the camera walking across it,
+	 * and prints how many chunks were culled and how long drawing the
+	 * occluders and testing took. Returns false if a chunk that can be
+	 * seen from the camera (checked by casting rays at it) was culled.
+	 */
+	static bool RunBenchmark(int renderDistance);
+};
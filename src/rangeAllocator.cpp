@@ -0,0 +1,252 @@
+#include "rangeAllocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+{
+	capacity_ = capacity;
+	used_ = 0;
+	numAllocations_ = 0;
+	freeByOffset_ = std::map<uint32_t, uint32_t>();
+	freeBySize_ = std::multimap<uint32_t, uint32_t>();
+
+	if (capacity_ > 0)
+	{
+		AddFreeRange(0, capacity_);
+	}
+}
+
+void RangeAllocator::AddFreeRange(uint32_t offset, uint32_t size)
+{
+	freeByOffset_.emplace(offset, size);
+	freeBySize_.emplace(size, offset);
+}
+
+void RangeAllocator::RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator offsetIt)
+{
+	// Several ranges can have the same size, find the one at this offset
+	auto sizeRange = freeBySize_.equal_range(offsetIt->second);
+	for (auto sizeIt = sizeRange.first; sizeIt != sizeRange.second; sizeIt++)
+	{
+		if (sizeIt->second == offsetIt->first)
+		{
+			freeBySize_.erase(sizeIt);
+			break;
+		}
+	}
+
+	freeByOffset_.erase(offsetIt);
+}
+
+uint32_t RangeAllocator::Allocate(uint32_t size)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	auto sizeIt = freeBySize_.lower_bound(size);
+	if (sizeIt == freeBySize_.end())
+	{
+		return kInvalidOffset;
+	}
+
+	uint32_t offset = sizeIt->second;
+	uint32_t freeSize = sizeIt->first;
+	RemoveFreeRange(freeByOffset_.find(offset));
+
+	// Whatever's left over stays free
+	if (freeSize > size)
+	{
+		AddFreeRange(offset + size, freeSize - size);
+	}
+
+	used_ += size;
+	numAllocations_++;
+	return offset;
+}
+
+void RangeAllocator::Free(uint32_t offset, uint32_t size)
+{
+	if (size == 0 || offset == kInvalidOffset)
+	{
+		return;
+	}
+
+	used_ -= size;
+	numAllocations_--;
+
+	// Merge with the free range after this one
+	auto nextIt = freeByOffset_.lower_bound(offset);
+	if (nextIt != freeByOffset_.end() && nextIt->first == offset + size)
+	{
+		size += nextIt->second;
+		RemoveFreeRange(nextIt);
+	}
+
+	// And the one before
+	auto afterIt = freeByOffset_.lower_bound(offset);
+	if (afterIt != freeByOffset_.begin())
+	{
+		auto previousIt = std::prev(afterIt);
+		if (previousIt->first + previousIt->second == offset)
+		{
+			offset = previousIt->first;
+			size += previousIt->second;
+			RemoveFreeRange(previousIt);
+		}
+	}
+
+	AddFreeRange(offset, size);
+}
+
+void RangeAllocator::Grow(uint32_t newCapacity)
+{
+	if (newCapacity <= capacity_)
+	{
+		return;
+	}
+
+	// The new space is a free range straight after the old end, merge them if the end was free
+	uint32_t addedSize = newCapacity - capacity_;
+	uint32_t oldCapacity = capacity_;
+	capacity_ = newCapacity;
+
+	used_ += addedSize;
+	numAllocations_++;
+	Free(oldCapacity, addedSize);
+}
+
+uint32_t RangeAllocator::GetCapacity()
+{
+	return capacity_;
+}
+
+RangeAllocatorStats RangeAllocator::GetStats()
+{
+	RangeAllocatorStats stats{};
+	stats.capacity = capacity_;
+	stats.used = used_;
+	stats.free = capacity_ - used_;
+	stats.largestFreeBlock = freeBySize_.empty() ? 0 : freeBySize_.rbegin()->first;
+	stats.numAllocations = numAllocations_;
+	stats.numFreeBlocks = freeByOffset_.size();
+	stats.fragmentation = stats.free == 0 ? 0.0f : 1.0f - static_cast<float>(stats.largestFreeBlock) / stats.free;
+	return stats;
+}
+
+bool RangeAllocator::RunBenchmark(int seed, int numOperations)
+{
+	struct Range
+	{
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	// About a render distance of 8's worth of chunk meshes, in vertices
+	const uint32_t capacity = 4 * 1024 * 1024;
+	const int targetNumRanges = 600;
+
+	// Runs the same churn twice, once timed and once checking for overlaps (which is much slower)
+	int numFailed = 0;
+	float worstFragmentation = 0.0f;
+	bool didOverlap = false;
+	bool didMerge = true;
+	double seconds = 0.0;
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		bool shouldCheck = pass == 1;
+
+		std::mt19937 random = std::mt19937(seed);
+		std::uniform_int_distribution<uint32_t> sizeDistribution = std::uniform_int_distribution<uint32_t>(0, 8192);
+
+		RangeAllocator allocator = RangeAllocator(capacity);
+		std::vector<Range> ranges = std::vector<Range>();
+		ranges.reserve(targetNumRanges * 2);
+
+		// Which units are in use
+		std::vector<bool> isInUse = std::vector<bool>(shouldCheck ? capacity : 0, false);
+		numFailed = 0;
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (int i = 0; i < numOperations; i++)
+		{
+			// Hover around the target, like chunks being unloaded behind the player and loaded ahead
+			bool shouldAllocate = ranges.empty() || random() % (targetNumRanges * 2) >= ranges.size();
+			if (shouldAllocate)
+			{
+				// Mostly small surface meshes with the odd big one
+				uint32_t size = sizeDistribution(random);
+				if (random() % 16 == 0)
+				{
+					size *= 4;
+				}
+
+				uint32_t offset = allocator.Allocate(size);
+				if (offset == kInvalidOffset)
+				{
+					numFailed++;
+					continue;
+				}
+
+				for (uint32_t unit = offset; shouldCheck && unit < offset + size; unit++)
+				{
+					didOverlap = didOverlap || isInUse[unit];
+					isInUse[unit] = true;
+				}
+				ranges.push_back({ offset, size });
+			}
+			else
+			{
+				int index = random() % ranges.size();
+				Range range = ranges[index];
+				ranges[index] = ranges.back();
+				ranges.pop_back();
+
+				for (uint32_t unit = range.offset; shouldCheck && unit < range.offset + range.size; unit++)
+				{
+					isInUse[unit] = false;
+				}
+				allocator.Free(range.offset, range.size);
+			}
+
+			if (shouldCheck && i % 1024 == 0)
+			{
+				worstFragmentation = std::max(worstFragmentation, allocator.GetStats().fragmentation);
+			}
+		}
+
+		if (!shouldCheck)
+		{
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			continue;
+		}
+
+		// Everything freed should merge back into one range
+		for (const Range& range : ranges)
+		{
+			allocator.Free(range.offset, range.size);
+		}
+		RangeAllocatorStats emptyStats = allocator.GetStats();
+		didMerge = emptyStats.used == 0 && emptyStats.numFreeBlocks == 1 && emptyStats.largestFreeBlock == capacity;
+
+		if (!didMerge)
+		{
+			printf("Freeing every range left %d free blocks\n", emptyStats.numFreeBlocks);
+		}
+	}
+
+	printf("%d operations in %.1fms, %.0f ns each, %d failed to fit\n", numOperations, seconds * 1000.0, seconds / numOperations * 1000000000.0, numFailed);
+	printf("Worst fragmentation: %.1f%%\n", worstFragmentation * 100.0f);
+	if (didOverlap)
+	{
+		printf("Two ranges in use at the same time overlapped\n");
+	}
+
+	return !didOverlap && didMerge;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <map>
+
+struct RangeAllocatorStats
+{
+	uint32_t capacity;
+	uint32_t used;
+	uint32_t free;
+	uint32_t largestFreeBlock;
+	int numAllocations;
+	int numFreeBlocks;
+
+	// 0 when all the free space is in one block, towards 1 as it's split into smaller ones
+	float fragmentation;
+};
+
+/*
+ * Hands out ranges of a fixed size space, i.e. a GPU buffer, without
+ * touching the space itself. It's pure CPU so the GPU side only has to
+ * copy data to the offsets it's given.
+ *
+ * The free ranges are kept in two maps, one by offset so a freed range
+ * can be merged with the free ranges either side of it, and one by size
+ * so an allocation takes the smallest free range it fits in (best fit).
+ * Both are O(log n) in the number of free ranges.
+ *
+ * Sizes and offsets are in whatever unit the caller likes, i.e. vertices.
+ */
+class RangeAllocator
+{
+	uint32_t capacity_;
+	uint32_t used_;
+	int numAllocations_;
+
+	std::map<uint32_t, uint32_t> freeByOffset_;
+	std::multimap<uint32_t, uint32_t> freeBySize_;
+
+	void AddFreeRange(uint32_t offset, uint32_t size);
+	void RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator offsetIt);
+public:
+	static const uint32_t kInvalidOffset = UINT32_MAX;
+
+	RangeAllocator(uint32_t capacity);
+
+	// Returns kInvalidOffset if there's no free range big enough, empty ranges always succeed
+	uint32_t Allocate(uint32_t size);
+
+	// The size has to be the size it was allocated with
+	void Free(uint32_t offset, uint32_t size);
+
+	// Adds the new space at the end as free, the existing ranges don't move
+	void Grow(uint32_t newCapacity);
+
+	uint32_t GetCapacity();
+	RangeAllocatorStats GetStats();
+
+	/*
+	 * Simulates chunks streaming in and out (allocating and freeing
+	 * mesh sized ranges at random) and prints the throughput and how
+	 * fragmented the space ends up. Returns false if two ranges that
+	 * were in use at the same time ever overlapped.
+	 */
+	static bool RunBenchmark(int seed, int numOperations);
+};
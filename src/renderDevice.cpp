@@ -0,0 +1,88 @@
+#include "renderDevice.h"
+
+RenderDevice* RenderDevice::device_ = nullptr;
+
+RenderDevice::RenderDevice()
+{
+	stats_ = {};
+	lastFrameStats_ = {};
+
+	// OpenGL's defaults
+	program_ = 0;
+	vertexArray_ = 0;
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		textures_[i] = 0;
+	}
+	isBlendEnabled_ = false;
+	isDepthTestEnabled_ = false;
+	isDepthMaskEnabled_ = true;
+}
+
+RenderDevice* RenderDevice::Get()
+{
+	return device_;
+}
+
+void RenderDevice::Set(RenderDevice* device)
+{
+	device_ = device;
+}
+
+void RenderDevice::ForgetProgram(unsigned int program)
+{
+	if (program_ == program)
+	{
+		program_ = 0;
+	}
+}
+
+void RenderDevice::ForgetVertexArray(unsigned int vertexArray)
+{
+	if (vertexArray_ == vertexArray)
+	{
+		vertexArray_ = 0;
+	}
+}
+
+void RenderDevice::ForgetTexture(unsigned int texture)
+{
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		if (textures_[i] == texture)
+		{
+			textures_[i] = 0;
+		}
+	}
+}
+
+size_t RenderDevice::GetImageSize(int width, int height, int depth, GLenum format, GLenum type)
+{
+	size_t numChannels = 4;
+	switch (format)
+	{
+	case GL_RED:
+		numChannels = 1;
+		break;
+	case GL_RG:
+		numChannels = 2;
+		break;
+	case GL_RGB:
+		numChannels = 3;
+		break;
+	}
+
+	size_t channelSize = type == GL_UNSIGNED_BYTE ? 1 : 4;
+	return static_cast<size_t>(width) * height * depth * numChannels * channelSize;
+}
+
+void RenderDevice::EndFrame()
+{
+	lastFrameStats_ = stats_;
+	stats_ = {};
+}
+
+RenderDeviceStats RenderDevice::GetStats()
+{
+	return lastFrameStats_;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glad/gl.h>
+
+#include "shader.h"
+
+struct RenderDeviceStats
+{
+	// For the last frame, see EndFrame
+	int numDrawCalls; // a multi draw is one call
+	int numDraws; // a multi draw counts each of its draws
+	int numStateChanges; // program, vertex array, texture, blend and depth changes, setting what's already set isn't one
+	size_t numUploadBytes; // buffer and texture data sent from our memory
+	size_t numCopyBytes; // buffer to buffer copies on the GPU
+};
+
+/*
+ * Everything the game asks of the GPU goes through here rather than
+ * calling OpenGL directly, so the same code can run with a
+ * GLRenderDevice in the game or a NullRenderDevice without a window or
+ * a GPU (i.e. for benchmarks on machines without one).
+ *
+ * The calls are OpenGL 4.5's direct state access calls, with the names
+ * and enums left as they are, so there's nothing to translate. Both
+ * devices count draws, state changes and upload bytes the same way, so
+ * the numbers from a headless run match the game's.
+ *
+ * Only call it from the thread that owns the GL context. Mapped
+ * buffers can be written from any thread.
+ */
+class RenderDevice
+{
+	static RenderDevice* device_;
+protected:
+	static const int MAX_TEXTURE_UNITS = 32;
+
+	RenderDeviceStats stats_;
+	RenderDeviceStats lastFrameStats_;
+
+	// What's set now, so changes can be counted and repeats skipped
+	unsigned int program_;
+	unsigned int vertexArray_;
+	unsigned int textures_[MAX_TEXTURE_UNITS];
+	bool isBlendEnabled_;
+	bool isDepthTestEnabled_;
+	bool isDepthMaskEnabled_;
+
+	// Returns true and counts a state change if the value is different
+	template<typename T>
+	bool ChangeState(T& state, T value)
+	{
+		if (state == value)
+		{
+			return false;
+		}
+
+		state = value;
+		stats_.numStateChanges++;
+		return true;
+	}
+
+	// Forgets deleted objects that are still set, GL reuses their names
+	void ForgetProgram(unsigned int program);
+	void ForgetVertexArray(unsigned int vertexArray);
+	void ForgetTexture(unsigned int texture);
+
+	// For a whole image in the format and type passed to glTextureSubImage*
+	static size_t GetImageSize(int width, int height, int depth, GLenum format, GLenum type);
+public:
+	RenderDevice();
+	virtual ~RenderDevice() = default;
+
+	// The device everything uses, whoever sets it owns it
+	static RenderDevice* Get();
+	static void Set(RenderDevice* device);
+
+	// Buffers
+	virtual unsigned int CreateBuffer() = 0;
+	virtual void DeleteBuffer(unsigned int buffer) = 0;
+	virtual void BufferStorage(unsigned int buffer, size_t size, const void* data, GLbitfield flags) = 0;
+	virtual void BufferData(unsigned int buffer, size_t size, const void* data, GLenum usage) = 0;
+	virtual void BufferSubData(unsigned int buffer, size_t offset, size_t size, const void* data) = 0;
+	virtual void CopyBufferSubData(unsigned int source, unsigned int destination, size_t sourceOffset, size_t destinationOffset, size_t size) = 0;
+	virtual void* MapBufferRange(unsigned int buffer, size_t offset, size_t size, GLbitfield access) = 0;
+	virtual void UnmapBuffer(unsigned int buffer) = 0;
+	virtual void BindBuffer(GLenum target, unsigned int buffer) = 0;
+	virtual void BindBufferBase(GLenum target, unsigned int index, unsigned int buffer) = 0;
+
+	// Vertex arrays
+	virtual unsigned int CreateVertexArray() = 0;
+	virtual void DeleteVertexArray(unsigned int vertexArray) = 0;
+	virtual void VertexArrayAttribFormat(unsigned int vertexArray, unsigned int attribute, int size, GLenum type, bool isNormalised, unsigned int offset) = 0;
+	virtual void VertexArrayAttribIFormat(unsigned int vertexArray, unsigned int attribute, int size, GLenum type, unsigned int offset) = 0;
+	virtual void VertexArrayAttribBinding(unsigned int vertexArray, unsigned int attribute, unsigned int binding) = 0;
+	virtual void VertexArrayBindingDivisor(unsigned int vertexArray, unsigned int binding, unsigned int divisor) = 0;
+	virtual void EnableVertexArrayAttrib(unsigned int vertexArray, unsigned int attribute) = 0;
+	virtual void VertexArrayVertexBuffer(unsigned int vertexArray, unsigned int binding, unsigned int buffer, size_t offset, int stride) = 0;
+	virtual void VertexArrayElementBuffer(unsigned int vertexArray, unsigned int buffer) = 0;
+	virtual void BindVertexArray(unsigned int vertexArray) = 0;
+
+	// Textures, 0 if the texture couldn't be created
+	virtual unsigned int CreateTexture(GLenum target) = 0;
+	virtual void DeleteTexture(unsigned int texture) = 0;
+	virtual void TextureParameter(unsigned int texture, GLenum name, GLint value) = 0;
+	virtual void TextureStorage2D(unsigned int texture, int levels, GLenum internalFormat, int width, int height) = 0;
+	virtual void TextureStorage3D(unsigned int texture, int levels, GLenum internalFormat, int width, int height, int depth) = 0;
+
+	// rowLength is the width of the whole image in data, the region starts skipPixels and skipRows into it
+	virtual void TextureSubImage2D(unsigned int texture, int level, int width, int height, GLenum format, GLenum type, const void* data) = 0;
+	virtual void TextureSubImage3D(unsigned int texture, int level, int zOffset, int width, int height, int depth, GLenum format, GLenum type,
+		const void* data, int rowLength, int skipPixels, int skipRows) = 0;
+
+	virtual void GenerateTextureMipmap(unsigned int texture) = 0;
+	virtual void BindTextureUnit(unsigned int unit, unsigned int texture) = 0;
+
+	// Shaders, SHADER_ERROR if the program couldn't be built
+	virtual shader CreateProgram(const char* vertexSource, const char* fragmentSource) = 0;
+	virtual void DeleteProgram(shader program) = 0;
+	virtual std::vector<std::pair<std::string, GLint>> GetActiveUniforms(shader program) = 0; // names and locations
+	virtual void UseProgram(shader program) = 0;
+	virtual void Uniform1i(GLint location, int value) = 0;
+	virtual void UniformMatrix4fv(GLint location, const float* value) = 0;
+
+	// Fences, a null device's are always signalled
+	virtual GLsync FenceSync() = 0;
+	virtual bool IsSyncSignalled(GLsync sync) = 0;
+	virtual void DeleteSync(GLsync sync) = 0;
+
+	// State
+	virtual void SetBlend(bool isEnabled) = 0;
+	virtual void SetBlendFunction(GLenum source, GLenum destination) = 0;
+	virtual void SetDepthTest(bool isEnabled) = 0;
+	virtual void SetDepthMask(bool isEnabled) = 0;
+	virtual void SetViewport(int x, int y, int width, int height) = 0;
+	virtual void SetClearColour(float r, float g, float b, float a) = 0;
+	virtual void Clear(GLbitfield mask) = 0;
+
+	// Drawing, offsets are into the bound element and indirect buffers
+	virtual void DrawArrays(GLenum mode, int first, int count) = 0;
+	virtual void DrawElements(GLenum mode, int count, GLenum type, size_t offset) = 0;
+	virtual void MultiDrawElementsIndirect(GLenum mode, GLenum type, size_t offset, int drawCount, int stride) = 0;
+
+	// Call once the frame has been drawn, GetStats then returns what it did
+	void EndFrame();
+	RenderDeviceStats GetStats();
+};
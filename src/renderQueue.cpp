@@ -0,0 +1,231 @@
+#include "renderQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "chunkLayout.h"
+
+RenderQueue::RenderQueue()
+{
+	items_ = std::vector<RenderItem>();
+	for (int i = 0; i < NUM_RENDER_PASSES; i++)
+	{
+		passRanges_[i] = { 0, 0 };
+	}
+	stats_ = {};
+}
+
+void RenderQueue::Clear()
+{
+	items_.clear();
+}
+
+void RenderQueue::Add(RenderPass pass, uint16_t material, float depth, uint32_t drawIndex)
+{
+	items_.push_back({ MakeSortKey(pass, material, depth), drawIndex });
+}
+
+void RenderQueue::Sort()
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	auto countStateChanges = [this]() {
+		int numStateChanges = 0;
+		for (size_t i = 1; i < items_.size(); i++)
+		{
+			uint64_t a = items_[i - 1].sortKey;
+			uint64_t b = items_[i].sortKey;
+			numStateChanges += GetPass(a) != GetPass(b) || GetMaterial(a) != GetMaterial(b);
+		}
+		return numStateChanges;
+	};
+
+	stats_.numUnsortedStateChanges = countStateChanges();
+
+	std::sort(items_.begin(), items_.end(), [](const RenderItem& a, const RenderItem& b) {
+		return a.sortKey < b.sortKey;
+	});
+
+	// Passes are in the top bits, so each one is a single run
+	int first = 0;
+	for (int pass = 0; pass < NUM_RENDER_PASSES; pass++)
+	{
+		int count = 0;
+		while (first + count < static_cast<int>(items_.size()) && GetPass(items_[first + count].sortKey) == static_cast<RenderPass>(pass))
+		{
+			count++;
+		}
+
+		passRanges_[pass] = { first, count };
+		stats_.numItems[pass] = count;
+		first += count;
+	}
+
+	stats_.numStateChanges = countStateChanges();
+	stats_.sortTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+const std::vector<RenderItem>& RenderQueue::GetItems()
+{
+	return items_;
+}
+
+RenderQueueRange RenderQueue::GetPassRange(RenderPass pass)
+{
+	return passRanges_[static_cast<int>(pass)];
+}
+
+RenderQueueStats RenderQueue::GetStats()
+{
+	return stats_;
+}
+
+uint64_t RenderQueue::MakeSortKey(RenderPass pass, uint16_t material, float depth)
+{
+	// Non-negative floats sort the same as their bits do
+	depth = std::max(depth, 0.0f);
+	uint32_t depthBits = 0;
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	// Pass in bits 62-63, then material in 48-61 and depth in 16-47, or
+	// for translucent items the flipped depth in 30-61 and material in 16-29
+	uint64_t key = static_cast<uint64_t>(pass) << 62;
+	if (pass == RenderPass::Translucent)
+	{
+		key |= static_cast<uint64_t>(~depthBits) << 30;
+		key |= static_cast<uint64_t>(material & 0x3FFF) << 16;
+	}
+	else
+	{
+		key |= static_cast<uint64_t>(material & 0x3FFF) << 48;
+		key |= static_cast<uint64_t>(depthBits) << 16;
+	}
+	return key;
+}
+
+RenderPass RenderQueue::GetPass(uint64_t sortKey)
+{
+	return static_cast<RenderPass>(sortKey >> 62);
+}
+
+uint16_t RenderQueue::GetMaterial(uint64_t sortKey)
+{
+	if (GetPass(sortKey) == RenderPass::Translucent)
+	{
+		return (sortKey >> 16) & 0x3FFF;
+	}
+	return (sortKey >> 48) & 0x3FFF;
+}
+
+bool RenderQueue::RunBenchmark(int renderDistance)
+{
+	const int numFrames = 200;
+	const int numOpaqueMaterials = 4;
+
+	struct BenchmarkDraw
+	{
+		float x;
+		float y;
+		float z;
+		RenderPass pass;
+		uint16_t material;
+	};
+
+	// Every chunk has opaque blocks, some have leaves and the ones at sea level have water
+	std::vector<BenchmarkDraw> draws = std::vector<BenchmarkDraw>();
+	for (int x = -renderDistance; x <= renderDistance; x++)
+	{
+		for (int z = -renderDistance; z <= renderDistance; z++)
+		{
+			for (int y = MIN_CHUNK_Y; y <= MAX_CHUNK_Y; y++)
+			{
+				float chunkX = static_cast<float>(x * CHUNK_SIZE);
+				float chunkY = static_cast<float>(y * CHUNK_SIZE);
+				float chunkZ = static_cast<float>(z * CHUNK_SIZE);
+				draws.push_back({ chunkX, chunkY, chunkZ, RenderPass::Opaque, static_cast<uint16_t>(((x ^ z) & 0xFF) % numOpaqueMaterials) });
+				if (((x * 7 + z * 13) & 3) == 0)
+				{
+					draws.push_back({ chunkX, chunkY, chunkZ, RenderPass::Cutout, numOpaqueMaterials });
+				}
+				if (y == 0)
+				{
+					draws.push_back({ chunkX, chunkY, chunkZ, RenderPass::Translucent, numOpaqueMaterials + 1 });
+				}
+			}
+		}
+	}
+
+	RenderQueue queue = RenderQueue();
+	bool isCorrect = true;
+	double sortSeconds = 0.0;
+	long long numStateChanges = 0;
+	long long numUnsortedStateChanges = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		// Walking across the world
+		float cameraX = (frame - numFrames / 2) * 2.0f;
+		float cameraY = 40.0f;
+		float cameraZ = frame * 0.5f;
+
+		queue.Clear();
+		for (size_t i = 0; i < draws.size(); i++)
+		{
+			const BenchmarkDraw& draw = draws[i];
+			float depth = sqrtf((draw.x - cameraX) * (draw.x - cameraX) + (draw.y - cameraY) * (draw.y - cameraY) + (draw.z - cameraZ) * (draw.z - cameraZ));
+			queue.Add(draw.pass, draw.material, depth, i);
+		}
+		queue.Sort();
+
+		RenderQueueStats stats = queue.GetStats();
+		sortSeconds += stats.sortTime;
+		numStateChanges += stats.numStateChanges;
+		numUnsortedStateChanges += stats.numUnsortedStateChanges;
+
+		// Passes in order, then opaque and cutout by material and front to back, translucent back to front
+		const std::vector<RenderItem>& items = queue.GetItems();
+		int numPassItems = 0;
+		for (int pass = 0; pass < NUM_RENDER_PASSES; pass++)
+		{
+			numPassItems += stats.numItems[pass];
+		}
+		if (numPassItems != static_cast<int>(draws.size()))
+		{
+			isCorrect = false;
+		}
+
+		float lastDepth = 0.0f;
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			const BenchmarkDraw& draw = draws[items[i].drawIndex];
+			float depth = sqrtf((draw.x - cameraX) * (draw.x - cameraX) + (draw.y - cameraY) * (draw.y - cameraY) + (draw.z - cameraZ) * (draw.z - cameraZ));
+			if (i > 0)
+			{
+				const BenchmarkDraw& last = draws[items[i - 1].drawIndex];
+				bool isSameGroup = last.pass == draw.pass && (draw.pass == RenderPass::Translucent || last.material == draw.material);
+				bool isInOrder = last.pass < draw.pass || (last.pass == draw.pass &&
+					(draw.pass == RenderPass::Translucent ? lastDepth >= depth : (last.material < draw.material || (isSameGroup && lastDepth <= depth))));
+				if (!isInOrder)
+				{
+					isCorrect = false;
+				}
+			}
+			lastDepth = depth;
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	if (!isCorrect)
+	{
+		printf("The render queue came out of order\n");
+	}
+
+	printf("%zu draws: %.3fms to sort and %.3fms to queue and check per frame, %lld state changes per frame rather than %lld\n",
+		draws.size(), sortSeconds * 1000.0 / numFrames, (seconds - sortSeconds) * 1000.0 / numFrames,
+		numStateChanges / numFrames, numUnsortedStateChanges / numFrames);
+
+	return isCorrect;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Drawn in this order
+enum class RenderPass
+{
+	Opaque,
+	Cutout, // opaque apart from holes, like leaves
+	Translucent
+};
+
+const int NUM_RENDER_PASSES = 3;
+
+struct RenderItem
+{
+	uint64_t sortKey;
+	uint32_t drawIndex; // whatever the caller needs to find the draw again
+};
+
+// Items first to first + count - 1
+struct RenderQueueRange
+{
+	int first;
+	int count;
+};
+
+struct RenderQueueStats
+{
+	// For the last sort
+	int numItems[NUM_RENDER_PASSES];
+	int numStateChanges; // pass or material changes between neighbouring items
+	int numUnsortedStateChanges; // what it would have been in the order they were added
+	double sortTime; // seconds
+};
+
+/*
+ * Collects a frame's draws and sorts them so each pass's draws are
+ * together, with as few material changes as possible, and in the order
+ * the depth test works best with. This is only the CPU side, it doesn't
+ * touch OpenGL, so it can run without a GPU.
+ *
+ * The sort key packs the pass into the top bits, so passes never mix.
+ * Opaque and cutout items are then sorted by material and front to back
+ * within a material, so the depth test can throw away hidden fragments
+ * before they're shaded. Translucent items are sorted back to front
+ * before material, as blending is only right in that order.
+ */
+class RenderQueue
+{
+	std::vector<RenderItem> items_;
+	RenderQueueRange passRanges_[NUM_RENDER_PASSES];
+	RenderQueueStats stats_;
+public:
+	RenderQueue();
+
+	// Call at the start of each frame, keeps the memory from the last one
+	void Clear();
+
+	// Depth is the distance from the camera, materials only use their low 14 bits
+	void Add(RenderPass pass, uint16_t material, float depth, uint32_t drawIndex);
+
+	// Call after the last Add, before reading the items
+	void Sort();
+
+	const std::vector<RenderItem>& GetItems();
+	RenderQueueRange GetPassRange(RenderPass pass);
+	RenderQueueStats GetStats();
+
+	static uint64_t MakeSortKey(RenderPass pass, uint16_t material, float depth);
+	static RenderPass GetPass(uint64_t sortKey);
+	static uint16_t GetMaterial(uint64_t sortKey);
+
+	/*
+	 * Queues every chunk in the render distance with a handful of
+	 * materials and passes from a moving camera, and prints how long
+	 * sorting took and how many state changes it saved. Returns false if
+	 * any pass came out of order.
+	 */
+	static bool RunBenchmark(int renderDistance);
+};
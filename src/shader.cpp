@@ -1,93 +1,109 @@
 #include "shader.h"
 
-#include <fstream>
-#include <sstream>
+#include <vector>
 
+#include "assetPack.h"
 #include "logging.h"
+#include "renderDevice.h"
 
-shader CreateShader(const char* vertexFile, const char* fragmentFile)
+namespace
 {
-	shader newShader = glCreateProgram();
+	// #version has to come first, so the defines go on the line after it
+	void InsertDefines(std::string& source, const char* defines)
+	{
+		if (defines[0] == '\0')
+		{
+			return;
+		}
+
+		size_t versionEnd = 0;
+		if (source.compare(0, 8, "#version") == 0)
+		{
+			versionEnd = source.find('\n');
+			versionEnd = versionEnd == std::string::npos ? source.size() : versionEnd + 1;
+		}
+		source.insert(versionEnd, defines);
+	}
+}
 
+shader CreateShader(const char* vertexFile, const char* fragmentFile, const char* defines)
+{
 	// Load Vertex Shader
-	std::ifstream vertexFileStream;
-	vertexFileStream.open(vertexFile, std::ifstream::in);
-
-	if (!vertexFileStream.is_open())
+	std::vector<uint8_t> vertexStorage = std::vector<uint8_t>();
+	AssetView vertexSource{};
+	if (!AssetPack::ReadAsset(vertexFile, vertexSource, vertexStorage))
 	{
 		LOG("Couldn't open vertex file.\n");
 		return SHADER_ERROR;
 	}
 
-	std::stringstream vertexData;
-	vertexData << vertexFileStream.rdbuf();
-
-	std::string vertexDataStdStr = vertexData.str();
-	const char* vertexDataStr = vertexDataStdStr.c_str();
-
-	unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexDataStr, NULL);
-	glCompileShader(vertexShader);
-
-	// Check for Errors
-	int wasSuccessful;
-	char infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &wasSuccessful);
-	if (!wasSuccessful)
+	// Load Fragment Shader
+	std::vector<uint8_t> fragmentStorage = std::vector<uint8_t>();
+	AssetView fragmentSource{};
+	if (!AssetPack::ReadAsset(fragmentFile, fragmentSource, fragmentStorage))
 	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		LOG("Vertex Shader Error: %s\n", infoLog);
+		LOG("Couldn't open fragment file.\n");
 		return SHADER_ERROR;
 	}
 
-	// Load Fragment Shader
-	std::ifstream fragmentFileStream;
-	fragmentFileStream.open(fragmentFile, std::ifstream::in);
-
-	if (!fragmentFileStream.is_open())
+	// Compiled and linked by the device, assets end in a 0 so
+	// without defines the sources can be passed as they are
+	RenderDevice* device = RenderDevice::Get();
+	if (defines[0] == '\0')
 	{
-		LOG("Couldn't open fragment file.\n");
-		return SHADER_ERROR;
+		return device->CreateProgram(reinterpret_cast<const char*>(vertexSource.data), reinterpret_cast<const char*>(fragmentSource.data));
 	}
 
-	std::stringstream fragmentData;
-	fragmentData << fragmentFileStream.rdbuf();
+	std::string vertexDataStdStr = std::string(reinterpret_cast<const char*>(vertexSource.data), vertexSource.size);
+	InsertDefines(vertexDataStdStr, defines);
 
-	std::string fragmentDataStdStr = fragmentData.str();
-	const char* fragmentDataStr = fragmentDataStdStr.c_str();
+	std::string fragmentDataStdStr = std::string(reinterpret_cast<const char*>(fragmentSource.data), fragmentSource.size);
+	InsertDefines(fragmentDataStdStr, defines);
 
-	unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentDataStr, NULL);
-	glCompileShader(fragmentShader);
+	return device->CreateProgram(vertexDataStdStr.c_str(), fragmentDataStdStr.c_str());
+}
 
-	// Check for Errors
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &wasSuccessful);
-	if (!wasSuccessful)
+ShaderReflection::ShaderReflection(shader program)
+{
+	uniformLocations_ = std::unordered_map<std::string, GLint>();
+	if (program == static_cast<shader>(SHADER_ERROR))
 	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		LOG("Vertex Shader Error: %s", infoLog);
-		return SHADER_ERROR;
+		return;
 	}
 
-	// Attach Shaders to Shader Program
-	glAttachShader(newShader, vertexShader);
-	glAttachShader(newShader, fragmentShader);
-
-	// Link Program and Check for Program Errors
-	glLinkProgram(newShader);
+	for (const auto& uniform : RenderDevice::Get()->GetActiveUniforms(program))
+	{
+		const std::string& name = uniform.first;
+		GLint location = uniform.second;
+		if (location == -1)
+		{
+			// In a uniform block
+			continue;
+		}
+
+		uniformLocations_[name] = location;
+
+		// Arrays are listed as "name[0]", so they can be found by their plain name too
+		size_t arrayStart = name.find('[');
+		if (arrayStart != std::string::npos)
+		{
+			uniformLocations_[name.substr(0, arrayStart)] = location;
+		}
+	}
+}
 
-	glGetProgramiv(newShader, GL_LINK_STATUS, &wasSuccessful);
-	if (!wasSuccessful)
+GLint ShaderReflection::GetUniformLocation(const std::string& name) const
+{
+	auto it = uniformLocations_.find(name);
+	if (it == uniformLocations_.end())
 	{
-		glGetProgramInfoLog(newShader, 512, NULL, infoLog);
-		LOG("Shader Linking Error: %s", infoLog);
-		return SHADER_ERROR;
+		return -1;
 	}
 
-	// Delete Vertex and Fragment Shaders
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-	
-	// Return created shader
-	return newShader;
+	return it->second;
+}
+
+int ShaderReflection::GetNumUniforms() const
+{
+	return uniformLocations_.size();
 }
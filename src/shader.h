@@ -1,7 +1,35 @@
 #pragma once
+#include <string>
+#include <unordered_map>
 #include <glad/gl.h>
 
 typedef unsigned int shader;
 const int SHADER_ERROR = -1;
 
-shader CreateShader(const char* vertexFile, const char* fragmentFile);
\ No newline at end of file
+/*
+ * Compiles and links the two files. The defines are put straight after
+ * each file's #version line, so one pair of files can be built into
+ * different variants, e.g. "#define ALPHA_TEST\n".
+ */
+shader CreateShader(const char* vertexFile, const char* fragmentFile, const char* defines = "");
+
+/*
+ * The locations of a program's active uniforms, looked up from the
+ * driver once after linking. Keep the locations you need from this
+ * rather than calling glGetUniformLocation while drawing, that hashes
+ * the name in the driver every call.
+ *
+ * Uniforms in a uniform block don't have a location, so they aren't in
+ * here, the block is bound to its binding point instead.
+ */
+class ShaderReflection
+{
+	std::unordered_map<std::string, GLint> uniformLocations_;
+public:
+	ShaderReflection(shader program);
+
+	// -1 if the program doesn't have the uniform (or it was optimised out), glUniform* ignores that
+	GLint GetUniformLocation(const std::string& name) const;
+
+	int GetNumUniforms() const;
+};
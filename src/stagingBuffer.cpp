@@ -0,0 +1,91 @@
+#include "stagingBuffer.h"
+
+#include <cstring>
+
+#include "renderDevice.h"
+
+StagingBuffer::StagingBuffer(uint32_t capacity)
+	: ring_(capacity)
+{
+	frame_ = 0;
+	fences_ = std::deque<FrameFence>();
+
+	// Coherent, so what the workers write is visible to copies issued after it without flushing
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	RenderDevice* device = RenderDevice::Get();
+	buffer_ = device->CreateBuffer();
+	device->BufferStorage(buffer_, capacity, nullptr, flags);
+	mappedData_ = static_cast<uint8_t*>(device->MapBufferRange(buffer_, 0, capacity, flags));
+}
+
+StagingBuffer::~StagingBuffer()
+{
+	RenderDevice* device = RenderDevice::Get();
+	for (FrameFence& frameFence : fences_)
+	{
+		device->DeleteSync(frameFence.fence);
+	}
+
+	device->UnmapBuffer(buffer_);
+	device->DeleteBuffer(buffer_);
+}
+
+bool StagingBuffer::Write(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, StagedMesh& stagedMeshOut)
+{
+	uint32_t vertexBytes = vertices.size() * sizeof(Vertex);
+	uint32_t indexBytes = indices.size() * sizeof(unsigned int);
+	if (mappedData_ == nullptr || vertexBytes == 0)
+	{
+		return false;
+	}
+
+	StagingAllocation allocation;
+	if (!ring_.TryAllocate(vertexBytes + indexBytes, sizeof(unsigned int), allocation))
+	{
+		return false;
+	}
+
+	memcpy(mappedData_ + allocation.offset, vertices.data(), vertexBytes);
+	memcpy(mappedData_ + allocation.offset + vertexBytes, indices.data(), indexBytes);
+
+	stagedMeshOut.allocation = allocation;
+	stagedMeshOut.numVertices = vertices.size();
+	stagedMeshOut.numIndices = indices.size();
+	stagedMeshOut.indexOffset = allocation.offset + vertexBytes;
+	return true;
+}
+
+void StagingBuffer::Release(const StagedMesh& stagedMesh)
+{
+	ring_.Release(stagedMesh.allocation, frame_);
+}
+
+void StagingBuffer::EndFrame()
+{
+	RenderDevice* device = RenderDevice::Get();
+	fences_.push_back({ frame_, device->FenceSync() });
+	frame_++;
+
+	// Don't wait, whatever hasn't finished yet is checked again next frame
+	while (!fences_.empty())
+	{
+		if (!device->IsSyncSignalled(fences_.front().fence))
+		{
+			break;
+		}
+
+		ring_.CompleteFrame(fences_.front().frame);
+		device->DeleteSync(fences_.front().fence);
+		fences_.pop_front();
+	}
+}
+
+unsigned int StagingBuffer::GetBuffer()
+{
+	return buffer_;
+}
+
+StagingRingStats StagingBuffer::GetStats()
+{
+	return ring_.GetStats();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <glad/gl.h>
+
+#include "mesh.h"
+#include "stagingRing.h"
+
+/*
+ * A persistently mapped, coherent buffer that worker threads write
+ * finished meshes straight into, so uploading them is only a GPU side
+ * copy (glCopyNamedBufferSubData) on the main thread rather than the
+ * driver copying the data out of our memory.
+ *
+ * The space is handed out by a StagingRing. Each frame ends with a
+ * fence, and once the fence for the frame a mesh was copied in has
+ * signalled its space is reused.
+ */
+class StagingBuffer
+{
+	struct FrameFence
+	{
+		uint64_t frame;
+		GLsync fence;
+	};
+
+	unsigned int buffer_;
+	uint8_t* mappedData_;
+
+	StagingRing ring_;
+
+	// Only used on the main thread
+	uint64_t frame_;
+	std::deque<FrameFence> fences_;
+public:
+	StagingBuffer(uint32_t capacity);
+	~StagingBuffer();
+
+	/*
+	 * Copies the mesh into the buffer, safe to call from any thread.
+	 * Returns false if there wasn't room (or the mesh is empty), then
+	 * the mesh has to be uploaded the old way.
+	 */
+	bool Write(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, StagedMesh& stagedMeshOut);
+
+	// The mesh has been copied out (or isn't needed), main thread only
+	void Release(const StagedMesh& stagedMesh);
+
+	// Fences the copies issued this frame and reclaims the space from finished frames, main thread only
+	void EndFrame();
+
+	unsigned int GetBuffer();
+	StagingRingStats GetStats();
+};
@@ -0,0 +1,226 @@
+#include "stagingRing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+StagingRing::StagingRing(uint32_t capacity)
+{
+	capacity_ = capacity;
+	head_ = 0;
+	tail_ = 0;
+	used_ = 0;
+	records_ = std::deque<Record>();
+	nextId_ = 0;
+	stats_ = {};
+	stats_.capacity = capacity_;
+}
+
+bool StagingRing::TryAllocate(uint32_t size, uint32_t alignment, StagingAllocation& allocationOut)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (used_ == 0)
+	{
+		// Nothing's in use, so start from the beginning again to keep the space in one piece
+		head_ = 0;
+		tail_ = 0;
+	}
+
+	uint32_t alignedHead = (head_ + alignment - 1) / alignment * alignment;
+	uint32_t offset = 0;
+	uint32_t consumed = 0;
+
+	if (head_ >= tail_ && !(head_ == tail_ && used_ > 0))
+	{
+		// The free space is from the head to the end, then from the start to the tail
+		if (static_cast<uint64_t>(alignedHead) + size <= capacity_)
+		{
+			offset = alignedHead;
+			consumed = alignedHead + size - head_;
+		}
+		else if (size <= tail_)
+		{
+			// Skip the bit at the end, it's given back along with this allocation
+			offset = 0;
+			consumed = capacity_ - head_ + size;
+		}
+		else
+		{
+			stats_.numFull++;
+			return false;
+		}
+	}
+	else
+	{
+		// The head has wrapped around behind the tail
+		if (static_cast<uint64_t>(alignedHead) + size <= tail_)
+		{
+			offset = alignedHead;
+			consumed = alignedHead + size - head_;
+		}
+		else
+		{
+			stats_.numFull++;
+			return false;
+		}
+	}
+
+	head_ = offset + size;
+	used_ += consumed;
+
+	allocationOut = { offset, size, nextId_ };
+	records_.push_back({ nextId_, head_, consumed, false, 0 });
+	nextId_++;
+
+	stats_.numAllocated++;
+	return true;
+}
+
+void StagingRing::Release(const StagingAllocation& allocation, uint64_t frame)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// The records are in id order with none missing, so the id gives the index
+	Record& record = records_[allocation.id - records_.front().id];
+	record.isReleased = true;
+	record.releaseFrame = frame;
+}
+
+void StagingRing::CompleteFrame(uint64_t frame)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	while (!records_.empty() && records_.front().isReleased && records_.front().releaseFrame <= frame)
+	{
+		tail_ = records_.front().end == capacity_ ? 0 : records_.front().end;
+		used_ -= records_.front().consumed;
+		records_.pop_front();
+	}
+
+	stats_.completedFrame = frame;
+}
+
+StagingRingStats StagingRing::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	StagingRingStats stats = stats_;
+	stats.bytesInUse = used_;
+	stats.numInUse = records_.size();
+	return stats;
+}
+
+bool StagingRing::RunBenchmark(int numFrames)
+{
+	struct Written
+	{
+		StagingAllocation allocation;
+		uint8_t pattern;
+		uint64_t releaseFrame;
+	};
+
+	const uint32_t capacity = 1024 * 1024;
+	const int numThreads = 4;
+	const uint64_t gpuLatency = 2; // frames
+
+	std::vector<uint8_t> buffer = std::vector<uint8_t>(capacity);
+	StagingRing ring = StagingRing(capacity);
+
+	std::mutex writtenMutex;
+	std::vector<Written> written = std::vector<Written>();
+	std::vector<Written> released = std::vector<Written>();
+
+	auto isIntact = [&buffer](const Written& item) {
+		for (uint32_t i = 0; i < item.allocation.size; i++)
+		{
+			if (buffer[item.allocation.offset + i] != item.pattern)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	bool wasOverwritten = false;
+	std::mt19937 random = std::mt19937(1337);
+
+	auto startTime = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		// Workers finishing meshes, about a chunk's worth of data each
+		std::vector<std::thread> threads = std::vector<std::thread>();
+		for (int t = 0; t < numThreads; t++)
+		{
+			uint32_t size = 1024 + random() % (64 * 1024);
+			threads.push_back(std::thread([&, size]() {
+				StagingAllocation allocation;
+				if (!ring.TryAllocate(size, 4, allocation))
+				{
+					return;
+				}
+
+				uint8_t pattern = static_cast<uint8_t>(allocation.id * 31 + 7);
+				memset(buffer.data() + allocation.offset, pattern, size);
+
+				std::lock_guard<std::mutex> lock(writtenMutex);
+				written.push_back({ allocation, pattern, 0 });
+			}));
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		// The main thread copies most of them out this frame, and leaves some for later
+		std::vector<Written> notCopied = std::vector<Written>();
+		for (Written& item : written)
+		{
+			if (random() % 8 == 0)
+			{
+				notCopied.push_back(item);
+				continue;
+			}
+
+			wasOverwritten = wasOverwritten || !isIntact(item);
+			item.releaseFrame = frame;
+			ring.Release(item.allocation, frame);
+			released.push_back(item);
+		}
+		written = notCopied;
+
+		// The GPU finishes the copies a couple of frames later, until then the data has to stay put
+		if (static_cast<uint64_t>(frame) >= gpuLatency)
+		{
+			uint64_t completedFrame = frame - gpuLatency;
+			std::vector<Written> stillInFlight = std::vector<Written>();
+			for (const Written& item : released)
+			{
+				if (item.releaseFrame <= completedFrame)
+				{
+					wasOverwritten = wasOverwritten || !isIntact(item);
+				}
+				else
+				{
+					stillInFlight.push_back(item);
+				}
+			}
+			released = stillInFlight;
+			ring.CompleteFrame(completedFrame);
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	StagingRingStats stats = ring.GetStats();
+	printf("%d frames in %.1fms, %d allocations, %d didn't fit, %zuKB still in use\n",
+		numFrames, seconds * 1000.0, stats.numAllocated, stats.numFull, stats.bytesInUse / 1024);
+	if (wasOverwritten)
+	{
+		printf("Data was overwritten while it was still in use\n");
+	}
+
+	return !wasOverwritten;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// A range of the ring, in bytes
+struct StagingAllocation
+{
+	uint32_t offset;
+	uint32_t size;
+	uint64_t id;
+};
+
+// A mesh written to the staging buffer, the vertices come first then the indices
+struct StagedMesh
+{
+	StagingAllocation allocation;
+	uint32_t numVertices;
+	uint32_t numIndices;
+	uint32_t indexOffset; // bytes from the start of the buffer
+};
+
+struct StagingRingStats
+{
+	size_t capacity;
+	size_t bytesInUse; // written, or waiting for the GPU to finish copying
+	int numInUse;
+	int numAllocated;
+	int numFull; // allocations that didn't fit
+	uint64_t completedFrame;
+};
+
+/*
+ * Hands out space in a ring buffer that's refilled as the GPU finishes
+ * with it. This is only the bookkeeping, see StagingBuffer for the
+ * buffer itself.
+ *
+ * Any thread can allocate. Once the data has been copied out (or isn't
+ * needed) the main thread releases it with the frame the copy was
+ * issued in, and when the fence for that frame signals, CompleteFrame
+ * makes the space available again.
+ *
+ * Space is only reclaimed from the oldest allocation forwards, so an
+ * allocation that's released late holds up everything after it. If the
+ * ring fills up, allocating fails and the caller has to make do without.
+ */
+class StagingRing
+{
+	struct Record
+	{
+		uint64_t id;
+		uint32_t end;
+		uint32_t consumed; // including padding and the skipped space at the end if it wrapped
+		bool isReleased;
+		uint64_t releaseFrame;
+	};
+
+	std::mutex mutex_;
+
+	uint32_t capacity_;
+	uint32_t head_;
+	uint32_t tail_;
+	uint32_t used_;
+
+	std::deque<Record> records_;
+	uint64_t nextId_;
+
+	StagingRingStats stats_;
+public:
+	StagingRing(uint32_t capacity);
+
+	// Safe from any thread, returns false if there isn't room
+	bool TryAllocate(uint32_t size, uint32_t alignment, StagingAllocation& allocationOut);
+
+	// The data won't be read after the given frame has completed on the GPU
+	void Release(const StagingAllocation& allocation, uint64_t frame);
+
+	// Every frame up to and including this one has finished on the GPU
+	void CompleteFrame(uint64_t frame);
+
+	StagingRingStats GetStats();
+
+	/*
+	 * Has several threads allocating and writing a pattern into a fake
+	 * buffer while the main thread releases and completes frames a few
+	 * behind, like a GPU would. Returns false if any data was overwritten
+	 * before it was released.
+	 */
+	static bool RunBenchmark(int numFrames);
+};
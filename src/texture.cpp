@@ -1,12 +1,19 @@
 #include "texture.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "assetPack.h"
 #include "logging.h"
+#include "renderDevice.h"
+#include "textureBaker.h"
 
 Texture::Texture(TextureData textureData, GLenum textureTarget, GLint textureMinFilter, GLint textureMagFilter)
 {
 	textureTarget_ = textureTarget;
-	glCreateTextures(textureTarget, 1, &textureId_);
+	textureId_ = RenderDevice::Get()->CreateTexture(textureTarget);
 
-	if (!glIsTexture(textureId_))
+	if (textureId_ == 0)
 	{
 		LOG("Couldn't create OpenGL texture\n");
 	}
@@ -16,21 +23,25 @@ Texture::Texture(TextureData textureData, GLenum textureTarget, GLint textureMin
 
 void Texture::Bind(GLenum textureUnit)
 {
-	glActiveTexture(textureUnit);
-	glBindTexture(textureTarget_, textureId_);
+	RenderDevice::Get()->BindTextureUnit(textureUnit - GL_TEXTURE0, textureId_);
 }
 
 void Texture::Unbind(GLenum textureUnit)
 {
-	glActiveTexture(textureUnit);
-	glBindTexture(textureTarget_, 0);
+	RenderDevice::Get()->BindTextureUnit(textureUnit - GL_TEXTURE0, 0);
 }
 
 TextureData Texture::LoadTextureDataFromFile(const char* file, int desiredChannels)
 {
 	TextureData textureData{};
 
-	textureData.data = stbi_load(file, &textureData.width, &textureData.height, &textureData.numChannels, desiredChannels);
+	// Decoded straight out of the asset pack when there is one
+	std::vector<uint8_t> storage = std::vector<uint8_t>();
+	AssetView asset{};
+	if (AssetPack::ReadAsset(file, asset, storage))
+	{
+		textureData.data = stbi_load_from_memory(asset.data, static_cast<int>(asset.size), &textureData.width, &textureData.height, &textureData.numChannels, desiredChannels);
+	}
 
 	if (!textureData.data)
 	{
@@ -70,20 +81,22 @@ GLenum Texture::GetTextureUnitFromInt(int index)
 Texture2D::Texture2D(TextureData textureData, GLenum textureTarget, GLint textureMinFilter, GLint textureMagFilter)
 	: Texture(textureData, textureTarget, textureMinFilter, textureMagFilter)
 {
-	Bind(GL_TEXTURE0);
-
-	glTexParameteri(textureTarget_, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(textureTarget_, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(textureTarget_, GL_TEXTURE_MIN_FILTER, textureMinFilter);
-	glTexParameteri(textureTarget_, GL_TEXTURE_MAG_FILTER, textureMagFilter);
+	RenderDevice* device = RenderDevice::Get();
+	device->TextureParameter(textureId_, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	device->TextureParameter(textureId_, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	device->TextureParameter(textureId_, GL_TEXTURE_MIN_FILTER, textureMinFilter);
+	device->TextureParameter(textureId_, GL_TEXTURE_MAG_FILTER, textureMagFilter);
 
+	GLenum format = GL_RGB;
 	if (textureData.numChannels == 3)
 	{
-		internalFormat = GL_RGB;
+		internalFormat = GL_RGB8;
+		format = GL_RGB;
 	}
 	else if (textureData.numChannels == 4)
 	{
-		internalFormat = GL_RGBA;
+		internalFormat = GL_RGBA8;
+		format = GL_RGBA;
 	}
 	else
 	{
@@ -91,8 +104,11 @@ Texture2D::Texture2D(TextureData textureData, GLenum textureTarget, GLint textur
 		return;
 	}
 
-	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, textureData.width, textureData.height, 0, internalFormat, GL_UNSIGNED_BYTE, textureData.data);
-	glGenerateMipmap(textureTarget_);
+	// Immutable storage needs room for every mip level up front
+	int numLevels = 1 + static_cast<int>(std::floor(std::log2(std::max(std::max(textureData.width, textureData.height), 1))));
+	device->TextureStorage2D(textureId_, numLevels, internalFormat, textureData.width, textureData.height);
+	device->TextureSubImage2D(textureId_, 0, textureData.width, textureData.height, format, GL_UNSIGNED_BYTE, textureData.data);
+	device->GenerateTextureMipmap(textureId_);
 }
 
 Texture2DArray::Texture2DArray(TextureData textureData, GLenum textureTarget, GLint textureMinFilter, GLint textureMagFilter, int numCols, int numRows)
@@ -101,29 +117,52 @@ Texture2DArray::Texture2DArray(TextureData textureData, GLenum textureTarget, GL
 	numCols_ = numCols;
 	numRows_ = numRows;
 
-	Bind(GL_TEXTURE0);
-
-	glTexParameteri(textureTarget_, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(textureTarget_, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(textureTarget_, GL_TEXTURE_MIN_FILTER, textureMinFilter);
-	glTexParameteri(textureTarget_, GL_TEXTURE_MAG_FILTER, textureMagFilter);
+	RenderDevice* device = RenderDevice::Get();
+	device->TextureParameter(textureId_, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	device->TextureParameter(textureId_, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	device->TextureParameter(textureId_, GL_TEXTURE_MIN_FILTER, textureMinFilter);
+	device->TextureParameter(textureId_, GL_TEXTURE_MAG_FILTER, textureMagFilter);
 
-	glTexStorage3D(textureTarget_, 1, GL_RGB8, textureData.width/numCols, textureData.height/numRows, numCols * numRows);
+	device->TextureStorage3D(textureId_, 1, GL_RGB8, textureData.width/numCols, textureData.height/numRows, numCols * numRows);
 
 	for (int x = 0; x < numCols; x++) {
 		for (int y = 0; y < numRows; y++) {
-			glPixelStorei(GL_UNPACK_ROW_LENGTH, textureData.width);
-			glPixelStorei(GL_UNPACK_SKIP_PIXELS, x * (textureData.width / numCols));
-			glPixelStorei(GL_UNPACK_SKIP_ROWS, y * (textureData.height / numRows));
-			glTexSubImage3D(textureTarget_, 0, 0, 0, y * numCols + x, textureData.width / numCols, textureData.height / numRows, 1, GL_RGB, GL_UNSIGNED_BYTE, textureData.data);
-			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-			glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-			glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+			device->TextureSubImage3D(textureId_, 0, y * numCols + x, textureData.width / numCols, textureData.height / numRows, 1, GL_RGB, GL_UNSIGNED_BYTE,
+				textureData.data, textureData.width, x * (textureData.width / numCols), y * (textureData.height / numRows));
 		}
 	}
 
-	glGenerateMipmap(textureTarget_);
-	Unbind(GL_TEXTURE0);
+	device->GenerateTextureMipmap(textureId_);
+}
+
+Texture2DArray::Texture2DArray(const BakedTexture& bakedTexture, GLenum textureTarget, GLint textureMinFilter, GLint textureMagFilter)
+	: Texture(TextureData(), textureTarget, textureMinFilter, textureMagFilter)
+{
+	numCols_ = bakedTexture.numCols;
+	numRows_ = bakedTexture.numRows;
+
+	RenderDevice* device = RenderDevice::Get();
+	device->TextureParameter(textureId_, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	device->TextureParameter(textureId_, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	device->TextureParameter(textureId_, GL_TEXTURE_MIN_FILTER, textureMinFilter);
+	device->TextureParameter(textureId_, GL_TEXTURE_MAG_FILTER, textureMagFilter);
+
+	GLenum internalFormat = bakedTexture.numChannels == 4 ? GL_RGBA8 : GL_RGB8;
+	GLenum format = bakedTexture.numChannels == 4 ? GL_RGBA : GL_RGB;
+	int numLayers = numCols_ * numRows_;
+	device->TextureStorage3D(textureId_, bakedTexture.numLevels, internalFormat, bakedTexture.width, bakedTexture.height, numLayers);
+
+	// Each level already holds every layer back to back, so it's one
+	// upload per level straight out of the baked data
+	int width = bakedTexture.width;
+	int height = bakedTexture.height;
+	for (int level = 0; level < bakedTexture.numLevels; level++)
+	{
+		device->TextureSubImage3D(textureId_, level, 0, width, height, numLayers, format, GL_UNSIGNED_BYTE,
+			bakedTexture.GetPixels() + bakedTexture.levelOffsets[level], 0, 0, 0);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
 }
 
 Texture2DArray::Texture2DArray()
@@ -3,6 +3,8 @@
 #include <stb_image.h>
 #include <vector>
 
+struct BakedTexture;
+
 struct TextureData
 {
 	int width, height;
@@ -59,6 +61,9 @@ public:
 	Texture2DArray();
 	Texture2DArray(TextureData textureData, GLenum textureTarget, GLint textureMinFilter, GLint textureMagFilter, int numCols, int numRows);
 
+	// Uploads the layers and mips as they were baked, see TextureBaker
+	Texture2DArray(const BakedTexture& bakedTexture, GLenum textureTarget, GLint textureMinFilter, GLint textureMagFilter);
+
 	int GetNumCols();
 	int GetNumRows();
 };
@@ -0,0 +1,360 @@
+#include "textureBaker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+#include "assetPack.h"
+#include "fileUtils.h"
+#include "logging.h"
+
+const uint8_t* BakedTexture::GetPixels() const
+{
+	return data.empty() ? packedPixels : data.data();
+}
+
+size_t BakedTexture::GetSize() const
+{
+	return data.empty() ? packedSize : data.size();
+}
+
+namespace TextureBaker
+{
+	namespace
+	{
+		const uint8_t MAGIC[4] = { 'B', 'T', 'E', 'X' };
+		const size_t HEADER_SIZE = 40;
+
+		// Stops a corrupt header from making us allocate gigabytes
+		const uint32_t MAX_SIZE = 16384;
+
+		void WriteU32(std::vector<uint8_t>& out, uint32_t value)
+		{
+			out.push_back(static_cast<uint8_t>(value));
+			out.push_back(static_cast<uint8_t>(value >> 8));
+			out.push_back(static_cast<uint8_t>(value >> 16));
+			out.push_back(static_cast<uint8_t>(value >> 24));
+		}
+
+		uint32_t ReadU32(const uint8_t* data)
+		{
+			return static_cast<uint32_t>(data[0]) |
+				(static_cast<uint32_t>(data[1]) << 8) |
+				(static_cast<uint32_t>(data[2]) << 16) |
+				(static_cast<uint32_t>(data[3]) << 24);
+		}
+
+		int GetNumLevels(int width, int height)
+		{
+			int numLevels = 1;
+			while (width > 1 || height > 1)
+			{
+				width = width > 1 ? width / 2 : 1;
+				height = height > 1 ? height / 2 : 1;
+				numLevels++;
+			}
+			return numLevels;
+		}
+
+		// Fills in the level offsets, returns how big the data needs to be for them
+		size_t LayOutLevels(BakedTexture& bakedTexture)
+		{
+			size_t layerCount = static_cast<size_t>(bakedTexture.numCols) * bakedTexture.numRows;
+			size_t offset = 0;
+			int width = bakedTexture.width;
+			int height = bakedTexture.height;
+
+			bakedTexture.levelOffsets = std::vector<size_t>(bakedTexture.numLevels);
+			for (int level = 0; level < bakedTexture.numLevels; level++)
+			{
+				bakedTexture.levelOffsets[level] = offset;
+				offset += static_cast<size_t>(width) * height * bakedTexture.numChannels * layerCount;
+				width = width > 1 ? width / 2 : 1;
+				height = height > 1 ? height / 2 : 1;
+			}
+
+			return offset;
+		}
+
+		bool LoadSource(const AssetView& source, int numCols, int numRows, BakedTexture& bakedTextureOut)
+		{
+			TextureData textureData{};
+			textureData.data = stbi_load_from_memory(source.data, static_cast<int>(source.size), &textureData.width, &textureData.height, &textureData.numChannels, 3);
+			if (!textureData.data)
+			{
+				return false;
+			}
+
+			// The layers are uploaded as RGB, whatever the png had
+			textureData.numChannels = 3;
+			bakedTextureOut = Bake(textureData, numCols, numRows);
+			Texture::FreeTextureData(textureData);
+			return true;
+		}
+	}
+
+	BakedTexture Bake(const TextureData& textureData, int numCols, int numRows)
+	{
+		BakedTexture bakedTexture{};
+		bakedTexture.width = textureData.width / numCols;
+		bakedTexture.height = textureData.height / numRows;
+		bakedTexture.numCols = numCols;
+		bakedTexture.numRows = numRows;
+		bakedTexture.numLevels = GetNumLevels(bakedTexture.width, bakedTexture.height);
+		bakedTexture.numChannels = textureData.numChannels;
+		bakedTexture.data = std::vector<uint8_t>(LayOutLevels(bakedTexture));
+
+		int numChannels = bakedTexture.numChannels;
+		int numLayers = numCols * numRows;
+
+		// Level 0 is each tile copied out of the atlas, in the same
+		// layer order as Texture2DArray slices them
+		size_t layerSize = static_cast<size_t>(bakedTexture.width) * bakedTexture.height * numChannels;
+		size_t rowSize = static_cast<size_t>(bakedTexture.width) * numChannels;
+		for (int x = 0; x < numCols; x++)
+		{
+			for (int y = 0; y < numRows; y++)
+			{
+				uint8_t* layer = bakedTexture.data.data() + (y * numCols + x) * layerSize;
+				for (int row = 0; row < bakedTexture.height; row++)
+				{
+					const uint8_t* source = textureData.data + ((static_cast<size_t>(y) * bakedTexture.height + row) * textureData.width + static_cast<size_t>(x) * bakedTexture.width) * numChannels;
+					std::copy(source, source + rowSize, layer + row * rowSize);
+				}
+			}
+		}
+
+		// Every other level averages 2x2 texels of the one above it,
+		// an odd size repeats its last row or column
+		int width = bakedTexture.width;
+		int height = bakedTexture.height;
+		for (int level = 1; level < bakedTexture.numLevels; level++)
+		{
+			int levelWidth = width > 1 ? width / 2 : 1;
+			int levelHeight = height > 1 ? height / 2 : 1;
+			const uint8_t* above = bakedTexture.data.data() + bakedTexture.levelOffsets[level - 1];
+			uint8_t* current = bakedTexture.data.data() + bakedTexture.levelOffsets[level];
+
+			for (int layer = 0; layer < numLayers; layer++)
+			{
+				const uint8_t* aboveLayer = above + static_cast<size_t>(layer) * width * height * numChannels;
+				uint8_t* currentLayer = current + static_cast<size_t>(layer) * levelWidth * levelHeight * numChannels;
+
+				for (int y = 0; y < levelHeight; y++)
+				{
+					int y0 = std::min(y * 2, height - 1);
+					int y1 = std::min(y * 2 + 1, height - 1);
+					for (int x = 0; x < levelWidth; x++)
+					{
+						int x0 = std::min(x * 2, width - 1);
+						int x1 = std::min(x * 2 + 1, width - 1);
+						for (int channel = 0; channel < numChannels; channel++)
+						{
+							int sum = aboveLayer[(y0 * width + x0) * numChannels + channel] +
+								aboveLayer[(y0 * width + x1) * numChannels + channel] +
+								aboveLayer[(y1 * width + x0) * numChannels + channel] +
+								aboveLayer[(y1 * width + x1) * numChannels + channel];
+							currentLayer[(y * levelWidth + x) * numChannels + channel] = static_cast<uint8_t>((sum + 2) / 4);
+						}
+					}
+				}
+			}
+
+			width = levelWidth;
+			height = levelHeight;
+		}
+
+		return bakedTexture;
+	}
+
+	std::vector<uint8_t> Serialise(const BakedTexture& bakedTexture, uint64_t sourceHash)
+	{
+		std::vector<uint8_t> out = std::vector<uint8_t>();
+		out.reserve(HEADER_SIZE + bakedTexture.GetSize());
+
+		out.insert(out.end(), MAGIC, MAGIC + 4);
+		WriteU32(out, VERSION);
+		WriteU32(out, static_cast<uint32_t>(sourceHash));
+		WriteU32(out, static_cast<uint32_t>(sourceHash >> 32));
+		WriteU32(out, bakedTexture.width);
+		WriteU32(out, bakedTexture.height);
+		WriteU32(out, bakedTexture.numCols);
+		WriteU32(out, bakedTexture.numRows);
+		WriteU32(out, bakedTexture.numLevels);
+		WriteU32(out, bakedTexture.numChannels);
+		out.insert(out.end(), bakedTexture.GetPixels(), bakedTexture.GetPixels() + bakedTexture.GetSize());
+
+		return out;
+	}
+
+	bool Deserialise(const uint8_t* data, size_t size, uint64_t sourceHash, BakedTexture& bakedTextureOut)
+	{
+		if (size < HEADER_SIZE || !std::equal(MAGIC, MAGIC + 4, data) || ReadU32(data + 4) != VERSION)
+		{
+			return false;
+		}
+
+		uint64_t bakedHash = ReadU32(data + 8) | (static_cast<uint64_t>(ReadU32(data + 12)) << 32);
+		if (bakedHash != sourceHash)
+		{
+			return false;
+		}
+
+		uint32_t width = ReadU32(data + 16);
+		uint32_t height = ReadU32(data + 20);
+		uint32_t numCols = ReadU32(data + 24);
+		uint32_t numRows = ReadU32(data + 28);
+		uint32_t numLevels = ReadU32(data + 32);
+		uint32_t numChannels = ReadU32(data + 36);
+		if (width == 0 || width > MAX_SIZE || height == 0 || height > MAX_SIZE ||
+			numCols == 0 || numCols > MAX_SIZE || numRows == 0 || numRows > MAX_SIZE ||
+			numChannels < 1 || numChannels > 4 ||
+			static_cast<int>(numLevels) != GetNumLevels(width, height))
+		{
+			return false;
+		}
+
+		BakedTexture bakedTexture{};
+		bakedTexture.width = width;
+		bakedTexture.height = height;
+		bakedTexture.numCols = numCols;
+		bakedTexture.numRows = numRows;
+		bakedTexture.numLevels = numLevels;
+		bakedTexture.numChannels = numChannels;
+		if (size - HEADER_SIZE != LayOutLevels(bakedTexture))
+		{
+			return false;
+		}
+
+		bakedTexture.packedPixels = data + HEADER_SIZE;
+		bakedTexture.packedSize = size - HEADER_SIZE;
+		bakedTextureOut = std::move(bakedTexture);
+		return true;
+	}
+
+	uint64_t HashSource(const uint8_t* data, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ data[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool LoadOrBake(const std::string& sourcePath, const std::string& bakedPath, int numCols, int numRows, BakedTexture& bakedTextureOut)
+	{
+		// Reading the png is cheap next to decoding it, and it's how we
+		// know whether the baked file is still up to date
+		std::vector<uint8_t> sourceStorage = std::vector<uint8_t>();
+		AssetView source{};
+		if (!AssetPack::ReadAsset(sourcePath, source, sourceStorage))
+		{
+			LOG("Couldn't read %s\n", sourcePath.c_str());
+			return false;
+		}
+		uint64_t sourceHash = HashSource(source.data, source.size);
+
+		std::vector<uint8_t> bakedStorage = std::vector<uint8_t>();
+		AssetView baked{};
+		if (AssetPack::ReadAsset(bakedPath, baked, bakedStorage) && Deserialise(baked.data, baked.size, sourceHash, bakedTextureOut) &&
+			bakedTextureOut.numCols == numCols && bakedTextureOut.numRows == numRows)
+		{
+			// A loose file goes away with its storage, so it needs a copy
+			if (!bakedStorage.empty())
+			{
+				bakedTextureOut.data = std::vector<uint8_t>(bakedTextureOut.packedPixels, bakedTextureOut.packedPixels + bakedTextureOut.packedSize);
+				bakedTextureOut.packedPixels = nullptr;
+				bakedTextureOut.packedSize = 0;
+			}
+			return true;
+		}
+
+		LOG("%s is missing or out of date, baking %s\n", bakedPath.c_str(), sourcePath.c_str());
+		if (!LoadSource(source, numCols, numRows, bakedTextureOut))
+		{
+			LOG("Couldn't decode %s\n", sourcePath.c_str());
+			return false;
+		}
+
+		// Not being able to write the cache just means baking again next time
+		if (!FileUtils::WriteFileDurably(bakedPath, Serialise(bakedTextureOut, sourceHash)))
+		{
+			LOG("Couldn't write %s\n", bakedPath.c_str());
+		}
+
+		return true;
+	}
+
+	bool RunBake(const std::string& sourcePath, const std::string& bakedPath, int numCols, int numRows)
+	{
+		const int numIterations = 10;
+
+		std::vector<uint8_t> sourceStorage = std::vector<uint8_t>();
+		AssetView source{};
+		if (!AssetPack::ReadAsset(sourcePath, source, sourceStorage))
+		{
+			printf("Couldn't read %s\n", sourcePath.c_str());
+			return false;
+		}
+		uint64_t sourceHash = HashSource(source.data, source.size);
+
+		BakedTexture bakedTexture{};
+		if (!LoadSource(source, numCols, numRows, bakedTexture))
+		{
+			printf("Couldn't decode %s\n", sourcePath.c_str());
+			return false;
+		}
+
+		std::vector<uint8_t> baked = Serialise(bakedTexture, sourceHash);
+		if (!FileUtils::WriteFileDurably(bakedPath, baked))
+		{
+			printf("Couldn't write %s\n", bakedPath.c_str());
+			return false;
+		}
+
+		printf("Baked %s into %s: %d layers of %dx%d, %d levels, %zu bytes\n",
+			sourcePath.c_str(), bakedPath.c_str(), numCols * numRows, bakedTexture.width, bakedTexture.height, bakedTexture.numLevels, baked.size());
+
+		// What the game did on every launch, read, decode, slice and mip the png
+		double sourceSeconds = 0.0;
+		for (int iteration = 0; iteration < numIterations; iteration++)
+		{
+			auto startTime = std::chrono::steady_clock::now();
+			std::vector<uint8_t> storage = std::vector<uint8_t>();
+			AssetView data{};
+			BakedTexture loadedTexture{};
+			AssetPack::ReadAsset(sourcePath, data, storage);
+			LoadSource(data, numCols, numRows, loadedTexture);
+			sourceSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		}
+
+		// What it does now, read and hash the png, then read the baked file
+		double bakedSeconds = 0.0;
+		bool didMatch = true;
+		for (int iteration = 0; iteration < numIterations; iteration++)
+		{
+			auto startTime = std::chrono::steady_clock::now();
+			BakedTexture loadedTexture{};
+			bool wasLoaded = LoadOrBake(sourcePath, bakedPath, numCols, numRows, loadedTexture);
+			bakedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			if (!wasLoaded || loadedTexture.GetSize() != bakedTexture.GetSize() || !std::equal(bakedTexture.GetPixels(), bakedTexture.GetPixels() + bakedTexture.GetSize(), loadedTexture.GetPixels()))
+			{
+				didMatch = false;
+			}
+		}
+
+		double sourceMs = sourceSeconds * 1000.0 / numIterations;
+		double bakedMs = bakedSeconds * 1000.0 / numIterations;
+		printf("From the png: %.3fms, from the baked file: %.3fms, saves %.3fms (%.1fx) per launch\n",
+			sourceMs, bakedMs, sourceMs - bakedMs, sourceMs / bakedMs);
+
+		if (!didMatch)
+		{
+			printf("The baked file didn't load back the same as it was baked\n");
+		}
+
+		return didMatch;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "texture.h"
+
+/*
+ * A texture atlas sliced into array layers with its whole mip chain,
+ * in the order it's uploaded in. Each level holds every layer, one
+ * after the other, tightly packed.
+ */
+struct BakedTexture
+{
+	int width, height; // of a layer at level 0
+	int numCols, numRows; // of the atlas, there's a layer per tile
+	int numLevels;
+	int numChannels;
+	std::vector<size_t> levelOffsets; // into the pixels
+
+	// Straight out of the asset pack, which has to stay open. Only used when data is empty.
+	const uint8_t* packedPixels;
+	size_t packedSize;
+	std::vector<uint8_t> data;
+
+	// Whichever of the two holds the pixels, worked out on each call so copies stay valid
+	const uint8_t* GetPixels() const;
+	size_t GetSize() const;
+};
+
+/*
+ * Does the texture atlas work up front that every launch used to
+ * repeat, i.e. decoding the png, slicing it into layers and making
+ * the mips. The baked file remembers a hash of the png it came from,
+ * so an edited atlas is baked again instead of loading stale data.
+ *
+ * Baked layout :-
+ *   magic ("BTEX"), version (u32), source hash (u64), width, height,
+ *   num. cols, num. rows, num. levels, num. channels (u32 each),
+ *   every level from 0 down to 1x1
+ */
+namespace TextureBaker
+{
+	const uint32_t VERSION = 1;
+
+	// Box filters each level down from the one above it
+	BakedTexture Bake(const TextureData& textureData, int numCols, int numRows);
+
+	std::vector<uint8_t> Serialise(const BakedTexture& bakedTexture, uint64_t sourceHash);
+
+	/*
+	 * Returns false (and leaves bakedTextureOut alone) if the data is
+	 * truncated, from another version or wasn't baked from the source
+	 * with this hash. The pixels aren't copied, so the data has to
+	 * outlive the baked texture.
+	 */
+	bool Deserialise(const uint8_t* data, size_t size, uint64_t sourceHash, BakedTexture& bakedTextureOut);
+
+	// FNV-1a over the source file's bytes
+	uint64_t HashSource(const uint8_t* data, size_t size);
+
+	/*
+	 * Loads the baked file if it's up to date with the source, otherwise
+	 * bakes the source and writes the baked file for next time. Returns
+	 * false if the source can't be read. Both are read through the
+	 * AssetPack, a packed baked file isn't copied.
+	 */
+	bool LoadOrBake(const std::string& sourcePath, const std::string& bakedPath, int numCols, int numRows, BakedTexture& bakedTextureOut);
+
+	/*
+	 * Bakes the source into the baked file, then prints how long
+	 * loading each of them takes, i.e. how much startup time
+	 * baking saves. Returns false if the baked file didn't load back
+	 * the same as it was baked.
+	 */
+	bool RunBake(const std::string& sourcePath, const std::string& bakedPath, int numCols, int numRows);
+}
@@ -0,0 +1,73 @@
+#include "uploadScheduler.h"
+
+#include <algorithm>
+#include <GLFW/glfw3.h>
+
+UploadScheduler::UploadScheduler(size_t bytesPerFrame, double secondsPerFrame)
+{
+	bytesPerFrame_ = bytesPerFrame;
+	secondsPerFrame_ = secondsPerFrame;
+	pendingUploads_ = std::vector<PendingUpload>();
+	stats_ = {};
+}
+
+void UploadScheduler::SetBudget(size_t bytesPerFrame, double secondsPerFrame)
+{
+	bytesPerFrame_ = bytesPerFrame;
+	secondsPerFrame_ = secondsPerFrame;
+}
+
+size_t UploadScheduler::GetBytesPerFrame()
+{
+	return bytesPerFrame_;
+}
+
+double UploadScheduler::GetSecondsPerFrame()
+{
+	return secondsPerFrame_;
+}
+
+void UploadScheduler::Add(Mesh* mesh, float distanceFromCamera)
+{
+	pendingUploads_.push_back({ mesh, distanceFromCamera });
+}
+
+void UploadScheduler::Upload()
+{
+	std::sort(pendingUploads_.begin(), pendingUploads_.end(), [](const PendingUpload& a, const PendingUpload& b) {
+		return a.distance < b.distance;
+	});
+
+	double startTime = glfwGetTime();
+	size_t bytesUploaded = 0;
+	int numUploaded = 0;
+
+	for (const PendingUpload& pendingUpload : pendingUploads_)
+	{
+		if (numUploaded > 0)
+		{
+			bool isOverByteBudget = bytesUploaded + pendingUpload.mesh->GetUploadSize() > bytesPerFrame_;
+			bool isOverTimeBudget = glfwGetTime() - startTime >= secondsPerFrame_;
+
+			if (isOverByteBudget || isOverTimeBudget)
+			{
+				break;
+			}
+		}
+
+		bytesUploaded += pendingUpload.mesh->Upload();
+		numUploaded++;
+	}
+
+	stats_.bytesUploaded = bytesUploaded;
+	stats_.numUploaded = numUploaded;
+	stats_.uploadTime = glfwGetTime() - startTime;
+	stats_.numPending = pendingUploads_.size() - numUploaded;
+
+	pendingUploads_.clear();
+}
+
+UploadStats UploadScheduler::GetStats()
+{
+	return stats_;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+struct UploadStats
+{
+	// For the last frame
+	size_t bytesUploaded;
+	int numUploaded;
+	double uploadTime; // seconds
+
+	// Uploads carried over to the next frame
+	int numPending;
+};
+
+/*
+ * Spreads mesh uploads over several frames.
+ *
+ * Every frame the meshes that need uploading are added with their
+ * distance from the camera, then Upload sends the nearest ones to the
+ * GPU until the frame's byte or time budget runs out. Meshes that didn't
+ * fit are added again next frame (they still need uploading), so a batch
+ * of chunks finishing at once is spread out instead of causing a hitch.
+ *
+ * At least one mesh is uploaded every frame, so a mesh that's larger
+ * than the budget can't get stuck.
+ */
+class UploadScheduler
+{
+	struct PendingUpload
+	{
+		Mesh* mesh;
+		float distance;
+	};
+
+	size_t bytesPerFrame_;
+	double secondsPerFrame_;
+
+	std::vector<PendingUpload> pendingUploads_;
+	UploadStats stats_;
+public:
+	// What World starts with, the budget can be tuned in the debug overlay
+	static const size_t DEFAULT_BYTES_PER_FRAME = 4 * 1024 * 1024;
+	static constexpr double DEFAULT_SECONDS_PER_FRAME = 0.002;
+
+	UploadScheduler(size_t bytesPerFrame, double secondsPerFrame);
+
+	void SetBudget(size_t bytesPerFrame, double secondsPerFrame);
+	size_t GetBytesPerFrame();
+	double GetSecondsPerFrame();
+
+	void Add(Mesh* mesh, float distanceFromCamera);
+
+	// Only call this on the main thread, once per frame
+	void Upload();
+
+	UploadStats GetStats();
+};
@@ -1,17 +1,93 @@
 #include "world.h"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <climits>
 #include <future>
+#include <random>
 
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include "chunkLayout.h"
+#include "fileUtils.h"
 #include "logging.h"
+#include "nullRenderDevice.h"
+#include "textureBaker.h"
 #include <unordered_map>
 #include <GLFW/glfw3.h>
 
+namespace
+{
+	// The noise, biome and trees for a column of chunks (i.e. every y for an x and z)
+	struct ChunkColumn
+	{
+		int x;
+		int z;
+		int distanceFromPlayer; // num. chunks
+		Biome biome;
+		std::vector<float> noise;
+	};
+
+	struct StartupChunk
+	{
+		Chunk* chunk;
+		size_t columnIndex;
+	};
+
+	// The blocks a box touches, blocks are unit boxes centred on whole numbers
+	void GetBlocksInsideBox(const CollisionDetection::CollisionBox& box, glm::ivec3& minBlockOut, glm::ivec3& maxBlockOut)
+	{
+		CollisionDetection::CollisionBoxBounds bounds = CollisionDetection::getCollisionBoxBounds(box);
+		minBlockOut = glm::ivec3(
+			static_cast<int>(glm::ceil(bounds.min.x - 0.5f)),
+			static_cast<int>(glm::ceil(bounds.min.y - 0.5f)),
+			static_cast<int>(glm::ceil(bounds.min.z - 0.5f)));
+		maxBlockOut = glm::ivec3(
+			static_cast<int>(glm::floor(bounds.max.x + 0.5f)),
+			static_cast<int>(glm::floor(bounds.max.y + 0.5f)),
+			static_cast<int>(glm::floor(bounds.max.z + 0.5f)));
+	}
+
+	// Chunks still waiting on their first job have no blocks to edit
+	void RemoveUngeneratedChunks(std::vector<Chunk*>& chunks)
+	{
+		chunks.erase(std::remove_if(chunks.begin(), chunks.end(), [](Chunk* chunk) {
+			return chunk->IsUnloaded() || chunk->GetState()->blocks.IsEmpty();
+		}), chunks.end());
+	}
+}
+
 World::World(glm::vec3 currentPlayerPos, int renderDistance)
 {
-	srand(time(NULL));
-	seed_ = rand();
+	mainThreadId_ = std::this_thread::get_id();
+	startupStartTime_ = glfwGetTime();
+	hasDrawnFirstFrame_ = false;
+	hasFinishedStartup_ = false;
+	timeToFirstFrame_ = 0.0;
+	timeToFullRenderDistance_ = 0.0;
+
+	saveDirectory_ = "./Saves/World";
+	FileUtils::CreateDirectories(saveDirectory_);
+
+	seed_ = LoadOrCreateSeed();
 	renderDistance_ = renderDistance;
 
+	chunkStore_ = new ChunkStore(saveDirectory_ + "/chunks");
+
+	// Replay the edits that haven't made it into a chunk save yet
+	std::string editJournalPath = saveDirectory_ + "/edits.journal";
+	for (const EditRecord& record : EditJournal::Replay(editJournalPath))
+	{
+		chunkEdits_[record.chunkKey].push_back(record);
+	}
+	editJournal_ = new EditJournal(editJournalPath);
+
+	autosave_ = new Autosave(chunkStore_, autosaveInterval_,
+		[this](ChunkKey chunkKey) { return GetNumEdits(chunkKey); },
+		[this](const std::vector<SavedChunk>& savedChunks) { CompactEditJournal(savedChunks); });
+
 	TreeTrunkPositions = std::vector<glm::vec3>();
 	TreeLeavePositions = std::vector<glm::vec3>();
 
@@ -24,45 +100,231 @@ World::World(glm::vec3 currentPlayerPos, int renderDistance)
 	temperatureNoise_->SetLacunarity(2);
 	temperatureNoise_->SetGain(1.0f);
 
-	worldWorker_ = new WorldWorker(1);
+	jobSystem_ = new JobSystem();
+	completedChunks_ = new MpscQueue<ChunkResult>(512);
+	handoffStats_ = {};
+	uploadScheduler_ = new UploadScheduler(UploadScheduler::DEFAULT_BYTES_PER_FRAME, UploadScheduler::DEFAULT_SECONDS_PER_FRAME);
+	reclaimer_ = new EpochReclaimer();
 
-	int startZ = World::FindClosestPosition(currentPlayerPos.z, 16) - (16 * glm::floor(renderDistance_-1));
-	int startX = World::FindClosestPosition(currentPlayerPos.x, 16) - (16 * glm::floor(renderDistance_-1));
+	int playerZ = World::FindClosestPosition(currentPlayerPos.z, 16);
+	int playerX = World::FindClosestPosition(currentPlayerPos.x, 16);
+	int startZ = playerZ - (16 * glm::floor(renderDistance_-1));
+	int startX = playerX - (16 * glm::floor(renderDistance_-1));
 
 	// Double render distance since it pertains to all sides
-	TextureData textureData = Texture::LoadTextureDataFromFile("./Assets/textureAtlas.png");
-	Texture2DArray texture = Texture2DArray(textureData, GL_TEXTURE_2D_ARRAY, GL_NEAREST_MIPMAP_LINEAR, GL_NEAREST, 6, 8);
-	Texture::FreeTextureData(textureData);
+	// Baked with --bake-textures, or baked here the first time the atlas changes
+	BakedTexture bakedTexture{};
+	if (TextureBaker::LoadOrBake("./Assets/textureAtlas.png", "./Assets/textureAtlas.baked", 6, 8, bakedTexture))
+	{
+		texture_ = Texture2DArray(bakedTexture, GL_TEXTURE_2D_ARRAY, GL_NEAREST_MIPMAP_LINEAR, GL_NEAREST);
+	}
+	numTextureCols_ = 6;
+
+	// Before the chunks, their meshes go in its arena
+	chunkRenderer_ = new ChunkRenderer();
+
+	visibleChunks_ = std::vector<int>();
+	chunkQuadtree_ = new ChunkQuadtree();
+	haveChunksMoved_ = true;
+	chunksByKey_ = std::unordered_map<ChunkKey, Chunk*, ChunkKeyHash>();
+	haveChunkKeysChanged_ = true;
+	isChunkOccluded_ = std::vector<uint8_t>();
 
+	visibilityGraph_ = new ChunkVisibilityGraph();
+	numUnreachableChunks_ = 0;
+	visibilityCullTime_ = 0.0;
+
+	occlusionCuller_ = new OcclusionCuller(256, 128);
+	haveOccludersChanged_ = true;
+	occlusionCullTime_ = 0.0;
+
+	// Sort the columns nearest first, so the spawn area is generated first
+	std::vector<ChunkColumn> columns = std::vector<ChunkColumn>();
 	for (int z = 0; z < renderDistance*2+1; z++)
 	{
 		for (int x = 0; x < renderDistance*2+1; x++)
 		{
-			std::vector<float> chunkSectionNoise = GetNoiseForChunkSection(startX + x * 16.0f, startZ + z * 16.0f, 16);
+			ChunkColumn column{};
+			column.x = startX + x * 16;
+			column.z = startZ + z * 16;
+			column.distanceFromPlayer = glm::max(glm::abs(column.x - playerX), glm::abs(column.z - playerZ)) / 16;
+			columns.push_back(column);
+		}
+	}
+
+	std::stable_sort(columns.begin(), columns.end(), [](const ChunkColumn& a, const ChunkColumn& b) {
+		return a.distanceFromPlayer < b.distanceFromPlayer;
+	});
+
+	// Trees can cross into neighbouring chunks, so every column's
+	// trees need to exist before any chunk's blocks are generated.
+	jobSystem_->ParallelFor(columns.size(), [this, &columns](int i) {
+		ChunkColumn& column = columns[i];
+		column.noise = GetNoiseForChunkSection(column.x, column.z, 16);
+
+		float temperature = 0.0f;
+		temperatureNoise_->GenUniformGrid2D(&temperature, column.x / 16.0f, column.z / 16.0f, 1, 1, 0.05f, seed_);
+		column.biome = World::GetBiomeFromTemperature(temperature);
+
+		SetTreeBlocksForChunk(column.biome, column.x, column.z, yMin, yMax, column.noise, 16);
+	});
+
+	// Creating the chunks creates their GPU resources, so this has to happen on
+	// the main thread. Generating their blocks and meshes can happen anywhere.
+	std::vector<StartupChunk> spawnChunks = std::vector<StartupChunk>();
+	std::vector<StartupChunk> remainingChunks = std::vector<StartupChunk>();
+	for (size_t i = 0; i < columns.size(); i++)
+	{
+		const ChunkColumn& column = columns[i];
 
-			float temperature = 0.0f;
-			temperatureNoise_->GenUniformGrid2D(&temperature, (startX + x * 16.0f) / 16.0f, (startZ + z * 16.0f) / 16.0f, 1, 1, 0.05f, seed_);
-			Biome biome = World::GetBiomeFromTemperature(temperature);
+		for (int y = yMin; y <= yMax; y++) {
+			Chunk* chunk = new Chunk(this, texture_, glm::vec3(column.x, y * 16.0f, column.z), 16, seed_);
+			chunks_.push_back(chunk);
 
-            SetTreeBlocksForChunk(biome, (startX + x * 16.0f), (startZ + z * 16.0f), yMin, yMax, chunkSectionNoise, 16);
-			for (int y = yMin; y <= yMax; y++) {
-				
-				chunks_.push_back(new Chunk(this, biome, texture, chunkSectionNoise, yMin, yMax, glm::vec3(startX + (x * 16.0f), y * 16.0f, startZ + (z * 16.0f)), 16, seed_));
+			if (column.distanceFromPlayer <= spawnDistance_)
+			{
+				spawnChunks.push_back({ chunk, i });
+			}
+			else
+			{
+				remainingChunks.push_back({ chunk, i });
 			}
 		}
 	}
 
+	// Only the spawn area holds up the first frame. The main thread is waiting
+	// on these, so they're swapped in straight away rather than queued.
+	std::vector<ChunkResult> spawnResults = std::vector<ChunkResult>(spawnChunks.size());
+	jobSystem_->ParallelFor(spawnChunks.size(), [&](int i) {
+		const StartupChunk& startupChunk = spawnChunks[i];
+		const ChunkColumn& column = columns[startupChunk.columnIndex];
+		glm::vec3 position = startupChunk.chunk->GetTransformComponent()->GetTranslation();
+
+		spawnResults[i] = GenerateChunkResult(startupChunk.chunk, startupChunk.chunk->GetVersion(), position, column.biome, column.noise);
+	});
+
+	for (ChunkResult& result : spawnResults)
+	{
+		result.chunk->ApplyResult(result);
+	}
+
+	LOG("Generated %zu spawn chunks in %fms\n", spawnChunks.size(), (glfwGetTime() - startupStartTime_) * 1000);
+
+	// The rest stream in while the game is running. Workers run their newest
+	// jobs first, so they're scheduled furthest first to load nearest first.
+	std::shared_ptr<std::vector<ChunkColumn>> sharedColumns = std::make_shared<std::vector<ChunkColumn>>(std::move(columns));
+	for (int i = remainingChunks.size() - 1; i >= 0; i--)
+	{
+		StartupChunk startupChunk = remainingChunks[i];
+		glm::vec3 position = startupChunk.chunk->GetTransformComponent()->GetTranslation();
+		uint32_t chunkVersion = startupChunk.chunk->GetVersion();
+
+		jobSystem_->Schedule([this, sharedColumns, startupChunk, position, chunkVersion]() {
+			const ChunkColumn& column = (*sharedColumns)[startupChunk.columnIndex];
+			PushChunkResult(GenerateChunkResult(startupChunk.chunk, chunkVersion, position, column.biome, column.noise));
+		}, &startupCounter_);
+	}
+
 	lastKnownPlayerPos_ = currentPlayerPos;
 }
 
+World::~World()
+{
+	// The startup chunks are still being generated if the game closed straight
+	// away. Their results are thrown away, so jobs waiting for space can finish.
+	while (!startupCounter_.IsDone() || !streamingCounter_.IsDone())
+	{
+		ChunkResult result;
+		while (completedChunks_->TryPop(result))
+		{
+		}
+
+		std::this_thread::yield();
+	}
+	delete jobSystem_;
+	delete completedChunks_;
+	delete uploadScheduler_;
+	delete reclaimer_;
+	delete chunkRenderer_;
+	delete chunkQuadtree_;
+	delete visibilityGraph_;
+	delete occlusionCuller_;
+
+	// Waits for the last snapshots and edits to be written
+	delete autosave_;
+	delete editJournal_;
+	delete chunkStore_;
+}
+
+int World::LoadOrCreateSeed()
+{
+	std::string seedPath = saveDirectory_ + "/seed";
+
+	std::vector<uint8_t> seedData = std::vector<uint8_t>();
+	if (FileUtils::ReadFile(seedPath, seedData))
+	{
+		std::string seedString = std::string(seedData.begin(), seedData.end());
+
+		int seed = 0;
+		if (sscanf(seedString.c_str(), "%d", &seed) == 1)
+		{
+			return seed;
+		}
+
+		LOG("Couldn't read the seed from %s, creating a new one\n", seedPath.c_str());
+	}
+
+	srand(time(NULL));
+	int seed = rand();
+
+	std::string seedString = std::to_string(seed);
+	if (!FileUtils::WriteFileDurably(seedPath, std::vector<uint8_t>(seedString.begin(), seedString.end())))
+	{
+		LOG("Couldn't save the seed to %s\n", seedPath.c_str());
+	}
+
+	return seed;
+}
+
 void World::Update(glm::vec3 currentPlayerPos)
 {
+	// The start of the frame, so no chunk is part way through an edit
+	autosave_->Update(chunks_);
+
+	// Checked before draining, so once the jobs are done every
+	// result they pushed gets swapped in below
+	bool hasGeneratedStartupChunks = startupCounter_.IsDone();
+	bool hasFinishedStreaming = streamingCounter_.IsDone();
+
+	ApplyCompletedChunks();
+
+	// Frees the states that the last frames' edits and results swapped out
+	reclaimer_->Collect();
+
+	// The startup chunks are being generated on other threads, so
+	// don't start moving chunks around until they've all been done.
+	if (!hasFinishedStartup_)
+	{
+		if (!hasGeneratedStartupChunks)
+		{
+			return;
+		}
+
+		hasFinishedStartup_ = true;
+		timeToFullRenderDistance_ = glfwGetTime() - startupStartTime_;
+		LOG("Time to full render distance: %fms\n", timeToFullRenderDistance_ * 1000);
+
+		// Every startup chunk has had its edits applied now, so saving them lets the journal shrink
+		autosave_->RequestSave();
+	}
+
 	int oldZ = World::FindClosestPosition(lastKnownPlayerPos_.z, 16);
 	int oldX = World::FindClosestPosition(lastKnownPlayerPos_.x, 16);
 	int newZ = World::FindClosestPosition(currentPlayerPos.z, 16);
 	int newX = World::FindClosestPosition(currentPlayerPos.x, 16);
 
-	if ((oldZ != newZ || oldX != newX) && worldWorker_->AreAnyThreadsAvailable())
+	// Only one load at a time, the load itself is spread over the job system
+	if ((oldZ != newZ || oldX != newX) && hasFinishedStreaming)
 	{
 		// Load the new chunks asynchronously
 		int startZ = newZ - (int)(16 * glm::floor(renderDistance_));
@@ -71,8 +333,8 @@ void World::Update(glm::vec3 currentPlayerPos)
 		int endX = newX + (int)(16 * glm::floor(renderDistance_));
 
 		// Unload all chunks outside the bounds set just above
-		std::vector<Chunk*> unloadedChunks = std::vector<Chunk*>();
-		std::vector<glm::vec3> loadedChunkPositions = std::vector<glm::vec3>();
+		std::vector<StreamingChunk> unloadedChunks = std::vector<StreamingChunk>();
+		std::vector<StreamingChunk> loadedChunks = std::vector<StreamingChunk>();
 		for (Chunk* chunk : chunks_)
 		{
 			TransformComponent* transformComponent = static_cast<TransformComponent*>(chunk->GetComponentByName("transform"));
@@ -87,20 +349,377 @@ void World::Update(glm::vec3 currentPlayerPos)
 				chunk->Unload();
 
 				// Add to unloaded chunks list
-				unloadedChunks.push_back(chunk);
+				unloadedChunks.push_back({ chunk, chunk->GetVersion(), chunkLoc, chunk->GetBiome(), ChunkBlocks() });
 			}
 			else
 			{
-				loadedChunkPositions.push_back(chunkLoc);
+				// The jobs add the new trees to a copy-on-write snapshot, the live blocks aren't touched
+				loadedChunks.push_back({ chunk, chunk->GetVersion(), chunkLoc, chunk->GetBiome(), chunk->GetBlocksSnapshot() });
 			}
 		}
 
-		worldWorker_->QueueFunction({ &World::LoadNewChunksAsync, this, startX, endX, startZ, endZ, loadedChunkPositions, unloadedChunks });
+		jobSystem_->Schedule([this, startX, endX, startZ, endZ, loadedChunks = std::move(loadedChunks), unloadedChunks = std::move(unloadedChunks)]() mutable {
+			LoadNewChunksAsync(startX, endX, startZ, endZ, std::move(loadedChunks), std::move(unloadedChunks));
+		}, &streamingCounter_);
 	}
 
 	lastKnownPlayerPos_ = currentPlayerPos;
 }
 
+void World::MarkFrameDrawn()
+{
+	if (!hasDrawnFirstFrame_)
+	{
+		hasDrawnFirstFrame_ = true;
+		timeToFirstFrame_ = glfwGetTime() - startupStartTime_;
+		LOG("Time to first frame: %fms\n", timeToFirstFrame_ * 1000);
+	}
+}
+
+WorldStartupStats World::GetStartupStats()
+{
+	return { timeToFirstFrame_, timeToFullRenderDistance_, hasFinishedStartup_ };
+}
+
+bool World::RunStreamingBenchmark(int seed, int renderDistance)
+{
+	const int numIterations = 5;
+
+	const Biome biomes[] = { Biome::Snow, Biome::Grassland, Biome::Forest, Biome::Desert };
+
+	Terrain terrain = Terrain(seed);
+
+	std::vector<int> threadCounts = std::vector<int>();
+	int maxThreads = glm::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+	{
+		threadCounts.push_back(numThreads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	int numColumns = (renderDistance * 2 + 1) * (renderDistance * 2 + 1);
+	int numChunks = numColumns * (MAX_CHUNK_Y - MIN_CHUNK_Y + 1);
+
+	double singleThreadSeconds = 0.0;
+	std::vector<uint64_t> expectedChunkHashes = std::vector<uint64_t>();
+	bool didMatch = true;
+
+	for (int numThreads : threadCounts)
+	{
+		JobSystem jobSystem = JobSystem(numThreads);
+
+		// A hash of every chunk's blocks, by where the chunk is rather than
+		// when it finished, to check every thread count generates the same world
+		std::vector<uint64_t> chunkHashes = std::vector<uint64_t>(numChunks);
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (int iteration = 0; iteration < numIterations; iteration++)
+		{
+			JobCounter counter = JobCounter();
+
+			// A job per column generates the noise, which then schedules
+			// a child job per chunk to generate the blocks and mesh
+			for (int i = 0; i < numColumns; i++)
+			{
+				jobSystem.Schedule([&, i]() {
+					int x = (i % (renderDistance * 2 + 1)) - renderDistance;
+					int z = (i / (renderDistance * 2 + 1)) - renderDistance;
+
+					std::shared_ptr<std::vector<float>> noise = std::make_shared<std::vector<float>>(terrain.GetElevationNoiseForChunk(x * CHUNK_SIZE, z * CHUNK_SIZE));
+					Biome biome = biomes[(x * 31 + z * 17 + seed) & 3];
+
+					for (int y = MIN_CHUNK_Y; y <= MAX_CHUNK_Y; y++)
+					{
+						jobSystem.Schedule([&, noise, biome, i, x, y, z]() {
+							std::vector<uint8_t> blockData = Chunk::GenerateBlocksFromNoise(biome, *noise, glm::vec3(x * CHUNK_SIZE, y * CHUNK_SIZE, z * CHUNK_SIZE), CHUNK_SIZE, MIN_CHUNK_Y, MAX_CHUNK_Y);
+
+							// FNV-1a
+							uint64_t hash = 14695981039346656037ull;
+							for (uint8_t block : blockData)
+							{
+								hash = (hash ^ block) * 1099511628211ull;
+							}
+							chunkHashes[i * (MAX_CHUNK_Y - MIN_CHUNK_Y + 1) + y - MIN_CHUNK_Y] = hash;
+
+							// Same number of columns as the texture atlas
+							std::vector<Vertex> vertices = std::vector<Vertex>();
+							std::vector<unsigned int> indices = std::vector<unsigned int>();
+							PassIndexCounts passIndexCounts = PassIndexCounts();
+							Chunk::GenerateMeshData(ChunkBlocks(CHUNK_SIZE, blockData), 6, vertices, indices, passIndexCounts);
+						}, &counter);
+					}
+				}, &counter);
+			}
+
+			jobSystem.Wait(&counter);
+		}
+		auto endTime = std::chrono::steady_clock::now();
+
+		double seconds = std::chrono::duration<double>(endTime - startTime).count();
+		if (numThreads == 1)
+		{
+			singleThreadSeconds = seconds;
+			expectedChunkHashes = chunkHashes;
+		}
+		else if (chunkHashes != expectedChunkHashes)
+		{
+			printf("%d threads generated different blocks to 1 thread\n", numThreads);
+			didMatch = false;
+		}
+
+		JobSystemStats stats = jobSystem.GetStats();
+		printf("%d threads: %.1f chunks/s, %.2fx speedup, %llu jobs, %llu stolen\n",
+			numThreads,
+			static_cast<double>(numChunks) * numIterations / seconds,
+			singleThreadSeconds / seconds,
+			static_cast<unsigned long long>(stats.numJobsRun),
+			static_cast<unsigned long long>(stats.numJobsStolen));
+	}
+
+	return didMatch;
+}
+
+bool World::RunFrameBenchmark(int renderDistance, int numFrames)
+{
+	// Only for glfwGetTime, the null platform doesn't open anything
+	glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+	if (!glfwInit())
+	{
+		printf("Failed to initialise GLFW\n");
+		return false;
+	}
+
+	NullRenderDevice* device = new NullRenderDevice();
+	RenderDevice::Set(device);
+
+	// Same camera as the game
+	const float fov = 60.0f;
+	const float aspectRatio = 16.0f / 9.0f;
+	const float zNear = 0.1f;
+	const float zFar = 400.0f;
+	const float speed = 0.5f; // blocks per frame, so chunks keep streaming in
+	glm::mat4 perspective = glm::perspective(glm::radians(fov), aspectRatio, zNear, zFar);
+	glm::vec3 forward = glm::vec3(1.0f, 0.0f, 0.0f);
+	glm::vec3 right = glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+
+	Mesh::CreateCommonData(MeshType::Chunk);
+	MeshTypeCommonData chunkCommonData = Mesh::GetCommonData(MeshType::Chunk);
+	chunkCommonData.projection = perspective;
+	Mesh::SetCommonData(MeshType::Chunk, chunkCommonData);
+
+	glm::vec3 cameraPos = glm::vec3(0.0f, 48.0f, 0.0f);
+	World* world = new World(cameraPos, renderDistance);
+
+	double totalSeconds = 0.0;
+	double longestSeconds = 0.0;
+	RenderDeviceStats totalStats = RenderDeviceStats();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+
+		world->Update(cameraPos);
+
+		glm::mat4 view = glm::lookAt(cameraPos, cameraPos + forward, up);
+		Frustum frustum = CreateFrustum(cameraPos, forward, right, up, fov, aspectRatio, zNear, zFar);
+		world->FrustumCullChunks(frustum);
+		world->VisibilityCullChunks(cameraPos);
+		world->OcclusionCullChunks(perspective * view, cameraPos);
+
+		chunkCommonData = Mesh::GetCommonData(MeshType::Chunk);
+		chunkCommonData.view = view;
+		chunkCommonData.viewPos = cameraPos;
+		Mesh::SetCommonData(MeshType::Chunk, chunkCommonData);
+
+		device->Clear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+		world->UploadChunkMeshes(cameraPos);
+		Mesh::StartDrawBatch(MeshType::Chunk);
+		world->DrawChunks(cameraPos);
+		Mesh::EndDrawBatch();
+
+		world->MarkFrameDrawn();
+		device->EndFrame();
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		totalSeconds += seconds;
+		longestSeconds = glm::max(longestSeconds, seconds);
+
+		RenderDeviceStats stats = device->GetStats();
+		totalStats.numDrawCalls += stats.numDrawCalls;
+		totalStats.numDraws += stats.numDraws;
+		totalStats.numStateChanges += stats.numStateChanges;
+		totalStats.numUploadBytes += stats.numUploadBytes;
+		totalStats.numCopyBytes += stats.numCopyBytes;
+
+		cameraPos += forward * speed;
+	}
+
+	NullRenderDeviceObjects objects = device->GetObjects();
+	printf("%d frames at render distance %d: %.3fms avg, %.3fms longest\n",
+		numFrames, renderDistance, totalSeconds * 1000.0 / numFrames, longestSeconds * 1000.0);
+	printf("Per frame: %.1f draw calls (%.1f draws), %.1f state changes, %.1fKB uploaded, %.1fKB copied\n",
+		static_cast<double>(totalStats.numDrawCalls) / numFrames,
+		static_cast<double>(totalStats.numDraws) / numFrames,
+		static_cast<double>(totalStats.numStateChanges) / numFrames,
+		totalStats.numUploadBytes / 1024.0 / numFrames,
+		totalStats.numCopyBytes / 1024.0 / numFrames);
+	printf("Holding %d buffers (%.1fMB), %d vertex arrays, %d textures, %d programs\n",
+		objects.numBuffers, objects.bufferBytes / (1024.0 * 1024.0), objects.numVertexArrays, objects.numTextures, objects.numPrograms);
+
+	delete world;
+	RenderDevice::Set(nullptr);
+	delete device;
+	glfwTerminate();
+
+	if (totalStats.numDraws == 0)
+	{
+		printf("Nothing was drawn\n");
+		return false;
+	}
+
+	return true;
+}
+
+bool World::RunCollisionBenchmark(int seed, int renderDistance)
+{
+	const int numQueries = 200000;
+
+	const Biome biomes[] = { Biome::Snow, Biome::Grassland, Biome::Forest, Biome::Desert };
+
+	Terrain terrain = Terrain(seed);
+	std::vector<ChunkState> states = std::vector<ChunkState>();
+	std::unordered_map<ChunkKey, int, ChunkKeyHash> statesByKey = std::unordered_map<ChunkKey, int, ChunkKeyHash>();
+	for (int z = -renderDistance; z <= renderDistance; z++)
+	{
+		for (int x = -renderDistance; x <= renderDistance; x++)
+		{
+			std::vector<float> noise = terrain.GetElevationNoiseForChunk(x * CHUNK_SIZE, z * CHUNK_SIZE);
+			Biome biome = biomes[(x * 31 + z * 17 + seed) & 3];
+
+			for (int y = MIN_CHUNK_Y; y <= MAX_CHUNK_Y; y++)
+			{
+				ChunkState state{};
+				state.position = glm::vec3(x * CHUNK_SIZE, y * CHUNK_SIZE, z * CHUNK_SIZE);
+				state.biome = biome;
+				state.blocks = ChunkBlocks(CHUNK_SIZE, Chunk::GenerateBlocksFromNoise(biome, noise, state.position, CHUNK_SIZE, MIN_CHUNK_Y, MAX_CHUNK_Y));
+				statesByKey[{ x, y, z }] = static_cast<int>(states.size());
+				states.push_back(state);
+			}
+		}
+	}
+
+	// What the chunks used to keep, a box per solid block
+	std::vector<std::vector<CollisionDetection::CollisionBox>> chunkBoxes = std::vector<std::vector<CollisionDetection::CollisionBox>>();
+	size_t boxBytes = 0;
+	for (const ChunkState& state : states)
+	{
+		std::vector<CollisionDetection::CollisionBox> boxes = std::vector<CollisionDetection::CollisionBox>();
+		glm::vec3 pos = state.position - glm::vec3(CHUNK_SIZE / 2);
+		for (int z = 0; z < CHUNK_SIZE; z++)
+		{
+			for (int x = 0; x < CHUNK_SIZE; x++)
+			{
+				for (int y = 0; y < CHUNK_SIZE; y++)
+				{
+					if (state.blocks.Get(x, y, z) != BLOCK_TYPE_AIR)
+					{
+						boxes.push_back({ glm::vec3(x + pos.x, y + pos.y, z + pos.z), glm::vec3(1.0f, 1.0f, 1.0f) });
+					}
+				}
+			}
+		}
+		boxBytes += boxes.capacity() * sizeof(CollisionDetection::CollisionBox);
+		chunkBoxes.push_back(boxes);
+	}
+
+	// Player sized boxes around the surface, where the player would be
+	std::mt19937 rng = std::mt19937(seed);
+	std::uniform_real_distribution<float> horizontal = std::uniform_real_distribution<float>(-renderDistance * CHUNK_SIZE, renderDistance * CHUNK_SIZE);
+	std::uniform_real_distribution<float> vertical = std::uniform_real_distribution<float>(MIN_CHUNK_Y * CHUNK_SIZE, (MAX_CHUNK_Y + 1) * CHUNK_SIZE);
+	std::vector<CollisionDetection::CollisionBox> queries = std::vector<CollisionDetection::CollisionBox>(numQueries);
+	for (CollisionDetection::CollisionBox& query : queries)
+	{
+		query = { glm::vec3(horizontal(rng), vertical(rng), horizontal(rng)), glm::vec3(0.5f, 1.9f, 0.5f) };
+	}
+
+	// The old way, the boxes of every chunk near the query. The old area was
+	// a little too small to catch blocks on the far side of a chunk border.
+	std::vector<uint8_t> boxHits = std::vector<uint8_t>(numQueries);
+	auto boxStartTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < numQueries; i++)
+	{
+		CollisionDetection::CollisionBox area = { queries[i].origin, queries[i].size + glm::vec3(18.0f, 18.0f, 18.0f) };
+		for (size_t j = 0; j < states.size() && !boxHits[i]; j++)
+		{
+			if (!CollisionDetection::isOverlapping({ states[j].position, glm::vec3(0.5f, 0.5f, 0.5f) }, area))
+			{
+				continue;
+			}
+
+			for (const CollisionDetection::CollisionBox& box : chunkBoxes[j])
+			{
+				if (CollisionDetection::isOverlapping(box, queries[i]))
+				{
+					boxHits[i] = 1;
+					break;
+				}
+			}
+		}
+	}
+	double boxSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - boxStartTime).count();
+
+	// The new way, only the cells the query touches, same as IsCollidingWithWorld
+	std::vector<uint8_t> blockHits = std::vector<uint8_t>(numQueries);
+	auto blockStartTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < numQueries; i++)
+	{
+		glm::ivec3 minBlock;
+		glm::ivec3 maxBlock;
+		GetBlocksInsideBox(queries[i], minBlock, maxBlock);
+		ChunkKey minKey = Chunk::GetKey(glm::vec3(minBlock) + glm::vec3(8.0f), CHUNK_SIZE);
+		ChunkKey maxKey = Chunk::GetKey(glm::vec3(maxBlock) + glm::vec3(8.0f), CHUNK_SIZE);
+
+		for (int z = minKey.z; z <= maxKey.z && !blockHits[i]; z++)
+		{
+			for (int x = minKey.x; x <= maxKey.x && !blockHits[i]; x++)
+			{
+				for (int y = minKey.y; y <= maxKey.y && !blockHits[i]; y++)
+				{
+					auto it = statesByKey.find({ x, y, z });
+					glm::ivec3 block;
+					if (it != statesByKey.end() && Chunk::FindSolidBlock(states[it->second], minBlock, maxBlock, block))
+					{
+						blockHits[i] = 1;
+					}
+				}
+			}
+		}
+	}
+	double blockSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStartTime).count();
+
+	int numHits = 0;
+	int numMismatches = 0;
+	for (int i = 0; i < numQueries; i++)
+	{
+		numHits += blockHits[i];
+		numMismatches += blockHits[i] != boxHits[i];
+	}
+
+	printf("%d queries over %zu chunks, %d hits\n", numQueries, states.size(), numHits);
+	printf("Collision boxes: %.3fus per query, %.1fKB per chunk\n",
+		boxSeconds * 1000000.0 / numQueries, boxBytes / 1024.0 / states.size());
+	printf("Voxel grid: %.3fus per query, %.2fx speedup, no extra memory\n",
+		blockSeconds * 1000000.0 / numQueries, boxSeconds / blockSeconds);
+
+	if (numMismatches > 0)
+	{
+		printf("%d queries hit differently\n", numMismatches);
+		return false;
+	}
+
+	return true;
+}
+
 std::vector<Chunk*> World::GetWorld()
 {
 	return chunks_;
@@ -121,14 +740,14 @@ int World::FindClosestPosition(int val, int multiple)
 	return option2;
 }
 
-bool World::LoadNewChunksAsync(int startX, int endX, int startZ, int endZ, std::vector<glm::vec3> loadedChunkPositions, std::vector<Chunk*> chunkIndexes)
+bool World::LoadNewChunksAsync(int startX, int endX, int startZ, int endZ, std::vector<StreamingChunk> loadedChunks, std::vector<StreamingChunk> unloadedChunks)
 {
 	TreeLeavePositions.clear();
 	TreeTrunkPositions.clear();
 
 	float createNoiseStartTime = glfwGetTime();
 	std::vector<glm::vec3> positionsToLoad = std::vector<glm::vec3>();
-	std::vector<ChunkNoiseSection> chunkNoiseSections = std::vector<ChunkNoiseSection>();
+	std::vector<ChunkColumn> columns = std::vector<ChunkColumn>();
 
 	int zIncrement = 16;
 	if (endZ < startZ)
@@ -146,90 +765,91 @@ bool World::LoadNewChunksAsync(int startX, int endX, int startZ, int endZ, std::
 	{
 		for (int x = startX; x <= endX; x += xIncrement)
 		{
-			float temperature = 0.0f;
-			temperatureNoise_->GenUniformGrid2D(&temperature, x / 16.0f, z / 16.0f, 1, 1, 0.05f, seed_);
-			Biome biome = GetBiomeFromTemperature(temperature);
+			ChunkColumn column{};
+			column.x = x;
+			column.z = z;
+			columns.push_back(column);
+		}
+	}
+
+	// Every column's trees are needed, even the loaded ones, since trees can
+	// cross into the neighbouring chunks
+	jobSystem_->ParallelFor(columns.size(), [this, &columns](int i) {
+		ChunkColumn& column = columns[i];
 
-			std::vector<float> chunkNoiseSection = GetNoiseForChunkSection(x, z, 16);
-			SetTreeBlocksForChunk(biome, x, z, yMin, yMax, chunkNoiseSection, 16);
+		float temperature = 0.0f;
+		temperatureNoise_->GenUniformGrid2D(&temperature, column.x / 16.0f, column.z / 16.0f, 1, 1, 0.05f, seed_);
+		column.biome = GetBiomeFromTemperature(temperature);
 
-			bool shouldAddNoise = true;
-			for (glm::vec3 loadedChunkPos : loadedChunkPositions)
+		column.noise = GetNoiseForChunkSection(column.x, column.z, 16);
+		SetTreeBlocksForChunk(column.biome, column.x, column.z, yMin, yMax, column.noise, 16);
+	});
+
+	for (const ChunkColumn& column : columns)
+	{
+		for (int y = yMin; y <= yMax; y++) {
+			bool shouldAddPosition = true;
+			for (const StreamingChunk& loadedChunk : loadedChunks)
 			{
+				glm::vec3 loadedChunkPos = loadedChunk.position;
 				int loadedChunkZ = static_cast<int>(loadedChunkPos.z);
 				int loadedChunkX = static_cast<int>(loadedChunkPos.x);
+				int loadedChunkY = static_cast<int>(loadedChunkPos.y);
 
-				if (loadedChunkX == x && loadedChunkZ == z)
+				if (loadedChunkX == column.x && loadedChunkZ == column.z && loadedChunkY == (y * 16))
 				{
-					shouldAddNoise = false;
+					shouldAddPosition = false;
 				}
 			}
 
-			for (int y = yMin; y <= yMax; y++) {
-				bool shouldAddPosition = true;
-				for (glm::vec3 loadedChunkPos : loadedChunkPositions)
-				{
-					int loadedChunkZ = static_cast<int>(loadedChunkPos.z);
-					int loadedChunkX = static_cast<int>(loadedChunkPos.x);
-					int loadedChunkY = static_cast<int>(loadedChunkPos.y);
-
-					if (loadedChunkX == x && loadedChunkZ == z && loadedChunkY == (y * 16))
-					{
-						shouldAddPosition = false;
-					}
-				}
-
-				if (shouldAddPosition)
-				{
-					positionsToLoad.push_back(glm::vec3(x, y * 16, z));
-				}
-			}
-
-			if (shouldAddNoise) {
-				chunkNoiseSections.push_back({ glm::vec3(x, 0, z), chunkNoiseSection });
+			if (shouldAddPosition)
+			{
+				positionsToLoad.push_back(glm::vec3(column.x, y * 16, column.z));
 			}
 		}
 	}
 
-	for (Chunk* chunk : chunks_)
-	{
-		if (!chunk->IsUnloaded())
+	jobSystem_->ParallelFor(loadedChunks.size(), [this, &loadedChunks](int i) {
+		StreamingChunk& loadedChunk = loadedChunks[i];
+
+		// If any blocks were updated then the chunk mesh
+		// needs to be regenerated.
+		if (Chunk::ApplyTreeBlocks(loadedChunk.blocks, loadedChunk.position, TreeTrunkPositions, TreeLeavePositions))
 		{
-			// If any blocks were updated then the chunk mesh
-			// needs to be regenerated.
-			if (chunk->UpdateBlocks()) {
-				chunk->GenerateMesh(false);
-			}
+			ChunkResult result{};
+			result.chunk = loadedChunk.chunk;
+			result.chunkVersion = loadedChunk.chunkVersion;
+			result.isRecreated = false;
+			result.state = std::make_unique<ChunkState>();
+			result.state->position = loadedChunk.position;
+			result.state->biome = loadedChunk.biome;
+			result.state->blocks = std::move(loadedChunk.blocks);
+		
+			FinishChunkResult(result);
+			PushChunkResult(std::move(result));
 		}
-	}
+	});
 
 	float createNoiseEndTime = glfwGetTime();
 	LOG("Create Noise Time: %fms\n", (createNoiseEndTime - createNoiseStartTime) * 1000);
 
 	float recreateChunksStartTime = glfwGetTime();
-	for (int i = 0; i < chunkIndexes.size(); i++)
-	{
-		if (positionsToLoad.size() > 0) {
-			glm::vec3 newPosition = positionsToLoad.at(0);
-			positionsToLoad.erase(positionsToLoad.begin());
-
-			int chunkNoiseSectionInd = 0;
+	int numChunksToRecreate = static_cast<int>(std::min(unloadedChunks.size(), positionsToLoad.size()));
+	jobSystem_->ParallelFor(numChunksToRecreate, [&](int i) {
+		glm::vec3 newPosition = positionsToLoad[i];
 
-			for (int i=0; i < chunkNoiseSections.size(); i++)
+		const ChunkColumn* newColumn = &columns[0];
+		for (const ChunkColumn& column : columns)
+		{
+			if (column.x == newPosition.x && column.z == newPosition.z)
 			{
-				ChunkNoiseSection& chunkNoiseSection = chunkNoiseSections.at(i);
-
-				if (chunkNoiseSection.position.x == newPosition.x && chunkNoiseSection.position.z == newPosition.z)
-				{
-					chunkNoiseSectionInd = i;
-				}
+				newColumn = &column;
 			}
-
-			float temperature = 0.0f;
-			temperatureNoise_->GenUniformGrid2D(&temperature, newPosition.x/16.0f, newPosition.z/16.0f, 1, 1, 0.05f, seed_);
-			chunkIndexes[i]->Recreate(GetBiomeFromTemperature(temperature), chunkNoiseSections.at(chunkNoiseSectionInd).noise, yMin, yMax, newPosition, seed_, false);
 		}
-	}
+
+		const StreamingChunk& unloadedChunk = unloadedChunks[i];
+		PushChunkResult(GenerateChunkResult(unloadedChunk.chunk, unloadedChunk.chunkVersion, newPosition, newColumn->biome, newColumn->noise));
+	});
 	float recreateChunksEndTime = glfwGetTime();
 	LOG("Recreate Chunks Time: %fms\n", (recreateChunksEndTime - recreateChunksStartTime) * 1000);
 
@@ -267,10 +887,12 @@ Biome World::GetBiomeFromTemperature(float temperature)
 
 void World::SetTreeBlocksForChunk(Biome biome, int x, int z, int minY, int maxY, std::vector<float>& chunkSectionNoise, int size)
 {
+	// A generator per chunk section (rather than rand) so sections
+	// can have their trees placed on different threads at once.
 	int chunkSectionSeed = seed_ + x + z;
-	srand(chunkSectionSeed);
+	std::mt19937 random = std::mt19937(chunkSectionSeed);
 
-	int numTrees = rand() % int(size / 2) + 2;
+	int numTrees = random() % int(size / 2) + 2;
 
 	int lastTreeZ = -1;
 	int lastTreeX = -1;
@@ -292,11 +914,11 @@ void World::SetTreeBlocksForChunk(Biome biome, int x, int z, int minY, int maxY,
 			int treeHeight = 0;
 
 			if (glm::abs(currentX - lastTreeX) >= 3 && glm::abs(currentZ - lastTreeZ) >= 3 && biome == Biome::Forest) {
-				int spawnProbability = rand() % 100;
+				int spawnProbability = random() % 100;
 
 				if (spawnProbability > 20 && numTrees > 0)
 				{
-					treeHeight = rand() % maxTreeHeight + minTreeHeight;
+					treeHeight = random() % maxTreeHeight + minTreeHeight;
 					lastTreeZ = currentZ;
 					lastTreeX = currentX;
 
@@ -323,63 +945,225 @@ void World::SetTreeBlocksForChunk(Biome biome, int x, int z, int minY, int maxY,
 		}
 	}
 
+	std::lock_guard<std::mutex> lock(generatingNoiseMutex_);
 	TreeTrunkPositions.insert(TreeTrunkPositions.end(), treeTrunkPositions.begin(), treeTrunkPositions.end());
 	TreeLeavePositions.insert(TreeLeavePositions.end(), treeLeavePositions.begin(), treeLeavePositions.end());
 }
 
 void World::FrustumCullChunks(const Frustum& frustum)
 {
+	// Chunks only move when a streamed in result is applied
+	if (haveChunksMoved_)
+	{
+		std::vector<AABB> chunkBounds = std::vector<AABB>(chunks_.size());
+		for (size_t i = 0; i < chunks_.size(); i++)
+		{
+			chunkBounds[i].origin = glm::vec3(chunks_[i]->GetOrigin());
+			chunkBounds[i].size = glm::vec3(chunks_[i]->GetSize() / 2.0f);
+		}
+
+		chunkQuadtree_->Build(chunkBounds);
+		haveChunksMoved_ = false;
+	}
+
+	chunkQuadtree_->Cull(frustum, visibleChunks_);
+}
+
+ChunkQuadtreeStats World::GetQuadtreeStats()
+{
+	return chunkQuadtree_->GetStats();
+}
+
+const std::vector<int>& World::GetVisibleChunks()
+{
+	return visibleChunks_;
+}
+
+void World::VisibilityCullChunks(glm::vec3 cameraPos)
+{
+	double startTime = glfwGetTime();
+
+	// The graph covers every loaded chunk, chunks it doesn't have are treated as open
+	glm::ivec3 min = glm::ivec3(INT_MAX, INT_MAX, INT_MAX);
+	glm::ivec3 max = glm::ivec3(INT_MIN, INT_MIN, INT_MIN);
 	for (Chunk* chunk : chunks_)
 	{
-		AABB chunkAabb{};
-		chunkAabb.origin = chunk->GetTransformComponent()->GetTranslation();
-		chunkAabb.size = glm::vec3(8.0f, 8.0f, 8.0f);
+		if (!chunk->IsUnloaded())
+		{
+			ChunkKey key = Chunk::GetKey(glm::vec3(chunk->GetOrigin()), 16);
+			min = glm::ivec3(glm::min(min.x, key.x), glm::min(min.y, key.y), glm::min(min.z, key.z));
+			max = glm::ivec3(glm::max(max.x, key.x), glm::max(max.y, key.y), glm::max(max.z, key.z));
+		}
+	}
+
+	numUnreachableChunks_ = 0;
+	if (min.x > max.x)
+	{
+		visibilityCullTime_ = glfwGetTime() - startTime;
+		return;
+	}
 
-		if (IsBoundingBoxInsideFrustum(frustum, chunkAabb))
+	visibilityGraph_->Reset(min, max);
+	for (Chunk* chunk : chunks_)
+	{
+		if (!chunk->IsUnloaded())
 		{
-			chunk->SetShouldDraw(true);
+			ChunkKey key = Chunk::GetKey(glm::vec3(chunk->GetOrigin()), 16);
+			visibilityGraph_->SetChunk(glm::ivec3(key.x, key.y, key.z), chunk->GetState()->faceConnections);
 		}
-		else
+	}
+
+	// Chunks are centred on their position. Above or below the world, start from the nearest layer of chunks.
+	ChunkKey cameraKey = Chunk::GetKey(cameraPos + glm::vec3(8.0f), 16);
+	glm::ivec3 cameraChunk = glm::ivec3(cameraKey.x, glm::clamp(cameraKey.y, min.y, max.y), cameraKey.z);
+	if (visibilityGraph_->Search(cameraChunk))
+	{
+		// Unloaded chunks aren't drawn anyway, so they're kept rather than counted
+		size_t numVisible = 0;
+		for (int index : visibleChunks_)
 		{
-			chunk->SetShouldDraw(false);
+			Chunk* chunk = chunks_[index];
+			ChunkKey key = Chunk::GetKey(glm::vec3(chunk->GetOrigin()), 16);
+			if (chunk->IsUnloaded() || visibilityGraph_->IsReachable(glm::ivec3(key.x, key.y, key.z)))
+			{
+				visibleChunks_[numVisible++] = index;
+			}
 		}
+
+		numUnreachableChunks_ = visibleChunks_.size() - numVisible;
+		visibleChunks_.resize(numVisible);
 	}
+
+	visibilityCullTime_ = glfwGetTime() - startTime;
 }
 
-int World::NumChunksCulled()
+int World::GetNumUnreachableChunks()
 {
-	int numChunksCulled = 0;
-	for (Chunk* chunk : chunks_)
+	return numUnreachableChunks_;
+}
+
+double World::GetVisibilityCullTime()
+{
+	return visibilityCullTime_;
+}
+
+void World::OcclusionCullChunks(const glm::mat4& viewProjection, glm::vec3 cameraPos)
+{
+	assert(IsMainThread());
+
+	double startTime = glfwGetTime();
+	occlusionCuller_->BeginFrame(viewProjection);
+
+	std::vector<std::pair<float, Chunk*>> chunksByDistance = std::vector<std::pair<float, Chunk*>>();
+	for (int index : visibleChunks_)
 	{
-		if (!chunk->GetShouldDraw())
+		Chunk* chunk = chunks_[index];
+		if (!chunk->IsUnloaded())
 		{
-			numChunksCulled++;
+			glm::vec3 offset = glm::vec3(chunk->GetOrigin()) - cameraPos;
+			chunksByDistance.push_back({ glm::dot(offset, offset), chunk });
 		}
 	}
-	return numChunksCulled;
+
+	// The nearest chunks cover the most of the screen, so only they're drawn as occluders
+	size_t numOccluderChunks = std::min(chunksByDistance.size(), static_cast<size_t>(maxOccluderChunks_));
+	std::partial_sort(chunksByDistance.begin(), chunksByDistance.begin() + numOccluderChunks, chunksByDistance.end());
+
+	for (size_t i = 0; i < numOccluderChunks; i++)
+	{
+		Chunk* chunk = chunksByDistance[i].second;
+
+		// This is the main thread, the only one that publishes, so the state can't be retired while it's read here
+		const ChunkState* state = chunk->GetState();
+		glm::vec3 corner = glm::vec3(chunk->GetOrigin()) - glm::vec3(8.0f);
+		for (const OccluderBox& box : state->occluders)
+		{
+			occlusionCuller_->AddOccluder(corner + glm::vec3(box.minX, box.minY, box.minZ), corner + glm::vec3(box.maxX, box.maxY, box.maxZ));
+		}
+	}
+
+	occlusionCuller_->BuildPyramid();
+
+	// Whole groups of columns can be hidden at once, then the visible chunks are the ones that weren't
+	chunkQuadtree_->OcclusionCull(*occlusionCuller_, isChunkOccluded_);
+
+	size_t numVisible = 0;
+	for (int index : visibleChunks_)
+	{
+		if (!isChunkOccluded_[index])
+		{
+			visibleChunks_[numVisible++] = index;
+		}
+	}
+	visibleChunks_.resize(numVisible);
+
+	haveOccludersChanged_ = false;
+	occlusionCullTime_ = glfwGetTime() - startTime;
 }
 
-bool World::IsCollidingWithWorld(CollisionDetection::CollisionBox collisionBox, CollisionDetection::CollisionBox& hitBoxOut) {
-	bool isColliding = false;
+bool World::HaveOccludersChanged()
+{
+	return haveOccludersChanged_;
+}
 
-	std::vector<Chunk*> chunksToCheck = GetChunksInsideArea(collisionBox.origin, collisionBox.size);
+OcclusionStats World::GetOcclusionStats()
+{
+	return occlusionCuller_->GetStats();
+}
+
+double World::GetOcclusionCullTime()
+{
+	return occlusionCullTime_;
+}
 
-	int numChunksChecked = 0;
-	for (Chunk* chunk : chunksToCheck)
+int World::NumChunksCulled()
+{
+	return chunks_.size() - visibleChunks_.size();
+}
+
+bool World::IsCollidingWithWorld(CollisionDetection::CollisionBox collisionBox, CollisionDetection::CollisionBox& hitBoxOut) {
+	assert(IsMainThread());
+
+	if (haveChunkKeysChanged_)
 	{
-		
-		for (CollisionDetection::CollisionBox& chunkCollisionbox : chunk->GetCollisionBoxes()) {
-			if (CollisionDetection::isOverlapping(chunkCollisionbox, collisionBox)) {
-				hitBoxOut = chunkCollisionbox;
-				isColliding = true;
-				break;
+		chunksByKey_.clear();
+		for (Chunk* chunk : chunks_)
+		{
+			if (!chunk->IsUnloaded())
+			{
+				chunksByKey_[Chunk::GetKey(glm::vec3(chunk->GetOrigin()), 16)] = chunk;
 			}
 		}
+		haveChunkKeysChanged_ = false;
+	}
+
+	glm::ivec3 minBlock;
+	glm::ivec3 maxBlock;
+	GetBlocksInsideBox(collisionBox, minBlock, maxBlock);
+
+	// Chunks are centred on their position, so their blocks go from 8 below it to 7 above
+	ChunkKey minKey = Chunk::GetKey(glm::vec3(minBlock) + glm::vec3(8.0f), 16);
+	ChunkKey maxKey = Chunk::GetKey(glm::vec3(maxBlock) + glm::vec3(8.0f), 16);
 
-		numChunksChecked++;
+	// Only the main thread publishes, so the states can't be retired while they're read here
+	for (int z = minKey.z; z <= maxKey.z; z++)
+	{
+		for (int x = minKey.x; x <= maxKey.x; x++)
+		{
+			for (int y = minKey.y; y <= maxKey.y; y++)
+			{
+				auto it = chunksByKey_.find({ x, y, z });
+				glm::ivec3 block;
+				if (it != chunksByKey_.end() && Chunk::FindSolidBlock(*it->second->GetState(), minBlock, maxBlock, block))
+				{
+					hitBoxOut = { glm::vec3(block), glm::vec3(1.0f, 1.0f, 1.0f) };
+					return true;
+				}
+			}
+		}
 	}
 
-	return isColliding;
+	return false;
 }
 
 std::vector<Chunk*> World::GetChunksInsideArea(glm::vec3 origin, glm::vec3 size)
@@ -433,6 +1217,7 @@ std::vector<Chunk*>& World::GetChunks()
 
 void World::PlaceBlock(glm::vec3 worldLocation, uint8_t blockType) {
     std::vector<Chunk*> chunks = GetChunksInsideArea(worldLocation, glm::vec3(1.0f, 1.0f, 1.0f));
+    RemoveUngeneratedChunks(chunks);
 
     if (chunks.empty())
         return;
@@ -452,11 +1237,14 @@ void World::PlaceBlock(glm::vec3 worldLocation, uint8_t blockType) {
         }
     }
 
-    nearestChunk->PlaceBlockAt(localBlockPos, blockType);
+    if (nearestChunk->PlaceBlockAt(localBlockPos, blockType)) {
+        RecordEdit(nearestChunk, localBlockPos, blockType);
+    }
 }
 
 void World::BreakBlock(glm::vec3 worldLocation) {
     std::vector<Chunk*> chunks = GetChunksInsideArea(worldLocation, glm::vec3(1.0f, 1.0f, 1.0f));
+    RemoveUngeneratedChunks(chunks);
 
     if (chunks.empty())
         return;
@@ -476,5 +1264,228 @@ void World::BreakBlock(glm::vec3 worldLocation) {
         }
     }
 
-    nearestChunk->RemoveBlockAt(localBlockPos);
+    if (nearestChunk->RemoveBlockAt(localBlockPos)) {
+        RecordEdit(nearestChunk, localBlockPos, BLOCK_TYPE_AIR);
+    }
+}
+
+void World::RecordEdit(Chunk* chunk, glm::vec3 localBlockPos, uint8_t blockType)
+{
+	EditRecord record{};
+	record.chunkKey = chunk->GetKey();
+	record.localIndex = static_cast<uint16_t>(Chunk::GetFillIndex(localBlockPos.x, localBlockPos.y, localBlockPos.z, 16));
+	record.blockType = blockType;
+
+	{
+		// Appending under the lock keeps the journal's queue in step with
+		// chunkEdits_, which compaction rewrites the journal from. It only
+		// queues the record, the journal's own thread writes it.
+		std::lock_guard<std::mutex> lock(chunkEditsMutex_);
+		chunkEdits_[record.chunkKey].push_back(record);
+		editJournal_->Append(record);
+	}
+
+	haveOccludersChanged_ = true;
+}
+
+bool World::LoadSavedBlocks(ChunkKey chunkKey, ChunkBlocks& blocks)
+{
+	std::vector<uint8_t> savedBlocks = std::vector<uint8_t>();
+	if (chunkStore_->Load(chunkKey, savedBlocks))
+	{
+		int size = blocks.GetSize();
+		if (savedBlocks.size() == static_cast<size_t>(size * size * size))
+		{
+			blocks = ChunkBlocks(size, savedBlocks);
+		}
+		else
+		{
+			LOG("Saved chunk has %zu blocks, expected %d\n", savedBlocks.size(), size * size * size);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(chunkEditsMutex_);
+	auto edits = chunkEdits_.find(chunkKey);
+	if (edits != chunkEdits_.end())
+	{
+		for (const EditRecord& record : edits->second)
+		{
+			if (!blocks.SetAtFillIndex(record.localIndex, record.blockType))
+			{
+				LOG("Block index %d is outside of the chunk\n", record.localIndex);
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+ChunkResult World::GenerateChunkResult(Chunk* chunk, uint32_t chunkVersion, glm::vec3 position, Biome biome, const std::vector<float>& chunkSectionNoise)
+{
+	const int size = CHUNK_SIZE;
+
+	ChunkResult result{};
+	result.chunk = chunk;
+	result.chunkVersion = chunkVersion;
+	result.isRecreated = true;
+	result.state = std::make_unique<ChunkState>();
+	result.state->position = position;
+	result.state->biome = biome;
+
+	ChunkBlocks& blocks = result.state->blocks;
+	blocks = ChunkBlocks(size, Chunk::GenerateBlocksFromNoise(biome, chunkSectionNoise, position, size, yMin, yMax));
+	Chunk::ApplyTreeBlocks(blocks, position, TreeTrunkPositions, TreeLeavePositions);
+	result.hasJournalEdits = LoadSavedBlocks(Chunk::GetKey(position, size), blocks);
+
+	FinishChunkResult(result);
+	return result;
+}
+
+void World::FinishChunkResult(ChunkResult& result)
+{
+	ChunkState& state = *result.state;
+	Chunk::GenerateMeshData(state.blocks, numTextureCols_, result.vertices, result.indices, result.passIndexCounts);
+
+	// Written straight into mapped GPU memory, so the upload on the main thread is only a copy command
+	result.isStaged = chunkRenderer_->GetArena()->GetStagingBuffer()->Write(result.vertices, result.indices, result.stagedMesh);
+	Chunk::GenerateVisibility(state);
+}
+
+void World::PushChunkResult(ChunkResult&& result)
+{
+	result.completedTime = glfwGetTime();
+
+	while (!completedChunks_->TryPush(std::move(result)))
+	{
+		std::this_thread::yield();
+	}
+}
+
+void World::ApplyCompletedChunks()
+{
+	ChunkResult result;
+	while (completedChunks_->TryPop(result))
+	{
+		if (!result.chunk->ApplyResult(result))
+		{
+			if (result.isStaged)
+			{
+				chunkRenderer_->GetArena()->GetStagingBuffer()->Release(result.stagedMesh);
+			}
+
+			handoffStats_.numResultsDropped++;
+			continue;
+		}
+
+		double latency = glfwGetTime() - result.completedTime;
+		handoffStats_.averageLatency += (latency - handoffStats_.averageLatency) / (handoffStats_.numResultsApplied + 1);
+		handoffStats_.longestLatency = glm::max(handoffStats_.longestLatency, latency);
+		handoffStats_.numResultsApplied++;
+		haveOccludersChanged_ = true;
+		haveChunksMoved_ = true;
+		haveChunkKeysChanged_ = true;
+	}
+}
+
+ChunkHandoffStats World::GetHandoffStats()
+{
+	return handoffStats_;
+}
+
+void World::UploadChunkMeshes(glm::vec3 cameraPos)
+{
+	for (Chunk* chunk : chunks_)
+	{
+		Mesh* mesh = static_cast<MeshComponent*>(chunk->GetComponentByName("mesh"))->GetMesh();
+
+		if (!chunk->IsUnloaded() && mesh->NeedsUpload())
+		{
+			uploadScheduler_->Add(mesh, glm::distance(chunk->GetTransformComponent()->GetTranslation(), cameraPos));
+		}
+	}
+
+	uploadScheduler_->Upload();
+}
+
+UploadScheduler* World::GetUploadScheduler()
+{
+	return uploadScheduler_;
+}
+
+void World::DrawChunks(glm::vec3 cameraPos)
+{
+	chunkRenderer_->Draw(chunks_, visibleChunks_, texture_, cameraPos);
+
+	// Fences this frame's copies out of the staging buffer
+	chunkRenderer_->GetArena()->GetStagingBuffer()->EndFrame();
+}
+
+ChunkRenderer* World::GetChunkRenderer()
+{
+	return chunkRenderer_;
+}
+
+EpochReclaimer* World::GetEpochReclaimer()
+{
+	return reclaimer_;
+}
+
+bool World::IsMainThread()
+{
+	return std::this_thread::get_id() == mainThreadId_;
+}
+
+size_t World::GetNumEdits(ChunkKey chunkKey)
+{
+	std::lock_guard<std::mutex> lock(chunkEditsMutex_);
+	auto edits = chunkEdits_.find(chunkKey);
+	return edits != chunkEdits_.end() ? edits->second.size() : 0;
+}
+
+void World::CompactEditJournal(const std::vector<SavedChunk>& savedChunks)
+{
+	std::lock_guard<std::mutex> lock(chunkEditsMutex_);
+
+	// Edits only ever go on the end, so the ones made after a snapshot was
+	// taken are the ones past its count and still need keeping
+	size_t numEditsSaved = 0;
+	for (const SavedChunk& savedChunk : savedChunks)
+	{
+		auto edits = chunkEdits_.find(savedChunk.chunkKey);
+		if (edits == chunkEdits_.end() || savedChunk.numEdits == 0)
+		{
+			continue;
+		}
+
+		size_t numEdits = std::min(savedChunk.numEdits, edits->second.size());
+		edits->second.erase(edits->second.begin(), edits->second.begin() + numEdits);
+		if (edits->second.empty())
+		{
+			chunkEdits_.erase(edits);
+		}
+		numEditsSaved += numEdits;
+	}
+
+	if (numEditsSaved == 0)
+	{
+		return;
+	}
+
+	std::vector<EditRecord> remainingRecords = std::vector<EditRecord>();
+	for (const auto& edits : chunkEdits_)
+	{
+		remainingRecords.insert(remainingRecords.end(), edits.second.begin(), edits.second.end());
+	}
+
+	LOG("Compacted %zu edits into chunk saves, %zu edits left\n", numEditsSaved, remainingRecords.size());
+
+	// Queued under the lock, so no edit can be appended in between and lost
+	editJournal_->Rewrite(std::move(remainingRecords));
+}
+
+AutosaveStats World::GetAutosaveStats()
+{
+	return autosave_->GetStats();
 }
\ No newline at end of file
@@ -1,19 +1,55 @@
 #pragma once
+#include <atomic>
+#include <functional>
 #include <future>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <glm/vec3.hpp>
 #include <FastNoise/FastNoise.h>
 
+#include "autosave.h"
 #include "chunk.h"
+#include "chunkLayout.h"
+#include "chunkQuadtree.h"
+#include "chunkRenderer.h"
+#include "chunkStore.h"
+#include "editJournal.h"
 #include "entity.h"
-#include "worker.h"
+#include "epochReclaimer.h"
+#include "jobSystem.h"
+#include "mpscQueue.h"
+#include "occlusionCuller.h"
+#include "uploadScheduler.h"
 
 #include "frustum.h"
 #include "terrain.h"
 
-struct ChunkNoiseSection
+struct ChunkHandoffStats
 {
-	glm::vec3 position; // Y should always be zero here
-	std::vector<float> noise;
+	uint64_t numResultsApplied;
+	uint64_t numResultsDropped; // Out of date by the time they were applied
+
+	// How long results waited in the queue for the main thread (seconds)
+	double averageLatency;
+	double longestLatency;
+};
+
+// A chunk captured on the main thread to be handed to the streaming jobs
+struct StreamingChunk
+{
+	Chunk* chunk;
+	uint32_t chunkVersion;
+	glm::vec3 position;
+	Biome biome;
+	ChunkBlocks blocks; // Empty for chunks that are being recreated
+};
+
+struct WorldStartupStats
+{
+	double timeToFirstFrame; // seconds
+	double timeToFullRenderDistance; // seconds
+	bool hasFinished;
 };
 
 class World
@@ -27,24 +63,135 @@ class World
 
 	int seed_;
 	int renderDistance_;
-	WorldWorker* worldWorker_;
+	JobSystem* jobSystem_;
+	JobCounter streamingCounter_;
+
+	// Jobs never touch the chunks that are being drawn, they push what they
+	// generated here and the main thread swaps it in at the start of Update
+	MpscQueue<ChunkResult>* completedChunks_;
+	ChunkHandoffStats handoffStats_;
+	int numTextureCols_;
+
+	UploadScheduler* uploadScheduler_;
+
+	// Frees chunk states once no thread is reading them, collected every Update
+	EpochReclaimer* reclaimer_;
+
+	Texture2DArray texture_;
+	ChunkRenderer* chunkRenderer_;
+
+	// Indices into chunks_ of the chunks that survived culling. Chunks
+	// never move in chunks_, they're reused.
+	std::vector<int> visibleChunks_;
+
+	// Built over chunks_, rebuilt when chunks have moved
+	ChunkQuadtree* chunkQuadtree_;
+	bool haveChunksMoved_;
+
+	// Loaded chunks by key for the collision queries, rebuilt when chunks have moved
+	std::unordered_map<ChunkKey, Chunk*, ChunkKeyHash> chunksByKey_;
+	bool haveChunkKeysChanged_;
+	std::vector<uint8_t> isChunkOccluded_; // by index in chunks_, for the last occlusion cull
+
+	// Hides chunks that can't be seen through open space from the camera's chunk
+	ChunkVisibilityGraph* visibilityGraph_;
+	int numUnreachableChunks_; // for the last cull
+	double visibilityCullTime_; // seconds, for the last cull
+
+	// Hides chunks behind the nearest chunks' solid blocks, after frustum culling
+	OcclusionCuller* occlusionCuller_;
+	int maxOccluderChunks_ = 128;
+	bool haveOccludersChanged_;
+	double occlusionCullTime_; // seconds, for the last cull
 	std::mutex loadingChunksMutex_;
 	std::mutex generatingNoiseMutex_;
+	std::thread::id mainThreadId_;
 
-	int yMin = -1; // num. chunks
-	int yMax = 2; // num. chunks (i.e. max - min would be the number of chunks high)
+	std::string saveDirectory_;
+	ChunkStore* chunkStore_;
+	EditJournal* editJournal_;
+	Autosave* autosave_;
+	double autosaveInterval_ = 30.0; // seconds
+
+	// Edits from the journal that haven't been compacted into a chunk save yet
+	std::unordered_map<ChunkKey, std::vector<EditRecord>, ChunkKeyHash> chunkEdits_;
+	std::mutex chunkEditsMutex_;
+
+	int yMin = MIN_CHUNK_Y; // num. chunks
+	int yMax = MAX_CHUNK_Y; // num. chunks (i.e. max - min would be the number of chunks high)
+
+	// The chunks this close to the player are generated before the first
+	// frame, the rest of the render distance streams in afterwards.
+	int spawnDistance_ = 1; // num. chunks
+
+	double startupStartTime_;
+	double timeToFirstFrame_;
+	double timeToFullRenderDistance_;
+	bool hasDrawnFirstFrame_;
+	bool hasFinishedStartup_;
+	JobCounter startupCounter_;
 protected:
 	static Biome GetBiomeFromTemperature(float temperature);
+
+	// Loads the seed from the save, or picks a new one for a new save
+	int LoadOrCreateSeed();
+
+	void RecordEdit(Chunk* chunk, glm::vec3 localBlockPos, uint8_t blockType);
+
+	/*
+	 * Generates a chunk's blocks, mesh and visibility at a position without
+	 * touching the chunk itself, so this can run on any thread.
+	 */
+	ChunkResult GenerateChunkResult(Chunk* chunk, uint32_t chunkVersion, glm::vec3 position, Biome biome, const std::vector<float>& chunkSectionNoise);
+
+	// Generates the mesh and visibility for the result's blocks
+	void FinishChunkResult(ChunkResult& result);
+
+	// Waits for space in the queue if the main thread has fallen behind
+	void PushChunkResult(ChunkResult&& result);
+
+	// Swaps in every result in the queue, only call this on the main thread
+	void ApplyCompletedChunks();
 public:
 	std::vector<glm::vec3> TreeTrunkPositions;
 	std::vector<glm::vec3> TreeLeavePositions;
 	World(glm::vec3 currentPlayerPos, int renderDistance);
+	~World();
 
 	void Update(glm::vec3 currentPlayerPos);
+
+	// Call after each frame is drawn, for the startup stats
+	void MarkFrameDrawn();
+	WorldStartupStats GetStartupStats();
 	std::vector<Chunk*> GetWorld();
 
-	// TODO: Have a second Worker with multiple internal threads that recreates multiple chunks at once
-	bool LoadNewChunksAsync(int startX, int endX, int startZ, int endZ, std::vector<glm::vec3> loadedChunkPositions, std::vector<Chunk*> chunkIndexes);
+	// Runs on the job system, one job per chunk column and per chunk
+	bool LoadNewChunksAsync(int startX, int endX, int startZ, int endZ, std::vector<StreamingChunk> loadedChunks, std::vector<StreamingChunk> unloadedChunks);
+
+	/*
+	 * Generates the chunks around the origin on job systems with 1 up to
+	 * one thread per core and prints the throughput of each, to show how
+	 * chunk streaming scales. Returns false if the results differ.
+	 */
+	static bool RunStreamingBenchmark(int seed, int renderDistance);
+
+	/*
+	 * Runs frames of streaming, culling, uploading and drawing on a
+	 * NullRenderDevice while the camera flies along x, so no window or GPU
+	 * is needed. Prints the CPU time and what each frame asked of the GPU.
+	 * Uses the save in ./Saves/World like the game does. Returns false if
+	 * nothing was drawn.
+	 */
+	static bool RunFrameBenchmark(int renderDistance, int numFrames);
+
+	/*
+	 * Generates the chunks around the origin and tests random player sized
+	 * boxes against them, once with a collision box per solid block like
+	 * the chunks used to keep and once with Chunk::FindSolidBlock. Prints
+	 * the time per query and the memory the boxes took. Returns false if
+	 * the two disagree.
+	 */
+	static bool RunCollisionBenchmark(int seed, int renderDistance);
 
 	// Finds the closest position that's a multiple of the passed
 	// parameter, i.e. closest x pos for a multiple of 16
@@ -54,16 +201,88 @@ public:
 
 	std::vector<float> GetNoiseForChunkSection(int x, int z, int size);
 
+	/*
+	 * Starts the culling for a frame, the chunks that are at least partly
+	 * inside the frustum become the visible chunks. The other culls only
+	 * ever remove chunks from them.
+	 */
 	void FrustumCullChunks(const Frustum& frustum);
 	int NumChunksCulled();
+	ChunkQuadtreeStats GetQuadtreeStats();
+
+	// Indices into GetWorld()
+	const std::vector<int>& GetVisibleChunks();
+
+	/*
+	 * Stops drawing chunks that can't be reached from the camera's chunk
+	 * through open space, see ChunkVisibilityGraph. Call right after
+	 * FrustumCullChunks.
+	 */
+	void VisibilityCullChunks(glm::vec3 cameraPos);
+	int GetNumUnreachableChunks();
+	double GetVisibilityCullTime();
+
+	/*
+	 * Stops drawing chunks that are hidden behind the nearest chunks, call
+	 * after the other culling. The quadtree nodes that were in the frustum
+	 * are tested, so groups of columns can be hidden with one test.
+	 */
+	void OcclusionCullChunks(const glm::mat4& viewProjection, glm::vec3 cameraPos);
+
+	// True when chunks have been swapped in or edited since the last occlusion cull
+	bool HaveOccludersChanged();
+	OcclusionStats GetOcclusionStats();
+	double GetOcclusionCullTime();
 
 	std::vector<Chunk*> GetChunksInsideArea(glm::vec3 origin, glm::vec3 size);
 
+	/*
+	 * Tests the box against the blocks it overlaps, found straight from
+	 * the chunks' blocks, so it only costs as much as the box is big.
+	 * Touching a block counts, like CollisionDetection::isOverlapping.
+	 * The hit box is the block's. Only call this on the main thread.
+	 */
 	bool IsCollidingWithWorld(CollisionDetection::CollisionBox collisionBox, CollisionDetection::CollisionBox& hitBoxOut);
 	bool PerformRaycast(CollisionDetection::RaycastHit& hitOut, glm::vec3 hitStart, glm::vec3 direction, float distance, float stepColliderSize, int numSteps);
 
     void PlaceBlock(glm::vec3 worldLocation, uint8_t blockType);
     void BreakBlock(glm::vec3 worldLocation);
 
+	/*
+	 * Replaces a freshly generated chunk's blocks with its save (if it has one)
+	 * and then applies any edits from the journal. Returns true if there were
+	 * edits, i.e. the blocks differ from the save. Can be called from any thread.
+	 */
+	bool LoadSavedBlocks(ChunkKey chunkKey, ChunkBlocks& blocks);
+
+	// How many journal edits the chunk has, for the autosave's snapshots
+	size_t GetNumEdits(ChunkKey chunkKey);
+
+	/*
+	 * Drops the edits the autosave has just written into chunk saves, then
+	 * queues a rewrite of the journal with the rest. Runs on the autosave
+	 * thread and never waits on the disk.
+	 */
+	void CompactEditJournal(const std::vector<SavedChunk>& savedChunks);
+
+	AutosaveStats GetAutosaveStats();
+	ChunkHandoffStats GetHandoffStats();
+
+	/*
+	 * Uploads the chunk meshes that have changed, nearest to the camera
+	 * first, within the upload budget. Call once per frame before drawing.
+	 */
+	void UploadChunkMeshes(glm::vec3 cameraPos);
+	UploadScheduler* GetUploadScheduler();
+
+	// Draws every visible chunk, call between Mesh::StartDrawBatch and EndDrawBatch
+	void DrawChunks(glm::vec3 cameraPos);
+	ChunkRenderer* GetChunkRenderer();
+
+	EpochReclaimer* GetEpochReclaimer();
+
+	// Whether this is the thread the world was created on, which is the only one that publishes chunk states
+	bool IsMainThread();
+
 	std::vector<Chunk*>& GetChunks();
 };